@@ -0,0 +1,38 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark_support.hpp"
+
+#include <cstdlib>
+
+namespace openarm::benchmarks {
+
+std::string benchmark_interface() {
+    const char* interface = std::getenv("OPENARM_CAN_BENCHMARK_INTERFACE");
+    return interface ? interface : "vcan0";
+}
+
+std::unique_ptr<canbus::CANSocket> open_benchmark_socket(benchmark::State& state,
+                                                         bool enable_fd) {
+    try {
+        return std::make_unique<canbus::CANSocket>(benchmark_interface(), enable_fd);
+    } catch (const canbus::CANSocketException&) {
+        state.SkipWithError(("no CAN interface " + benchmark_interface() +
+                             " (set OPENARM_CAN_BENCHMARK_INTERFACE)")
+                                .c_str());
+        return nullptr;
+    }
+}
+
+}  // namespace openarm::benchmarks
@@ -0,0 +1,54 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <openarm/canbus/can_socket.hpp>
+
+#include "allocation_counter.hpp"
+
+namespace openarm::benchmarks {
+
+using test::allocation_count;
+
+// Reports allocations/op for the benchmark it is created in
+class AllocationScope {
+public:
+    explicit AllocationScope(benchmark::State& state)
+        : state_(state), start_(allocation_count()) {}
+    ~AllocationScope() {
+        state_.counters["allocs/op"] = benchmark::Counter(
+            static_cast<double>(allocation_count() - start_), benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State& state_;
+    uint64_t start_;
+};
+
+// CAN interface used by benchmarks that need a socket, OPENARM_CAN_BENCHMARK_INTERFACE
+// (default: vcan0)
+std::string benchmark_interface();
+
+// Open a socket on benchmark_interface(), or skip the benchmark if that fails
+std::unique_ptr<canbus::CANSocket> open_benchmark_socket(benchmark::State& state,
+                                                         bool enable_fd = false);
+
+}  // namespace openarm::benchmarks
@@ -0,0 +1,97 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Encode and decode paths of the Damiao protocol. These don't need a CAN interface.
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <openarm/damiao_motor/dm_motor.hpp>
+#include <openarm/damiao_motor/dm_motor_control.hpp>
+#include <vector>
+
+#include "benchmark_support.hpp"
+
+namespace {
+
+using openarm::benchmarks::AllocationScope;
+using namespace openarm::damiao_motor;
+
+const MITParam kMITParam = {30.0, 1.0, 0.5, -0.25, 1.5};
+const std::array<uint8_t, 8> kStatePayload = {0x11, 0x84, 0x31, 0x7f, 0xe8, 0x12, 0x28, 0x2a};
+
+void BM_CreateMITControlCommand(benchmark::State& state) {
+    Motor motor(MotorType::DM4310, 0x01, 0x11);
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        CANPacket packet = CanPacketEncoder::create_mit_control_command(motor, kMITParam);
+        benchmark::DoNotOptimize(packet);
+    }
+}
+BENCHMARK(BM_CreateMITControlCommand);
+
+void BM_EncodeMITControlCommand(benchmark::State& state) {
+    Motor motor(MotorType::DM4310, 0x01, 0x11);
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        FixedCANPacket packet = CanPacketEncoder::encode_mit_control_command(motor, kMITParam);
+        benchmark::DoNotOptimize(packet);
+    }
+}
+BENCHMARK(BM_EncodeMITControlCommand);
+
+void BM_EncodeMITControlCommandStatic(benchmark::State& state) {
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        FixedCANPacket packet =
+            CanPacketEncoder::encode_mit_control_command<MotorType::DM4310>(0x01, kMITParam);
+        benchmark::DoNotOptimize(packet);
+    }
+}
+BENCHMARK(BM_EncodeMITControlCommandStatic);
+
+void BM_ParseMotorStateDataVector(benchmark::State& state) {
+    Motor motor(MotorType::DM4310, 0x01, 0x11);
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        // The vector overload needs a vector, as the old frame callback built one per frame
+        std::vector<uint8_t> data(kStatePayload.begin(), kStatePayload.end());
+        StateResult result = CanPacketDecoder::parse_motor_state_data(motor, data);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_ParseMotorStateDataVector);
+
+void BM_ParseMotorStateData(benchmark::State& state) {
+    Motor motor(MotorType::DM4310, 0x01, 0x11);
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        StateResult result = CanPacketDecoder::parse_motor_state_data(
+            motor, kStatePayload.data(), kStatePayload.size());
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_ParseMotorStateData);
+
+void BM_ParseMotorStateDataStatic(benchmark::State& state) {
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        StateResult result = CanPacketDecoder::parse_motor_state_data<MotorType::DM4310>(
+            kStatePayload.data(), kStatePayload.size());
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_ParseMotorStateDataStatic);
+
+}  // namespace
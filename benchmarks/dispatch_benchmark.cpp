@@ -0,0 +1,112 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Frame dispatch and device collection paths. The collections need a CANSocket but these
+// benchmarks never send or receive through it.
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <memory>
+#include <openarm/canbus/can_device_collection.hpp>
+#include <openarm/damiao_motor/dm_motor.hpp>
+#include <openarm/damiao_motor/dm_motor_device.hpp>
+#include <openarm/damiao_motor/dm_motor_device_collection.hpp>
+#include <vector>
+
+#include "benchmark_support.hpp"
+
+namespace {
+
+using openarm::benchmarks::AllocationScope;
+using openarm::benchmarks::open_benchmark_socket;
+using namespace openarm::damiao_motor;
+
+constexpr uint32_t kRecvCanIdBase = 0x11;
+
+struct DispatchFixture {
+    explicit DispatchFixture(openarm::canbus::CANSocket& socket, size_t count)
+        : collection(socket) {
+        motors.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            motors.emplace_back(MotorType::DM4310, 0x01 + i, kRecvCanIdBase + i);
+        }
+        for (auto& motor : motors) {
+            auto device = std::make_shared<DMCANDevice>(motor, CAN_SFF_MASK, false);
+            device->set_callback_mode(STATE);
+            collection.add_device(device);
+        }
+    }
+
+    std::vector<Motor> motors;
+    DMDeviceCollection collection;
+};
+
+can_frame make_state_frame(canid_t can_id) {
+    const uint8_t payload[8] = {0x11, 0x84, 0x31, 0x7f, 0xe8, 0x12, 0x28, 0x2a};
+    can_frame frame{};
+    frame.can_id = can_id;
+    frame.can_dlc = sizeof(payload);
+    std::memcpy(frame.data, payload, sizeof(payload));
+    return frame;
+}
+
+// Route one state frame per device through the collection, including the state decode
+void BM_DispatchFrameCallback(benchmark::State& state) {
+    auto socket = open_benchmark_socket(state);
+    if (!socket) return;
+    const size_t count = static_cast<size_t>(state.range(0));
+    DispatchFixture fixture(*socket, count);
+    std::vector<can_frame> frames;
+    for (size_t i = 0; i < count; i++) frames.push_back(make_state_frame(kRecvCanIdBase + i));
+
+    auto& collection = fixture.collection.get_device_collection();
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        for (auto& frame : frames) {
+            benchmark::DoNotOptimize(collection.dispatch_frame_callback(frame));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_DispatchFrameCallback)->Arg(8)->Arg(16)->Arg(64);
+
+// Frames for ids no device listens on are dropped after the lookup
+void BM_DispatchFrameCallbackMiss(benchmark::State& state) {
+    auto socket = open_benchmark_socket(state);
+    if (!socket) return;
+    DispatchFixture fixture(*socket, 8);
+    can_frame frame = make_state_frame(0x7ff);
+
+    auto& collection = fixture.collection.get_device_collection();
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(collection.dispatch_frame_callback(frame));
+    }
+}
+BENCHMARK(BM_DispatchFrameCallbackMiss);
+
+void BM_GetDMDevices(benchmark::State& state) {
+    auto socket = open_benchmark_socket(state);
+    if (!socket) return;
+    DispatchFixture fixture(*socket, static_cast<size_t>(state.range(0)));
+
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.collection.get_dm_devices().data());
+    }
+}
+BENCHMARK(BM_GetDMDevices)->Arg(8)->Arg(64);
+
+}  // namespace
@@ -0,0 +1,150 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Syscall paths and the full control loop on a (virtual) CAN interface:
+//
+//   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <openarm/can/socket/openarm.hpp>
+#include <openarm/damiao_motor/dm_motor_constants.hpp>
+#include <thread>
+#include <vector>
+
+#include "benchmark_support.hpp"
+
+namespace {
+
+using openarm::benchmarks::AllocationScope;
+using openarm::benchmarks::benchmark_interface;
+using openarm::benchmarks::open_benchmark_socket;
+using openarm::canbus::CANSocket;
+using openarm::canbus::CANSocketException;
+
+constexpr uint32_t kSendCanIdBase = 0x01;
+constexpr uint32_t kRecvCanIdBase = 0x11;
+constexpr size_t kArmMotorCount = 7;
+
+std::vector<can_frame> make_frames(size_t count) {
+    std::vector<can_frame> frames(count);
+    for (size_t i = 0; i < count; i++) {
+        frames[i].can_id = kSendCanIdBase + i;
+        frames[i].can_dlc = 8;
+    }
+    return frames;
+}
+
+// One write() per frame
+void BM_WriteCANFrame(benchmark::State& state) {
+    auto socket = open_benchmark_socket(state);
+    if (!socket) return;
+    auto frames = make_frames(static_cast<size_t>(state.range(0)));
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        for (const auto& frame : frames) socket->write_can_frame(frame);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WriteCANFrame)->Arg(8)->Arg(16);
+
+// One sendmmsg() for all frames
+void BM_WriteCANFrames(benchmark::State& state) {
+    auto socket = open_benchmark_socket(state);
+    if (!socket) return;
+    auto frames = make_frames(static_cast<size_t>(state.range(0)));
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(socket->write_can_frames(frames.data(), frames.size()));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WriteCANFrames)->Arg(8)->Arg(16);
+
+// Stands in for the motors: answers every command frame with a state frame
+class MotorResponder {
+public:
+    explicit MotorResponder(const std::string& interface)
+        : socket_(interface), thread_([this] { run(); }) {}
+    ~MotorResponder() {
+        running_ = false;
+        thread_.join();
+    }
+
+private:
+    void run() {
+        std::vector<can_frame> commands(64), replies(64);
+        while (running_) {
+            if (!socket_.is_data_available(1000)) continue;
+            size_t count = socket_.read_can_frames(commands.data(), commands.size());
+            size_t reply_count = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (commands[i].can_id >= kRecvCanIdBase) continue;
+                can_frame& reply = replies[reply_count++];
+                reply = commands[i];
+                reply.can_id = commands[i].can_id - kSendCanIdBase + kRecvCanIdBase;
+                reply.data[0] = static_cast<uint8_t>(reply.can_id);
+            }
+            socket_.write_can_frames(replies.data(), reply_count);
+        }
+    }
+
+    CANSocket socket_;
+    std::atomic<bool> running_{true};
+    std::thread thread_;
+};
+
+// mit_control_all() followed by recv_all() for a 7 DoF arm, i.e. one control cycle
+void BM_MITControlCycle(benchmark::State& state) {
+    using namespace openarm::damiao_motor;
+    std::unique_ptr<openarm::can::socket::OpenArm> openarm;
+    std::unique_ptr<MotorResponder> responder;
+    try {
+        openarm = std::make_unique<openarm::can::socket::OpenArm>(benchmark_interface());
+        responder = std::make_unique<MotorResponder>(benchmark_interface());
+    } catch (const CANSocketException&) {
+        state.SkipWithError(("no CAN interface " + benchmark_interface() +
+                             " (set OPENARM_CAN_BENCHMARK_INTERFACE)")
+                                .c_str());
+        return;
+    }
+
+    std::vector<MotorType> motor_types = {MotorType::DM8009, MotorType::DM8009,
+                                          MotorType::DM4340, MotorType::DM4340,
+                                          MotorType::DM4310, MotorType::DM4310,
+                                          MotorType::DM4310};
+    std::vector<uint32_t> send_can_ids, recv_can_ids;
+    for (size_t i = 0; i < kArmMotorCount; i++) {
+        send_can_ids.push_back(kSendCanIdBase + i);
+        recv_can_ids.push_back(kRecvCanIdBase + i);
+    }
+    openarm->init_arm_motors(motor_types, send_can_ids, recv_can_ids);
+    openarm->set_callback_mode_all(STATE);
+    std::vector<MITParam> mit_params(kArmMotorCount, MITParam{10.0, 0.5, 0.0, 0.0, 0.0});
+
+    size_t timeouts = 0;
+    AllocationScope allocations(state);
+    for (auto _ : state) {
+        openarm->get_arm().mit_control_all(mit_params);
+        openarm->recv_all(static_cast<int>(state.range(0)));
+        if (openarm->has_pending_replies()) timeouts++;
+    }
+    state.counters["timeouts"] = static_cast<double>(timeouts);
+}
+BENCHMARK(BM_MITControlCycle)->Arg(1000)->UseRealTime();
+
+}  // namespace
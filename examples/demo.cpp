@@ -16,9 +16,9 @@
 #include <chrono>
 #include <csignal>
 #include <iostream>
+#include <openarm/can/socket/control_loop.hpp>
 #include <openarm/can/socket/openarm.hpp>
 #include <openarm/damiao_motor/dm_motor_constants.hpp>
-#include <thread>
 
 int main() {
     try {
@@ -49,13 +49,9 @@ int main() {
         // Allow time (2ms) for the motors to respond for slow operations like enabling
         openarm.recv_all(2000);
 
-        // Set device mode to param and query motor id
+        // Query motor id, state frames keep decoding in the meantime
         std::cout << "\n=== Querying Motor Recv IDs ===" << std::endl;
-        openarm.set_callback_mode_all(openarm::damiao_motor::CallbackMode::PARAM);
-        openarm.query_param_all(static_cast<int>(openarm::damiao_motor::RID::MST_ID));
-        // Allow time (2ms) for the motors to respond for slow operations like querying
-        // parameter from register
-        openarm.recv_all(2000);
+        openarm.load_params_all({static_cast<int>(openarm::damiao_motor::RID::MST_ID)});
 
         // Access motors through components
         for (const auto& motor : openarm.get_arm().get_motors()) {
@@ -88,23 +84,28 @@ int main() {
         openarm.get_gripper().close();
         openarm.recv_all(1000);
 
-        for (int i = 0; i < 10; i++) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-            openarm.refresh_all();
-            openarm.recv_all(300);
-
-            // Display arm motor states
-            for (const auto& motor : openarm.get_arm().get_motors()) {
-                std::cout << "Arm Motor: " << motor.get_send_can_id()
-                          << " position: " << motor.get_position() << std::endl;
+        // Refresh and display the states at a fixed 10 Hz. ControlLoop sends the refresh
+        // queued in a tick at the start of the next one and waits for the replies.
+        openarm::can::socket::ControlLoopConfig loop_config;
+        loop_config.period = std::chrono::milliseconds(100);
+        loop_config.rx_timeout = std::chrono::microseconds(300);
+        openarm::can::socket::ControlLoop loop(openarm, loop_config);
+        loop.run([&](const openarm::can::socket::ControlTick& tick) {
+            if (tick.index > 0) {
+                // Display arm motor states
+                for (const auto& motor : openarm.get_arm().get_motors()) {
+                    std::cout << "Arm Motor: " << motor.get_send_can_id()
+                              << " position: " << motor.get_position() << std::endl;
+                }
+                // Display gripper state
+                for (const auto& motor : openarm.get_gripper().get_motors()) {
+                    std::cout << "Gripper Motor: " << motor.get_send_can_id()
+                              << " position: " << motor.get_position() << std::endl;
+                }
             }
-            // Display gripper state
-            for (const auto& motor : openarm.get_gripper().get_motors()) {
-                std::cout << "Gripper Motor: " << motor.get_send_can_id()
-                          << " position: " << motor.get_position() << std::endl;
-            }
-        }
+            openarm.refresh_all();
+            return tick.index < 10;
+        });
 
         openarm.disable_all();
         openarm.recv_all(1000);
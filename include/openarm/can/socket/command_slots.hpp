@@ -0,0 +1,116 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../../damiao_motor/dm_motor_control.hpp"
+#include "openarm.hpp"
+
+namespace openarm::can::socket {
+
+// Thread-safe command submission for several controllers sharing one OpenArm, e.g. an arm
+// policy, a gripper controller and a safety monitor on their own threads. Producers only
+// write the latest setpoint of a joint into its slot. A single bus-owner thread merges the
+// slots and sends them as one batch per tick, so the bus never sees a partial tick and the
+// producers never touch the CAN socket.
+//
+//   CommandSlots slots(openarm);
+//   // any thread
+//   slots.set_mit(2, {kp, kd, q, dq, tau});
+//   slots.set_mit(slots.gripper_joint(), openarm.get_gripper().position_command(1.0));
+//   // bus-owner thread, once per tick
+//   slots.cycle();
+//
+// Every slot is a seqlock. Producers writing different joints never wait for each other,
+// two producers writing the same joint take turns for the few stores a write takes, and
+// the bus owner never blocks a producer. A producer that commands several joints at once
+// (set_mit_all(), set_posvel_all()) publishes them through a group seqlock on top, so a
+// tick carries all of that write or none of it. Joints are numbered like OpenArm::cycle(): the
+// arm motors first, then the gripper. Construct after the motors were initialized.
+class CommandSlots {
+public:
+    explicit CommandSlots(OpenArm& openarm);
+
+    CommandSlots(const CommandSlots&) = delete;
+    CommandSlots& operator=(const CommandSlots&) = delete;
+
+    size_t size() const { return size_; }
+    size_t gripper_joint(size_t i = 0) const { return arm_joints_ + i; }
+
+    // Producer side, safe from any thread. The setpoint is sent every tick until it is
+    // replaced or cleared.
+    void set_mit(size_t joint, const damiao_motor::MITParam& mit_param);
+    void set_posvel(size_t joint, const damiao_motor::PosVelParam& posvel_param);
+    // Setpoints of joints first .. first + count - 1, published together
+    void set_mit_all(const damiao_motor::MITParam* mit_params, size_t count, size_t first = 0);
+    void set_mit_all(const std::vector<damiao_motor::MITParam>& mit_params, size_t first = 0) {
+        set_mit_all(mit_params.data(), mit_params.size(), first);
+    }
+    void set_posvel_all(const damiao_motor::PosVelParam* posvel_params, size_t count,
+                        size_t first = 0);
+    void set_posvel_all(const std::vector<damiao_motor::PosVelParam>& posvel_params,
+                        size_t first = 0) {
+        set_posvel_all(posvel_params.data(), posvel_params.size(), first);
+    }
+    // Stop commanding the joint, it is only refreshed from then on
+    void clear(size_t joint);
+    void clear_all();
+    // Number of setpoints written to the joint so far
+    uint64_t get_updates(size_t joint) const;
+
+    // Bus-owner side, one thread at a time. send() takes one snapshot of all slots and
+    // queues it with OpenArm::send_cycle() (from a ControlLoop callback, for example),
+    // cycle() also waits for the replies like OpenArm::cycle().
+    CycleResult send(const CycleConfig& config = CycleConfig());
+    CycleResult cycle(const CycleConfig& config = CycleConfig());
+
+private:
+    enum class SetpointKind : uint8_t { NONE, MIT, POS_VEL };
+    struct Setpoint {
+        SetpointKind kind = SetpointKind::NONE;
+        damiao_motor::MITParam mit{};
+        damiao_motor::PosVelParam posvel{};
+    };
+    // One cache line per slot so producers of neighbouring joints don't false-share
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> seq{0};
+        Setpoint setpoint;
+    };
+
+    void check_joint(size_t joint) const;
+    void check_joints(size_t first, size_t count) const;
+    void write(size_t joint, const Setpoint& setpoint);
+    // setpoint_at(k) is the setpoint of joint first + k
+    template <typename SetpointAt>
+    void write_group(size_t first, size_t count, const SetpointAt& setpoint_at);
+    Setpoint read(size_t joint) const;
+    void read_snapshot();
+
+    OpenArm& openarm_;
+    size_t arm_joints_;
+    size_t size_;
+    std::unique_ptr<Slot[]> slots_;
+    // Odd while a group write is in progress, group writers exclude each other with it
+    alignas(64) std::atomic<uint32_t> group_seq_{0};
+    // Bus owner only, filled by read_snapshot()
+    std::unique_ptr<Setpoint[]> snapshot_;
+};
+
+}  // namespace openarm::can::socket
@@ -0,0 +1,113 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "../../canbus/latency_histogram.hpp"
+#include "../../damiao_motor/dm_joint_state.hpp"
+#include "openarm.hpp"
+#include "realtime.hpp"
+
+namespace openarm::can::socket {
+
+struct ControlLoopConfig {
+    std::chrono::nanoseconds period = std::chrono::milliseconds(1);
+    // Upper bound for the RX stage of a tick, counted from the tick start
+    std::chrono::nanoseconds rx_timeout = std::chrono::microseconds(500);
+    // Applied to the thread calling run()
+    ThreadConfig thread;
+    // mlockall() before the first tick
+    bool lock_memory = false;
+};
+
+// Passed to the callback once per tick
+struct ControlTick {
+    uint64_t index;
+    // steady_clock times in ns
+    int64_t scheduled_ns;
+    int64_t wakeup_ns;
+    // recv_can_ids of the motors that did not reply to the previous tick's commands
+    std::vector<uint32_t> timed_out;
+};
+
+struct ControlLoopStats {
+    uint64_t ticks = 0;
+    // ticks whose work did not finish before the next tick was due
+    uint64_t overruns = 0;
+    // ticks skipped to get back in phase after overruns
+    uint64_t missed_ticks = 0;
+    // replies that did not arrive within rx_timeout
+    uint64_t rx_timeouts = 0;
+    // how late each tick woke up
+    canbus::HistogramSnapshot wakeup_latency;
+    // time from wake-up until the callback returned
+    canbus::HistogramSnapshot tick_duration;
+};
+
+// Runs a callback at a fixed rate on an absolute clock_nanosleep() schedule, so the loop
+// neither drifts nor accumulates jitter. Every tick runs the same stages in order:
+//
+//   1. TX: send the commands the callback queued on the previous tick, in one batch
+//   2. RX: wait for their replies, at most rx_timeout after the tick start
+//   3. publish: copy the decoded state into get_arm_state()/get_gripper_state()
+//   4. compute: the callback, which queues the next commands
+//
+// Commands issued from the callback (mit_control_all(), refresh_all(), ...) are held
+// back until stage 1 of the next tick, which keeps their phase relative to the tick
+// fixed no matter how long the callback takes.
+class ControlLoop {
+public:
+    // Return false to stop the loop
+    using Callback = std::function<bool(const ControlTick& tick)>;
+
+    explicit ControlLoop(OpenArm& openarm, const ControlLoopConfig& config = ControlLoopConfig());
+
+    // Runs on the calling thread until the callback returns false or stop() is called
+    void run(const Callback& callback);
+    // Safe to call from any thread, including the callback
+    void stop() { running_.store(false, std::memory_order_relaxed); }
+    bool is_running() const { return running_.load(std::memory_order_relaxed); }
+
+    const damiao_motor::JointState& get_arm_state() const { return arm_state_; }
+    const damiao_motor::JointState& get_gripper_state() const { return gripper_state_; }
+    const ControlLoopConfig& get_config() const { return config_; }
+
+    ControlLoopStats get_stats() const;
+    void reset_stats();
+
+private:
+    void receive(ControlTick& tick, std::chrono::steady_clock::time_point deadline);
+
+    OpenArm& openarm_;
+    ControlLoopConfig config_;
+    std::atomic<bool> running_{false};
+
+    damiao_motor::JointState arm_state_;
+    damiao_motor::JointState gripper_state_;
+
+    std::atomic<uint64_t> ticks_{0};
+    std::atomic<uint64_t> overruns_{0};
+    std::atomic<uint64_t> missed_ticks_{0};
+    std::atomic<uint64_t> rx_timeouts_{0};
+    canbus::LatencyHistogram wakeup_latency_histogram_;
+    canbus::LatencyHistogram tick_duration_histogram_;
+};
+
+}  // namespace openarm::can::socket
@@ -34,6 +34,10 @@ public:
     // Gripper-specific controls
     void open(double kp = 50.0, double kd = 1.0);
     void close(double kp = 50.0, double kd = 1.0);
+    // The MIT command open()/close() send for a gripper position (0.0=closed, 1.0=open), e.g.
+    // to submit through CommandSlots instead of writing to the bus directly
+    damiao_motor::MITParam position_command(double gripper_position, double kp = 50.0,
+                                            double kd = 1.0) const;
     damiao_motor::Motor* get_motor() const { return motor_.get(); }
 
 private:
@@ -44,7 +48,7 @@ private:
 
     // The actual physical gripper uses a slider cranker-like mechanism, this mapping is an
     // approximation.
-    double gripper_to_motor_position(double gripper_position) {
+    double gripper_to_motor_position(double gripper_position) const {
         // Map gripper position (0.0=closed, 1.0=open) to motor position
         return (gripper_position - gripper_open_position_) /
                    (gripper_closed_position_ - gripper_open_position_) *
@@ -52,7 +56,7 @@ private:
                motor_open_position_;
     }
 
-    double motor_to_gripper_position(double motor_position) {
+    double motor_to_gripper_position(double motor_position) const {
         // Map motor position back to gripper position (0.0=closed, 1.0=open)
         return (motor_position - motor_open_position_) /
                    (motor_closed_position_ - motor_open_position_) *
@@ -0,0 +1,86 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "openarm.hpp"
+
+namespace openarm::can::socket {
+
+// Drives several OpenArm instances (one per CAN bus) from one epoll instance.
+// TX is fanned out to every bus first, then the replies of all buses are collected as
+// they arrive, so a control tick takes as long as the slowest bus instead of the sum of
+// all buses.
+//
+//   MultiArmExecutor executor;
+//   executor.add_arm(left);
+//   executor.add_arm(right);
+//   executor.for_each_arm([&](OpenArm& arm, size_t i) {
+//       arm.get_arm().mit_control_all(params[i]);
+//   });
+//   executor.recv_all();
+class MultiArmExecutor {
+public:
+    MultiArmExecutor();
+    ~MultiArmExecutor();
+
+    MultiArmExecutor(const MultiArmExecutor&) = delete;
+    MultiArmExecutor& operator=(const MultiArmExecutor&) = delete;
+
+    // The arm must outlive the executor
+    void add_arm(OpenArm& openarm);
+    size_t size() const { return arms_.size(); }
+    OpenArm& get_arm(size_t i) { return *arms_.at(i); }
+
+    // Call fn(arm, index) for every arm, in the order they were added
+    template <typename Fn>
+    void for_each_arm(Fn&& fn) {
+        for (size_t i = 0; i < arms_.size(); i++) fn(*arms_[i], i);
+    }
+
+    // Damiao Motor operations on every bus
+    void enable_all();
+    void disable_all();
+    void refresh_all();
+
+    // OpenArm::recv_all() on every bus at once: returns when every bus is complete or no
+    // bus received anything for timeout_us
+    void recv_all(int timeout_us = 500);
+    // OpenArm::recv_until_complete() on every bus at once. Returns the recv_can_ids that
+    // timed out, one vector per arm.
+    std::vector<std::vector<uint32_t>> recv_until_complete(
+        std::chrono::steady_clock::time_point deadline);
+
+    // Alternatively run one background receiver per bus, each with its own thread settings
+    // (e.g. pinned to its own CPU). configs must have one entry per arm.
+    void start_receivers(const std::vector<ReceiverConfig>& configs);
+    void stop_receivers();
+
+private:
+    // Wait for any bus to become readable and drain the readable ones, returns false on
+    // timeout
+    bool wait_and_drain(int timeout_us, std::vector<OpenArm::RecvProgress>& progress);
+    bool is_recv_complete(const std::vector<OpenArm::RecvProgress>& progress) const;
+
+    int epoll_fd_;
+    std::vector<OpenArm*> arms_;
+    std::vector<OpenArm::RecvProgress> progress_;
+};
+
+}  // namespace openarm::can::socket
@@ -14,22 +14,130 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "../../canbus/can_device_collection.hpp"
 #include "../../canbus/can_socket.hpp"
+#include "../../canbus/frame_log.hpp"
+#include "../../canbus/latency_histogram.hpp"
 #include "arm_component.hpp"
 #include "gripper_component.hpp"
+#include "param_cache.hpp"
+#include "realtime.hpp"
 
 namespace openarm::can::socket {
+
+// Settings for the optional background receiver
+struct ReceiverConfig {
+    ThreadConfig thread;
+    // How long the receiver blocks on the socket before re-checking for shutdown
+    int poll_timeout_us = 1000;
+};
+
+// Settings for the optional TX/RX pipeline
+struct PipelineConfig {
+    ThreadConfig tx_thread;
+    ThreadConfig rx_thread;
+    // Frames the rings hold, rounded up to a power of two
+    size_t tx_ring_size = 512;
+    size_t rx_ring_size = 1024;
+    // How long the I/O threads block before re-checking for shutdown
+    int poll_timeout_us = 1000;
+};
+
+// Settings of OpenArm::cycle()
+struct CycleConfig {
+    // How long cycle() waits for the replies. Must cover the bus time of the commands and
+    // replies, about 0.26 ms per motor on Classical CAN at 1 Mbit/s, plus the motor latency.
+    std::chrono::microseconds reply_timeout{1000};
+    // Enabled motors without a command are refreshed once their last state is older than
+    // this (0: in every cycle)
+    std::chrono::microseconds max_state_age{0};
+    // Same for disabled motors, which are never commanded
+    std::chrono::microseconds disabled_max_state_age{100000};
+};
+
+// Outcome of OpenArm::cycle()
+struct CycleResult {
+    size_t commands_sent = 0;
+    size_t refreshes_sent = 0;
+    // recv_can_ids that did not reply within reply_timeout
+    std::vector<uint32_t> timed_out;
+};
+
+// Outcome of OpenArm::load_params_cached()
+struct ParamLoadResult {
+    // motors restored from the cache
+    size_t cached = 0;
+    // motors whose parameters were read in full
+    size_t queried = 0;
+    // queries that got no reply
+    size_t failed = 0;
+};
+
+struct MotorLatencyStats {
+    uint32_t recv_can_id;
+    // command sent -> first reply received
+    canbus::HistogramSnapshot round_trip;
+};
+
+// Instrumentation snapshot, see OpenArm::get_stats()
+struct OpenArmStats {
+    // TX, RX and kernel drop counters of the socket, including the *_all() TX times
+    canbus::CANSocketStats socket;
+    // duration of each recv_all() call, including the time spent waiting for frames
+    canbus::HistogramSnapshot recv_all;
+    // time to read and dispatch one batch of queued frames, excluding the wait
+    canbus::HistogramSnapshot rx_drain;
+    // one entry per motor, arm motors first
+    std::vector<MotorLatencyStats> motors;
+    // received frames that matched no motor
+    uint64_t unmatched_frames = 0;
+    // all zero unless start_recording() was called
+    canbus::FrameRecorderStats recording;
+};
+
 class OpenArm {
 public:
     OpenArm(const std::string& can_interface, bool enable_fd = false);
-    ~OpenArm() = default;
+    // Run on another bus backend, e.g. canbus::LoopbackTransport or
+    // damiao_motor::DMMotorSimulator
+    explicit OpenArm(std::unique_ptr<canbus::CANTransport> transport);
+    ~OpenArm();
 
     std::string can_interface() const noexcept { return can_interface_; }
     bool can_fd_enabled() const noexcept { return enable_fd_; }
+    // Stamp every received state with the kernel receive time, see CANSocket. SOFTWARE is
+    // requested by default; without receive times a reply that arrives after its command
+    // timed out is taken as the reply to the next command.
+    bool enable_timestamping(canbus::TimestampMode mode) {
+        return can_socket_->enable_timestamping(mode);
+    }
+    // The kernel only queues frames from registered motors on our socket (on by default),
+    // see CANDeviceCollection::set_kernel_filtering()
+    void set_kernel_filtering(bool enable) {
+        master_can_device_collection_->set_kernel_filtering(enable);
+    }
+    // Loopback lets other programs on this host (candump, ...) see our frames
+    bool set_loopback(bool enable) { return can_socket_->set_loopback(enable); }
+    // How recv_all(), the background receiver and the pipeline reader wait for replies, see
+    // CANSocket::set_receive_strategy(). Set while none of them runs.
+    bool set_receive_strategy(const canbus::ReceiveStrategyConfig& config) {
+        return can_socket_->set_receive_strategy(config);
+    }
+    bool set_recv_own_msgs(bool enable) { return can_socket_->set_recv_own_msgs(enable); }
+    // Queue and pace commands instead of dropping them when the bus is saturated, see
+    // CANSocket::enable_tx_scheduler()
+    void enable_tx_scheduler(const canbus::TxSchedulerConfig& config = {}) {
+        can_socket_->enable_tx_scheduler(config);
+    }
+    void disable_tx_scheduler() { can_socket_->disable_tx_scheduler(); }
 
     // Component initialization
     void init_arm_motors(const std::vector<damiao_motor::MotorType>& motor_types,
@@ -45,8 +153,10 @@ public:
     canbus::CANDeviceCollection& get_master_can_device_collection() {
         return *master_can_device_collection_;
     }
+    canbus::CANSocket& get_can_socket() { return *can_socket_; }
 
     // Damiao Motor operations (works only on sub_dm_device_collections_)
+    // Frames of all components are sent together in one batch.
     void enable_all();
     void disable_all();
     void set_zero_all();
@@ -55,11 +165,135 @@ public:
     void refresh_one(int i);
     // The timeout for reading from socket, set to timeout_us.
     // Tuning this value may improve the performance but should be done with caution.
+    // Returns early once every pending motor (see DMDeviceCollection) has replied, or once
+    // every registered motor has replied when nothing is pending. Motors still pending when
+    // it gives up are no longer pending afterwards.
     void recv_all(int timeout_us = 500);
+    // Receive until every pending motor has replied or the deadline passes.
+    // Returns the recv_can_ids of the motors that timed out (empty if all replied).
+    std::vector<uint32_t> recv_until_complete(std::chrono::steady_clock::time_point deadline);
+    // Decode the frames already queued on the socket without waiting and without marking
+    // any motor pending. Returns the number of frames that matched a motor.
+    size_t recv_queued();
+
+    // One control tick without redundant refresh traffic. Every enabled motor with an entry
+    // in commands (arm motors first, then the gripper) gets its MIT or pos-vel command, and
+    // its state reply keeps it fresh. All other motors are only refreshed once their state is
+    // older than the CycleConfig age, so a fully commanded arm sends one frame per motor.
+    // Then waits like recv_until_complete(). Motors are enabled from enable_all() until
+    // disable_all().
+    CycleResult cycle(const std::vector<damiao_motor::MITParam>& commands,
+                      const CycleConfig& config = CycleConfig());
+    CycleResult cycle(const std::vector<damiao_motor::PosVelParam>& commands,
+                      const CycleConfig& config = CycleConfig());
+    // TX half of cycle() with the commands chosen per motor, for callers that collect the
+    // replies themselves (e.g. from a ControlLoop callback). send_command(collection, i,
+    // index) is called for every enabled motor and either sends a command to motor i of
+    // collection and returns true, or returns false to leave the motor to the refresh rules.
+    // index counts the arm motors first, then the gripper. timed_out stays empty. Frames
+    // already queued on the socket are decoded first, so a late reply to an earlier command
+    // never counts as a reply to this cycle.
+    using CycleCommandFn =
+        std::function<bool(damiao_motor::DMDeviceCollection& collection, int i, size_t index)>;
+    CycleResult send_cycle(const CycleCommandFn& send_command,
+                           const CycleConfig& config = CycleConfig());
+    bool has_pending_replies() const;
+    // Forget every pending reply, returns the recv_can_ids that were still pending
+    std::vector<uint32_t> expire_pending_replies();
+    // Restart the reply clock of every pending motor, see
+    // DMDeviceCollection::restamp_pending_replies()
+    void restamp_pending_replies();
+
+    // Non-blocking building blocks of recv_all() for callers that wait on the socket
+    // themselves, e.g. MultiArmExecutor waiting on several buses at once:
+    //   auto progress = begin_recv();
+    //   while (!is_recv_complete(progress)) { wait for get_socket_fd(); recv_ready(progress); }
+    //   end_recv(progress);
+    // When nothing is pending, begin_recv() marks every motor pending like recv_all() does
+    // (unless expect_all is false, as for recv_until_complete()), so the wait completes once
+    // each motor (by recv_can_id) has replied.
+    struct RecvProgress {
+        // every motor was marked pending by begin_recv()
+        bool expect_all;
+        // frames that matched a motor
+        size_t replies;
+    };
+    RecvProgress begin_recv(bool expect_all = true);
+    bool is_recv_complete(const RecvProgress& progress) const;
+    // Drain and dispatch everything queued on the socket without blocking
+    void recv_ready(RecvProgress& progress);
+    // Stop waiting, returns the recv_can_ids that did not reply like expire_pending_replies()
+    std::vector<uint32_t> end_recv(RecvProgress& progress);
+    int get_socket_fd() const { return can_socket_->get_socket_fd(); }
+
     void set_callback_mode_all(damiao_motor::CallbackMode callback_mode);
     void query_param_all(int RID);
+    // Read the given parameters of every motor with several queries in flight per motor,
+    // see DMDeviceCollection::pump_param_queries(). State frames keep decoding and the
+    // callback mode is left alone. Returns the number of queries that got no reply.
+    size_t load_params_all(const std::vector<int>& rids, size_t max_in_flight = 4,
+                           std::chrono::microseconds timeout = std::chrono::milliseconds(2));
+    // Same through an on-disk ParamCache, for fast startup: only SN and sw_ver are read from
+    // motors whose cache entry still matches, the others are read in full and the cache is
+    // rewritten. With apply_limits, valid PMAX/VMAX/TMAX values replace the motor type's MIT
+    // mapping ranges for that motor (Motor::set_limits()), which needs the background
+    // receiver stopped as it decodes with those ranges (std::logic_error otherwise).
+    // max_in_flight and timeout are passed to both reads as in load_params_all().
+    ParamLoadResult load_params_cached(const std::vector<int>& rids = ParamCache::default_rids(),
+                                       const std::string& cache_path = ParamCache::default_path(),
+                                       bool apply_limits = true, size_t max_in_flight = 4,
+                                       std::chrono::microseconds timeout =
+                                           std::chrono::milliseconds(2));
+
+    // Packed CAN-FD framing of the arm motors, see DMDeviceCollection::set_packed_framing().
+    // Call after init_arm_motors().
+    void set_packed_framing(const damiao_motor::PackedFramingConfig& config);
+    // Capability probe: query sw_ver and sub_ver of the arm motors and switch to packed
+    // framing if every motor supports it. Returns the selected mode, PER_MOTOR unless
+    // set_packed_framing() was called. Leaves the motors in STATE callback mode.
+    damiao_motor::FramingMode probe_framing(
+        std::chrono::microseconds timeout = std::chrono::milliseconds(10));
+
+    // Background receiver
+    // Starts a thread that blocks on the socket and decodes every frame as it arrives.
+    // Read the state with DMDeviceCollection::read_state() (lock-free, no syscalls) while it
+    // runs. recv_all() and recv_until_complete() must not be used at the same time.
+    void start_receiver(const ReceiverConfig& config = ReceiverConfig());
+    void stop_receiver();
+    bool is_receiver_running() const { return receiver_running_.load(); }
+
+    // TX/RX pipeline
+    // A writer thread sends queued commands and a reader thread queues received frames, see
+    // CANSocket::enable_async_io(). Commands (*_all(), mit_control_all(), ...) return as soon
+    // as they are queued, so the next tick can be computed while the bus is busy. Replies
+    // are decoded on the calling thread by process_replies() (or recv_all()), which means
+    // the state read at tick N+1 is the reply to the commands of tick N.
+    // Cannot be combined with the background receiver.
+    void start_pipeline(const PipelineConfig& config = PipelineConfig());
+    // Sends the commands still queued before returning
+    void stop_pipeline();
+    bool is_pipeline_running() const { return pipeline_running_.load(); }
+    // Decode every reply the reader thread queued so far without blocking, returns the
+    // number of frames that matched a motor
+    size_t process_replies();
+
+    // Frame capture: append every frame sent or received to a memory-mapped log, see
+    // canbus::FrameRecorder. Replay it with canbus::FrameReplayer through
+    // get_master_can_device_collection(). Both calls are safe while the receiver or the
+    // pipeline runs, but a new config only takes effect while neither runs.
+    void start_recording(const std::string& path, const canbus::FrameRecorderConfig& config = {});
+    void stop_recording();
+    bool is_recording() const { return recorder_ && recorder_->is_recording(); }
+
+    // Instrumentation
+    // Recording is always on and lock-free, so both calls are safe while the control loop
+    // or the background receiver runs.
+    OpenArmStats get_stats() const;
+    void reset_stats();
 
 private:
+    explicit OpenArm(std::unique_ptr<canbus::CANSocket> can_socket);
+
     std::string can_interface_;
     bool enable_fd_;
     std::unique_ptr<canbus::CANSocket> can_socket_;
@@ -67,7 +301,36 @@ private:
     std::unique_ptr<GripperComponent> gripper_;
     std::unique_ptr<canbus::CANDeviceCollection> master_can_device_collection_;
     std::vector<damiao_motor::DMDeviceCollection*> sub_dm_device_collections_;
+
+    // Preallocated receive buffers, filled by a single recvmmsg() per wake-up
+    static constexpr size_t RECV_BATCH_SIZE = 64;
+    std::vector<can_frame> rx_can_frames_;
+    std::vector<canfd_frame> rx_canfd_frames_;
+    std::vector<canbus::CANFrameTimestamp> rx_timestamps_;
     void register_dm_device_collection(damiao_motor::DMDeviceCollection& device_collection);
+    // Read all queued frames and dispatch them, returns the number of frames delivered
+    size_t drain_socket(bool track_pending = true);
+    void clear_pending_reply(canid_t recv_can_id, const canbus::CANFrameTimestamp& timestamp);
+    // Pump queued parameter queries until none is left, returns the number of failures
+    size_t run_param_queries(size_t max_in_flight, std::chrono::microseconds timeout);
+    CycleResult run_cycle(const CycleCommandFn& send_command, const CycleConfig& config);
+
+    canbus::LatencyHistogram recv_all_histogram_;
+    canbus::LatencyHistogram rx_drain_histogram_;
+
+    std::thread receiver_thread_;
+    std::atomic<bool> receiver_running_{false};
+    void receiver_loop(ReceiverConfig config);
+    void check_receiver_stopped(const char* caller) const;
+
+    std::thread pipeline_tx_thread_;
+    std::thread pipeline_rx_thread_;
+    std::atomic<bool> pipeline_running_{false};
+    void pipeline_tx_loop(PipelineConfig config);
+    void pipeline_rx_loop(PipelineConfig config);
+
+    // Only replaced while no I/O thread runs, those may still be recording into it
+    std::unique_ptr<canbus::FrameRecorder> recorder_;
 };
 
 }  // namespace openarm::can::socket
@@ -0,0 +1,77 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../../damiao_motor/dm_motor.hpp"
+
+namespace openarm::can::socket {
+
+// Parameters of one motor as last read from it
+struct CachedMotorParams {
+    std::string interface;
+    uint32_t recv_can_id = 0;
+    // Fingerprint: the cached values are only trusted while the motor reports both
+    double sn = -1;
+    double sw_ver = -1;
+    // RID -> value
+    std::map<int, double> params;
+};
+
+// On-disk cache of motor parameters keyed by CAN interface and recv_can_id, so startup only
+// has to read each motor's SN and sw_ver instead of every parameter. See
+// OpenArm::load_params_cached().
+//
+// The file is plain text, one motor per line:
+//   <interface> <recv_can_id> <SN> <sw_ver> <RID>=<value> ...
+class ParamCache {
+public:
+    // The RIDs load_params_cached() reads unless told otherwise
+    static const std::vector<int>& default_rids();
+    // $OPENARM_CAN_PARAM_CACHE, else $XDG_CACHE_HOME/openarm-can/params.cache, else
+    // ~/.cache/openarm-can/params.cache
+    static std::string default_path();
+
+    explicit ParamCache(std::string path = default_path());
+
+    const std::string& get_path() const { return path_; }
+
+    // Returns false if the file does not exist or cannot be read. Malformed lines are
+    // skipped with a warning.
+    bool load();
+    // Writes the whole cache atomically (temporary file + rename), creating the directory
+    bool save() const;
+
+    // nullptr if the motor is not cached
+    const CachedMotorParams* find(const std::string& interface, uint32_t recv_can_id) const;
+    // Whether the entry matches the motor's fingerprint and holds every RID in rids
+    static bool is_valid_for(const CachedMotorParams& entry, const damiao_motor::Motor& motor,
+                             const std::vector<int>& rids);
+    // Remember the motor's current values of rids (skipping the ones never read)
+    void store(const std::string& interface, const damiao_motor::Motor& motor,
+               const std::vector<int>& rids);
+    void clear() { entries_.clear(); }
+    size_t size() const { return entries_.size(); }
+
+private:
+    std::string path_;
+    std::map<std::pair<std::string, uint32_t>, CachedMotorParams> entries_;
+};
+
+}  // namespace openarm::can::socket
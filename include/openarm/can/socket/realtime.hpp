@@ -0,0 +1,36 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+namespace openarm::can::socket {
+
+// Scheduling settings for threads owned by the library
+struct ThreadConfig {
+    // SCHED_FIFO priority (1-99), 0 keeps the default scheduler
+    int priority = 0;
+    // CPU to pin the thread to, -1 leaves the affinity unchanged
+    int cpu = -1;
+};
+
+// Apply config to the calling thread. Returns false (and prints a warning) if any setting
+// could not be applied, e.g. because of missing CAP_SYS_NICE.
+bool configure_current_thread(const ThreadConfig& config);
+
+// Lock all current and future pages of the process into RAM (mlockall) so page faults
+// don't stall real-time threads. Returns false (and prints a warning) on failure, e.g.
+// because of RLIMIT_MEMLOCK.
+bool lock_process_memory();
+
+}  // namespace openarm::can::socket
@@ -0,0 +1,168 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../canbus/spsc_ring.hpp"
+#include "../../damiao_motor/dm_motor_constants.hpp"
+#include "control_loop.hpp"
+#include "openarm.hpp"
+
+namespace openarm::can::socket {
+
+// Joints a trajectory point can carry, enough for every arm of this library
+constexpr size_t TRAJECTORY_MAX_JOINTS = 8;
+
+enum class InterpolationMode {
+    // positions and velocities are continuous at every point
+    CUBIC,
+    // positions, velocities and accelerations are continuous at every point
+    QUINTIC
+};
+
+// One waypoint, entries past the number of arm joints are ignored
+struct TrajectoryPoint {
+    // steady_clock time in ns at which the arm should be at this point
+    int64_t time_ns = 0;
+    std::array<double, TRAJECTORY_MAX_JOINTS> positions{};      // rad
+    std::array<double, TRAJECTORY_MAX_JOINTS> velocities{};     // rad/s
+    std::array<double, TRAJECTORY_MAX_JOINTS> accelerations{};  // rad/s^2, QUINTIC only
+};
+
+struct TrajectoryStreamerConfig {
+    // Rate and thread settings of the streaming thread
+    ControlLoopConfig loop;
+    InterpolationMode interpolation = InterpolationMode::CUBIC;
+    // MIT or POS_VEL
+    damiao_motor::ControlMode control_mode = damiao_motor::ControlMode::MIT;
+    // MIT gains, one entry per arm joint
+    std::vector<double> kp;
+    std::vector<double> kd;
+    // POS_VEL sends the interpolated speed as the velocity limit, but never less than this
+    // so a motor that fell behind still reaches the setpoint. rad/s
+    double posvel_min_velocity = 0.1;
+    // Points the upload queue holds, rounded up to a power of two
+    size_t queue_size = 1024;
+};
+
+struct TrajectoryStreamerStats {
+    // points taken off the queue
+    uint64_t points = 0;
+    // points dropped because they were not later than the previous point
+    uint64_t rejected_points = 0;
+    // ticks that held the last point because no later point was queued, grows during
+    // a trajectory when the host does not refill the queue in time
+    uint64_t hold_ticks = 0;
+    ControlLoopStats loop;
+};
+
+// Streams a timestamped trajectory to the arm motors from a real-time thread. The host
+// uploads waypoints at its own pace (e.g. 100 Hz from a planner) through a lock-free queue,
+// and the streaming thread runs a ControlLoop that interpolates between them and sends one
+// MIT or PosVel command per joint every tick.
+//
+//   TrajectoryStreamer streamer(openarm, config);
+//   streamer.start();
+//   while (planning) streamer.push(next_points);  // returns how many fit
+//   streamer.stop();
+//
+// The first segment starts at the measured joint positions, so the first point should not
+// be far from where the arm is. After the last queued point the arm holds it. While the
+// streamer runs, it owns the CAN socket: don't command the OpenArm from other threads.
+class TrajectoryStreamer {
+public:
+    TrajectoryStreamer(OpenArm& openarm,
+                       const TrajectoryStreamerConfig& config = TrajectoryStreamerConfig());
+    ~TrajectoryStreamer();
+
+    TrajectoryStreamer(const TrajectoryStreamer&) = delete;
+    TrajectoryStreamer& operator=(const TrajectoryStreamer&) = delete;
+
+    void start();
+    void stop();
+    bool is_running() const { return running_.load(); }
+    // Error that stopped the streaming thread, empty if none
+    std::string get_error() const;
+
+    // Upload side, one thread at a time. Points must be in time order. Returns the number of
+    // points queued, less than count when the queue is full.
+    size_t push(const TrajectoryPoint* points, size_t count);
+    size_t push(const std::vector<TrajectoryPoint>& points) {
+        return push(points.data(), points.size());
+    }
+    // Points queued but not taken by the streaming thread yet
+    size_t queued() const { return queue_.size(); }
+    // Drop the points queued so far and hold the current setpoint from the next tick on.
+    // Points pushed after flush() returns are kept.
+    void flush() { flush_position_.store(queue_.pushed(), std::memory_order_release); }
+
+    // Arm state, consistent while the streaming thread is decoding replies
+    void read_state(damiao_motor::JointState& out) const;
+
+    TrajectoryStreamerStats get_stats() const;
+    void reset_stats();
+
+private:
+    // Polynomial coefficients of one segment as structure-of-arrays, so every step of the
+    // evaluation is one loop over all joints that the compiler vectorizes
+    struct Segment {
+        int64_t start_ns = 0;
+        alignas(64) std::array<double, TRAJECTORY_MAX_JOINTS> coefficients[6]{};
+    };
+
+    bool tick(const ControlTick& tick);
+    void fit_segment(const TrajectoryPoint& from, const TrajectoryPoint& to);
+    void evaluate(int64_t time_ns);
+    void send_setpoint();
+    void thread_main();
+
+    OpenArm& openarm_;
+    TrajectoryStreamerConfig config_;
+    size_t joint_count_;
+    ControlLoop loop_;
+    canbus::SPSCRing<TrajectoryPoint> queue_;
+    // queue_.pushed() at the last flush(), points before it are dropped
+    std::atomic<size_t> flush_position_{0};
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    mutable std::mutex error_mutex_;
+    std::string error_;
+
+    // Streaming thread only
+    bool has_target_ = false;
+    // Whether the last tick held target_ because no later point was queued
+    bool holding_ = false;
+    TrajectoryPoint target_;
+    Segment segment_;
+    alignas(64) std::array<double, TRAJECTORY_MAX_JOINTS> q_{};
+    alignas(64) std::array<double, TRAJECTORY_MAX_JOINTS> dq_{};
+    std::array<double, TRAJECTORY_MAX_JOINTS> tau_{};
+    std::vector<damiao_motor::PosVelParam> posvel_params_;
+
+    std::atomic<uint64_t> points_{0};
+    std::atomic<uint64_t> rejected_points_{0};
+    std::atomic<uint64_t> hold_ticks_{0};
+};
+
+}  // namespace openarm::can::socket
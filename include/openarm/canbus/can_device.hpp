@@ -20,6 +20,8 @@
 #include <cstdint>
 #include <vector>
 
+#include "can_timestamp.hpp"
+
 namespace openarm::canbus {
 // Abstract base class for CAN devices
 class CANDevice {
@@ -34,6 +36,16 @@ public:
 
     virtual void callback(const can_frame& frame) = 0;
     virtual void callback(const canfd_frame& frame) = 0;
+    // Called with the kernel receive timestamp of the frame. Devices that don't need it
+    // only implement the overloads above.
+    virtual void callback(const can_frame& frame, const CANFrameTimestamp& timestamp) {
+        (void)timestamp;
+        callback(frame);
+    }
+    virtual void callback(const canfd_frame& frame, const CANFrameTimestamp& timestamp) {
+        (void)timestamp;
+        callback(frame);
+    }
 
     canid_t get_send_can_id() const { return send_can_id_; }
     canid_t get_recv_can_id() const { return recv_can_id_; }
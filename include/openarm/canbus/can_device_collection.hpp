@@ -14,8 +14,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <map>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -30,14 +32,53 @@ public:
 
     void add_device(const std::shared_ptr<CANDevice>& device);
     void remove_device(const std::shared_ptr<CANDevice>& device);
-    void dispatch_frame_callback(can_frame& frame);
-    void dispatch_frame_callback(canfd_frame& frame);
+    // Called after every add_device()/remove_device() that changed the collection, for an
+    // owner that caches the device list. departed is the device that left the collection
+    // (removed, or replaced by a device with the same recv_can_id) or nullptr, and is still
+    // alive during the call.
+    using DevicesChangedCallback = std::function<void(CANDevice* departed)>;
+    void set_devices_changed_callback(DevicesChangedCallback callback) {
+        devices_changed_callback_ = std::move(callback);
+    }
+    // returns true if the frame was delivered to a registered device
+    bool dispatch_frame_callback(can_frame& frame);
+    bool dispatch_frame_callback(canfd_frame& frame);
+    // Same, passing the frame's kernel receive timestamp on to the device
+    bool dispatch_frame_callback(can_frame& frame, const CANFrameTimestamp& timestamp);
+    bool dispatch_frame_callback(canfd_frame& frame, const CANFrameTimestamp& timestamp);
     const std::map<canid_t, std::shared_ptr<CANDevice>>& get_devices() const { return devices_; }
     canbus::CANSocket& get_can_socket() const { return can_socket_; }
     int get_socket_fd() const { return can_socket_.get_socket_fd(); }
+    // Number of frames that matched no registered device
+    uint64_t get_unmatched_frame_count() const {
+        return unmatched_frames_.load(std::memory_order_relaxed);
+    }
+    void reset_unmatched_frame_count() { unmatched_frames_.store(0, std::memory_order_relaxed); }
+
+    // CAN_RAW_FILTER entries matching exactly the frames dispatch_frame_callback() delivers
+    std::vector<can_filter> get_filters() const;
+    // Install get_filters() on the socket and keep it up to date as devices are added or
+    // removed. Only one collection per socket should do this (OpenArm uses its master
+    // collection). Disabling goes back to receiving every frame.
+    void set_kernel_filtering(bool enable);
+    bool is_kernel_filtering() const { return kernel_filtering_; }
 
 private:
     canbus::CANSocket& can_socket_;
     std::map<canid_t, std::shared_ptr<CANDevice>> devices_;
+
+    // Dense dispatch table for standard 11-bit IDs built from every device's
+    // recv_can_id/recv_can_mask. Holds non-owning pointers into devices_ and is rebuilt
+    // whenever a device is added or removed.
+    std::vector<CANDevice*> sff_dispatch_table_;
+    void rebuild_dispatch_table();
+    CANDevice* find_device(canid_t can_id) const;
+
+    bool kernel_filtering_ = false;
+    void install_filters();
+
+    DevicesChangedCallback devices_changed_callback_;
+
+    std::atomic<uint64_t> unmatched_frames_{0};
 };
 }  // namespace openarm::canbus
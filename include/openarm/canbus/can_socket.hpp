@@ -17,11 +17,26 @@
 #include <linux/can.h>
 #include <linux/can/raw.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <vector>
+
+#include "can_timestamp.hpp"
+#include "can_transport.hpp"
+#include "latency_histogram.hpp"
+#include "spsc_ring.hpp"
+#include "tx_scheduler.hpp"
 
 namespace openarm::canbus {
 
+class FrameRecorder;
+
 // Exception classes for socket operations
 class CANSocketException : public std::runtime_error {
 public:
@@ -29,46 +44,284 @@ public:
         : std::runtime_error("Socket error: " + message) {}
 };
 
-// Base socket management class
+// How a thread waiting for received frames waits, see CANSocket::set_receive_strategy()
+enum class ReceiveStrategy {
+    // sleep in ppoll() until frames arrive (the default)
+    BLOCKING,
+    // check without sleeping for spin_duration, then sleep like BLOCKING
+    SPIN_THEN_BLOCK,
+    // never sleep: check without sleeping until frames arrive or the timeout passes. Burns
+    // the waiting thread's core, so give it a dedicated (ideally isolated) one.
+    BUSY_POLL
+};
+
+struct ReceiveStrategyConfig {
+    ReceiveStrategy strategy = ReceiveStrategy::BLOCKING;
+    // SPIN_THEN_BLOCK: how long to spin before sleeping
+    std::chrono::microseconds spin_duration{50};
+    // SO_BUSY_POLL: let the kernel poll the driver for up to this long in every receive,
+    // for drivers with NAPI busy polling. 0 leaves the socket alone. Values above
+    // net.core.busy_read need CAP_NET_ADMIN.
+    int socket_busy_poll_us = 0;
+};
+
+// Counters since construction or the last CANSocket::reset_stats()
+struct CANSocketStats {
+    uint64_t frames_sent = 0;
+    uint64_t frames_received = 0;
+    // frames the kernel refused to queue (e.g. ENOBUFS when the TX queue is full)
+    uint64_t send_errors = 0;
+    // frames of the wrong size dropped by read_can_frames()/read_canfd_frames()
+    uint64_t malformed_frames = 0;
+    // frames the kernel dropped because the receive queue was full (SO_RXQ_OVFL), updated
+    // by read_can_frames()/read_canfd_frames()
+    uint64_t rx_queue_overflows = 0;
+    // frames dropped because an async I/O ring was full
+    uint64_t ring_overflows = 0;
+    // waits for received frames that found them while spinning, and that slept first
+    uint64_t spin_wakeups = 0;
+    uint64_t sleep_wakeups = 0;
+    // kernel receive timestamp of the first frame of a read -> the read, i.e. the wake-up
+    // latency a receive strategy trades CPU time for. Needs TimestampMode::SOFTWARE.
+    HistogramSnapshot rx_wake;
+    // all zero unless the TX scheduler is enabled
+    TxSchedulerStats tx_scheduler;
+    // time from the outermost begin_batch() until its frames are sent, i.e. the TX
+    // time of every *_all() call (under ControlLoop this includes the hold until the
+    // next tick)
+    HistogramSnapshot tx_batch;
+};
+
+// Frame I/O of the whole stack (batching, async I/O, TX scheduling, capture,
+// instrumentation) on top of a CANTransport
 class CANSocket {
 public:
+    // SocketCAN on a kernel interface, throws CANSocketException if it cannot be opened
     explicit CANSocket(const std::string& interface, bool enable_fd = false);
+    // Any other transport, e.g. LoopbackTransport or damiao_motor::DMMotorSimulator
+    explicit CANSocket(std::unique_ptr<CANTransport> transport);
     ~CANSocket();
 
-    // Disable copy, enable move
+    // Neither copyable nor movable: the atomic counters and latency histograms can't move,
+    // and the threads running pump_tx()/pump_rx() keep references. Hold it by pointer.
     CANSocket(const CANSocket&) = delete;
     CANSocket& operator=(const CANSocket&) = delete;
-    CANSocket(CANSocket&&) = default;
-    CANSocket& operator=(CANSocket&&) = default;
+    CANSocket(CANSocket&&) = delete;
+    CANSocket& operator=(CANSocket&&) = delete;
 
-    // File descriptor access for Python bindings
-    int get_socket_fd() const { return socket_fd_; }
+    // File descriptor access for Python bindings, readable while frames are waiting
+    int get_socket_fd() const { return transport_ ? transport_->get_fd() : -1; }
     const std::string& get_interface() const { return interface_; }
     bool is_canfd_enabled() const { return fd_enabled_; }
-    bool is_initialized() const { return socket_fd_ >= 0; }
+    bool is_initialized() const { return get_socket_fd() >= 0; }
+    CANTransport& get_transport() { return *transport_; }
 
     // Direct frame operations for Python bindings
     ssize_t read_raw_frame(void* buffer, size_t buffer_size);
     ssize_t write_raw_frame(const void* buffer, size_t frame_size);
 
-    // write can_frame or canfd_frame
+    // write can_frame or canfd_frame. While batching this only queues the frame and returns
+    // true, end_batch() reports whether it was sent.
     bool write_can_frame(const can_frame& frame);
     bool write_canfd_frame(const canfd_frame& frame);
 
+    // write multiple can_frames or canfd_frames with as few sendmmsg() calls as possible,
+    // returns the number of frames written
+    size_t write_can_frames(const can_frame* frames, size_t count);
+    size_t write_canfd_frames(const canfd_frame* frames, size_t count);
+
+    // Frames written between begin_batch() and the matching end_batch() are queued and
+    // sent together by the outermost end_batch(), in write order even when classic and FD
+    // frames are mixed. Batches may be nested. The outermost end_batch() returns false if a
+    // frame could not be sent; it and the frames queued behind it are dropped and counted
+    // in CANSocketStats::send_errors. Prefer CANSocketBatch over calling these directly.
+    void begin_batch();
+    bool end_batch();
+    bool is_batching() const { return batch_depth_ > 0; }
+
     // read can_frame or canfd_frame
     bool read_can_frame(can_frame& frame);
     bool read_canfd_frame(canfd_frame& frame);
 
+    // read every queued can_frame or canfd_frame (up to max_count) with a single
+    // recvmmsg() call without blocking, returns the number of frames read
+    size_t read_can_frames(can_frame* frames, size_t max_count);
+    size_t read_canfd_frames(canfd_frame* frames, size_t max_count);
+    // Same, also fills timestamps[i] for frames[i] (all 0 unless timestamping is enabled)
+    size_t read_can_frames(can_frame* frames, CANFrameTimestamp* timestamps, size_t max_count);
+    size_t read_canfd_frames(canfd_frame* frames, CANFrameTimestamp* timestamps,
+                             size_t max_count);
+
+    // Request kernel receive timestamps for every frame. HARDWARE also asks the adapter to
+    // timestamp frames, which may need CAP_NET_ADMIN. Returns false if the kernel
+    // rejected the request.
+    bool enable_timestamping(TimestampMode mode);
+    TimestampMode get_timestamp_mode() const { return timestamp_mode_; }
+
+    // Kernel-side receive filters (CAN_RAW_FILTER): only frames matching one of the
+    // filters are queued on this socket. An empty list receives nothing.
+    bool set_filters(const std::vector<can_filter>& filters);
+    // Go back to receiving every frame on the bus (the default)
+    bool clear_filters();
+    // Loopback: other sockets on this host see the frames we send (default: on)
+    bool set_loopback(bool enable);
+    // Receive our own frames when loopback is on (default: off)
+    bool set_recv_own_msgs(bool enable);
+
     // check if data is available for reading (non-blocking)
     bool is_data_available(int timeout_us = 100);
 
+    // How is_data_available(), read_can_frame()/read_canfd_frame() and pump_rx() wait for
+    // frames. Set while no thread waits on the socket. Returns false if the transport
+    // rejected socket_busy_poll_us, the strategy itself is applied anyway.
+    bool set_receive_strategy(const ReceiveStrategyConfig& config);
+    const ReceiveStrategyConfig& get_receive_strategy() const { return receive_strategy_; }
+
+    // Asynchronous I/O, the building block of OpenArm::start_pipeline().
+    // While enabled, writes only put frames on a lock-free TX ring and return, and reads only
+    // take frames from a lock-free RX ring. A writer thread has to call pump_tx() and a
+    // reader thread pump_rx() to move frames between the rings and the socket. Enable and
+    // disable only while neither thread runs.
+    void enable_async_io(size_t tx_ring_size, size_t rx_ring_size);
+    void disable_async_io();
+    bool is_async_io() const { return async_io_; }
+    // Writer thread: wait up to timeout_us for queued frames and send them, returns the
+    // number of frames sent
+    size_t pump_tx(int timeout_us);
+    // Reader thread: wait up to timeout_us for frames on the socket and queue them, returns
+    // the number of frames queued
+    size_t pump_rx(int timeout_us);
+    // Wake a writer thread blocked in pump_tx(), e.g. to shut it down
+    void wake_tx();
+    // Whether the RX ring holds frames, without a syscall
+    bool has_queued_rx() const { return async_io_ && !rx_ring_->empty(); }
+
+    // TX scheduler
+    // Instead of dropping frames when the kernel TX queue is full (ENOBUFS), writes queue
+    // them by priority, pace them to the estimated bus time and retry with a bounded
+    // backoff. Writes block the calling thread for up to TxSchedulerConfig::max_wait
+    // (max_wait = 0: never), frames still queued after it are sent by the next write or
+    // flush_tx_queue(). Writes then return the number of frames accepted rather than sent.
+    // Enable and disable before start_pipeline() / enable_async_io().
+    void enable_tx_scheduler(const TxSchedulerConfig& config = TxSchedulerConfig());
+    // Sends what it can within max_wait, the rest is dropped
+    void disable_tx_scheduler();
+    bool is_tx_scheduler_enabled() const { return tx_scheduler_ != nullptr; }
+    // Try to send the frames the scheduler still holds within max_wait, returns the number
+    // sent
+    size_t flush_tx_queue();
+
+    // Frame capture
+    // Every frame sent or received from now on is also handed to recorder, without
+    // blocking (nullptr: off). The recorder must outlive the socket or be detached first,
+    // and must not be destroyed while an I/O thread may still be using it.
+    void set_frame_recorder(FrameRecorder* recorder) {
+        frame_recorder_.store(recorder, std::memory_order_release);
+    }
+    FrameRecorder* get_frame_recorder() const {
+        return frame_recorder_.load(std::memory_order_acquire);
+    }
+
+    // Instrumentation, safe to call from any thread
+    CANSocketStats get_stats() const;
+    void reset_stats();
+
 protected:
-    bool initialize_socket(const std::string& interface);
     void cleanup();
 
-    int socket_fd_;
+    std::unique_ptr<CANTransport> transport_;
     std::string interface_;
     bool fd_enabled_;
+    TimestampMode timestamp_mode_ = TimestampMode::NONE;
+    ReceiveStrategyConfig receive_strategy_;
+
+    // TX batching
+    int batch_depth_ = 0;
+    std::vector<TxFrame> batched_frames_;
+    std::chrono::steady_clock::time_point batch_start_;
+
+    // Instrumentation
+    std::atomic<uint64_t> frames_sent_{0};
+    std::atomic<uint64_t> frames_received_{0};
+    std::atomic<uint64_t> send_errors_{0};
+    std::atomic<uint64_t> malformed_frames_{0};
+    // SO_RXQ_OVFL is a running total kept by the kernel, reset_stats() moves the base
+    std::atomic<uint32_t> rx_queue_overflow_total_{0};
+    std::atomic<uint32_t> rx_queue_overflow_base_{0};
+    LatencyHistogram tx_batch_histogram_;
+    std::atomic<uint64_t> ring_overflows_{0};
+    std::atomic<uint64_t> spin_wakeups_{0};
+    std::atomic<uint64_t> sleep_wakeups_{0};
+    LatencyHistogram rx_wake_histogram_;
+    void count_sent(size_t sent, size_t count);
+    void count_received(size_t received, size_t malformed_frames,
+                        std::optional<uint32_t> rx_queue_overflow_total);
+
+    template <typename Frame>
+    size_t write_frames(const Frame* frames, size_t count);
+    template <typename Frame>
+    void queue_batched(const Frame& frame);
+    template <typename Frame>
+    size_t write_batched(const TxFrame* entries, size_t count);
+    template <typename Frame>
+    bool receive_one(Frame& frame);
+
+    // Async I/O: both frame types share canfd_frame storage (can_frame is a prefix of it)
+    struct RingFrame {
+        canfd_frame frame;
+        size_t size;
+        CANFrameTimestamp timestamp;
+    };
+    bool async_io_ = false;
+    std::unique_ptr<SPSCRing<TxFrame>> tx_ring_;
+    std::unique_ptr<SPSCRing<RingFrame>> rx_ring_;
+    // eventfds signalled when a ring becomes non-empty
+    int tx_event_fd_ = -1;
+    int rx_event_fd_ = -1;
+    bool poll_fd(int fd, int timeout_us);
+    // Wait up to timeout_us as receive_strategy_ says: spin on ready(), then sleep on fd
+    enum class WaitResult { TIMEOUT, SPUN, SLEPT };
+    template <typename Ready>
+    WaitResult wait_for_rx(int fd, int timeout_us, Ready ready);
+    void record_rx_wake(const CANFrameTimestamp* timestamps, size_t count);
+    template <typename Frame>
+    size_t dequeue_rx(Frame* frames, CANFrameTimestamp* timestamps, size_t max_count);
+
+    std::unique_ptr<TxScheduler> tx_scheduler_;
+    size_t schedule_frames(const TxFrame* frames, size_t count);
+    size_t service_tx_queue();
+    template <typename Frame>
+    void record_rx_bus_time(const Frame* frames, size_t count);
+
+    std::atomic<FrameRecorder*> frame_recorder_{nullptr};
+    template <typename Frame>
+    void record_tx(const Frame* frames, size_t count);
+    template <typename Frame>
+    void record_rx(const Frame* frames, const CANFrameTimestamp* timestamps, size_t count);
+};
+
+// Scoped TX batch: every frame written to the socket while this object is alive is sent in
+// one kernel crossing when the outermost batch goes out of scope, or by end() to learn
+// whether the batch was sent (see CANSocket::end_batch()).
+class CANSocketBatch {
+public:
+    explicit CANSocketBatch(CANSocket& can_socket) : can_socket_(can_socket) {
+        can_socket_.begin_batch();
+    }
+    ~CANSocketBatch() { end(); }
+
+    CANSocketBatch(const CANSocketBatch&) = delete;
+    CANSocketBatch& operator=(const CANSocketBatch&) = delete;
+
+    bool end() {
+        if (ended_) return true;
+        ended_ = true;
+        return can_socket_.end_batch();
+    }
+
+private:
+    CANSocket& can_socket_;
+    bool ended_ = false;
 };
 
 }  // namespace openarm::canbus
@@ -0,0 +1,39 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+namespace openarm::canbus {
+
+// Which kernel receive timestamps CANSocket requests (SO_TIMESTAMPING)
+enum class TimestampMode {
+    NONE,
+    SOFTWARE,
+    // adapter timestamps when the driver supports them, software timestamps are still taken
+    HARDWARE
+};
+
+// Kernel receive timestamps of one frame, 0 when not available
+struct CANFrameTimestamp {
+    // software timestamp taken when the kernel received the frame, converted to
+    // std::chrono::steady_clock ns so it can be compared against steady_clock::now()
+    int64_t software_ns = 0;
+    // raw adapter timestamp in ns, only with TimestampMode::HARDWARE on a supporting
+    // adapter. It runs on the adapter's clock: use it for intervals between frames.
+    int64_t hardware_ns = 0;
+};
+
+}  // namespace openarm::canbus
@@ -0,0 +1,87 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <linux/can.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "can_timestamp.hpp"
+#include "tx_scheduler.hpp"
+
+namespace openarm::canbus {
+
+// What one CANTransport::receive() call saw besides the frames
+struct CANReceiveInfo {
+    // frames of the wrong size (e.g. classic frames on a CAN-FD transport), dropped
+    size_t malformed_frames = 0;
+    // running total of frames the kernel dropped (SO_RXQ_OVFL), if reported
+    std::optional<uint32_t> rx_queue_overflow_total;
+};
+
+// The bus a CANSocket sends to and receives from. SocketCANTransport talks to a kernel CAN
+// interface (real or vcan); LoopbackTransport and damiao_motor::DMMotorSimulator run
+// in-process, so the whole stack above CANSocket can be tested and benchmarked without
+// hardware and without syscalls on the frame path.
+// Frames are can_frame or canfd_frame arrays. Each direction is used by one thread at a
+// time, which may differ between TX and RX.
+class CANTransport {
+public:
+    virtual ~CANTransport() = default;
+
+    virtual const std::string& get_interface() const = 0;
+    virtual bool is_canfd_enabled() const = 0;
+    // Polls readable (POLLIN/EPOLLIN) while frames are waiting to be received
+    virtual int get_fd() const = 0;
+
+    // Send in order until a frame fails (errno is then set), returns the number sent
+    virtual size_t send(const can_frame* frames, size_t count) = 0;
+    virtual size_t send(const canfd_frame* frames, size_t count) = 0;
+    // Send mixed classic and FD frames without ever blocking, like sendmmsg(MSG_DONTWAIT):
+    // returns the number sent, or -1 with errno set (ENOBUFS/EAGAIN: TX queue full)
+    virtual int try_send(const TxFrame* frames, size_t count) = 0;
+    // Receive up to max_count queued frames without blocking. timestamps may be nullptr and
+    // are left 0 unless timestamping is enabled.
+    virtual size_t receive(can_frame* frames, CANFrameTimestamp* timestamps, size_t max_count,
+                           CANReceiveInfo& info) = 0;
+    virtual size_t receive(canfd_frame* frames, CANFrameTimestamp* timestamps,
+                           size_t max_count, CANReceiveInfo& info) = 0;
+
+    // Optional features, false when rejected or not supported
+    virtual bool enable_timestamping(TimestampMode mode) { return mode == TimestampMode::NONE; }
+    // Only frames matching one of the filters are received, see CAN_RAW_FILTER
+    virtual bool set_filters(const std::vector<can_filter>& /*filters*/) { return false; }
+    virtual bool set_loopback(bool /*enable*/) { return false; }
+    virtual bool set_recv_own_msgs(bool /*enable*/) { return false; }
+    // Kernel busy polling of the driver on receive (SO_BUSY_POLL)
+    virtual bool set_busy_poll(int /*busy_poll_us*/) { return false; }
+};
+
+// CAN_RAW_FILTER semantics for transports that filter in software: an empty list matches
+// nothing
+inline bool matches_can_filters(const std::vector<can_filter>& filters, canid_t can_id) {
+    for (const can_filter& filter : filters) {
+        bool match = (can_id & filter.can_mask) == (filter.can_id & filter.can_mask);
+        if (filter.can_id & CAN_INV_FILTER) match = !match;
+        if (match) return true;
+    }
+    return false;
+}
+
+}  // namespace openarm::canbus
@@ -0,0 +1,202 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <linux/can.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "can_timestamp.hpp"
+#include "spsc_ring.hpp"
+#include "tx_scheduler.hpp"
+
+namespace openarm::canbus {
+
+class CANDeviceCollection;
+
+// Binary frame log: a FrameLogHeader followed by fixed-size records, so a log can be
+// memory-mapped and indexed directly. Records of one direction are in time order, TX and RX
+// records are interleaved by timestamp as they are flushed.
+constexpr char FRAME_LOG_MAGIC[8] = {'O', 'A', 'C', 'A', 'N', 'L', 'O', 'G'};
+constexpr uint32_t FRAME_LOG_VERSION = 1;
+
+enum class FrameDirection : uint8_t { RX = 0, TX = 1 };
+
+struct FrameLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    // updated by the recorder as records are flushed
+    uint64_t record_count;
+    // steady_clock time in ns when recording started
+    int64_t start_time_ns;
+    char interface[32];
+};
+static_assert(sizeof(FrameLogHeader) == 64);
+
+struct FrameLogRecord {
+    // steady_clock ns, the kernel receive time for RX frames when timestamping is enabled
+    int64_t timestamp_ns;
+    // adapter timestamp of RX frames (0: none)
+    int64_t hw_timestamp_ns;
+    uint32_t can_id;
+    FrameDirection direction;
+    // payload length in bytes
+    uint8_t len;
+    // canfd_frame::flags
+    uint8_t fd_flags;
+    // 1 for CAN-FD frames
+    uint8_t is_fd;
+    uint8_t data[CANFD_MAX_DLEN];
+};
+static_assert(sizeof(FrameLogRecord) == 88);
+
+struct FrameRecorderConfig {
+    // Records each ring holds between flushes, rounded up to a power of two. Frames arriving
+    // while a ring is full are dropped and counted.
+    size_t ring_size = 8192;
+    // The log file grows by this many records at a time
+    size_t file_chunk_records = 65536;
+    // How long the writer thread sleeps when both rings are empty
+    std::chrono::milliseconds flush_interval{10};
+};
+
+struct FrameRecorderStats {
+    uint64_t recorded = 0;
+    // frames lost because a ring was full or the log could not grow
+    uint64_t dropped = 0;
+};
+
+// Appends every frame a CANSocket sends or receives to a memory-mapped frame log, see
+// CANSocket::set_frame_recorder(). The record_*() calls only copy the frame into a lock-free
+// ring and never block or make syscalls, so they are safe on real-time threads. A writer
+// thread moves the records into the file. TX and RX have their own ring: at most one thread
+// may record each direction at a time.
+class FrameRecorder {
+public:
+    explicit FrameRecorder(const FrameRecorderConfig& config = FrameRecorderConfig());
+    ~FrameRecorder();
+
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    // Truncate path and start recording into it. Throws std::runtime_error if the file cannot
+    // be created and std::logic_error if already recording.
+    void start(const std::string& path, const std::string& interface = "");
+    // Flush what is queued and close the log. Frames recorded afterwards are discarded.
+    void stop();
+    bool is_recording() const { return recording_.load(std::memory_order_acquire); }
+
+    void record_tx(const can_frame* frames, size_t count);
+    void record_tx(const canfd_frame* frames, size_t count);
+    void record_tx(const TxFrame* frames, size_t count);
+    // timestamps may be nullptr
+    void record_rx(const can_frame* frames, const CANFrameTimestamp* timestamps, size_t count);
+    void record_rx(const canfd_frame* frames, const CANFrameTimestamp* timestamps,
+                   size_t count);
+
+    FrameRecorderStats get_stats() const;
+
+private:
+    FrameRecorderConfig config_;
+    SPSCRing<FrameLogRecord> tx_ring_;
+    SPSCRing<FrameLogRecord> rx_ring_;
+    std::atomic<bool> recording_{false};
+    std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    template <typename Frame>
+    void record(FrameDirection direction, const Frame* frames,
+                const CANFrameTimestamp* timestamps, size_t count);
+    void push(SPSCRing<FrameLogRecord>& ring, const FrameLogRecord* records, size_t count);
+
+    // Writer thread state
+    std::thread writer_thread_;
+    int fd_ = -1;
+    void* map_ = nullptr;
+    size_t map_records_ = 0;
+    FrameLogHeader* header() const { return static_cast<FrameLogHeader*>(map_); }
+    FrameLogRecord* records() const {
+        return reinterpret_cast<FrameLogRecord*>(static_cast<char*>(map_) +
+                                                 sizeof(FrameLogHeader));
+    }
+    void writer_loop();
+    size_t flush(std::vector<FrameLogRecord>& tx, std::vector<FrameLogRecord>& rx);
+    bool append(const FrameLogRecord& record);
+    bool grow();
+};
+
+// Read-only memory-mapped view of a frame log. Also reads logs of a recorder that did not
+// shut down cleanly, up to the last flushed record.
+class FrameLogReader {
+public:
+    // Throws std::runtime_error if the file cannot be read or is not a frame log
+    explicit FrameLogReader(const std::string& path);
+    ~FrameLogReader();
+
+    FrameLogReader(const FrameLogReader&) = delete;
+    FrameLogReader& operator=(const FrameLogReader&) = delete;
+
+    const FrameLogHeader& get_header() const { return *header_; }
+    size_t size() const { return size_; }
+    const FrameLogRecord& operator[](size_t i) const { return records_[i]; }
+    const FrameLogRecord* begin() const { return records_; }
+    const FrameLogRecord* end() const { return records_ + size_; }
+
+private:
+    void* map_ = nullptr;
+    size_t map_size_ = 0;
+    const FrameLogHeader* header_ = nullptr;
+    const FrameLogRecord* records_ = nullptr;
+    size_t size_ = 0;
+};
+
+struct ReplayStats {
+    // RX records fed to the collection
+    size_t frames = 0;
+    // frames a registered device accepted
+    size_t dispatched = 0;
+    std::chrono::nanoseconds duration{0};
+};
+
+// Feeds the RX frames of a log back through CANDeviceCollection::dispatch_frame_callback(),
+// so the decoded state evolves as it did on the bus, without hardware. Frames get receive
+// timestamps on the replay clock, spaced like the recorded ones divided by speed.
+class FrameReplayer {
+public:
+    explicit FrameReplayer(const FrameLogReader& log) : log_(log) {}
+
+    // speed: 1 for the original timing, 2 for twice as fast, 0 (or less) as fast as possible.
+    // Blocks until the log is done or stop() is called from another thread.
+    ReplayStats replay(CANDeviceCollection& collection, double speed = 1.0);
+    void stop() { stop_requested_.store(true, std::memory_order_relaxed); }
+
+private:
+    const FrameLogReader& log_;
+    std::atomic<bool> stop_requested_{false};
+};
+
+// Convert a record back into a frame
+can_frame to_can_frame(const FrameLogRecord& record);
+canfd_frame to_canfd_frame(const FrameLogRecord& record);
+
+}  // namespace openarm::canbus
@@ -0,0 +1,185 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#ifndef OPENARM_CAN_HAVE_IO_URING
+#error "openarm_can was built without liburing, see OPENARM_CAN_USE_IO_URING in CMakeLists.txt"
+#endif
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "can_transport.hpp"
+#include "socketcan_transport.hpp"
+
+struct io_uring_buf_ring;
+
+namespace openarm::canbus {
+
+struct IoUringConfig {
+    // Submission queue entries, the completion queue gets twice as many
+    unsigned entries = 256;
+    // A kernel thread polls the submission queue, so submitting frames needs no syscall
+    // while it is awake. It sleeps after sqpoll_idle without submissions.
+    bool sqpoll = false;
+    std::chrono::milliseconds sqpoll_idle{50};
+    // CPU to pin the submission queue thread to, -1: not pinned
+    int sqpoll_cpu = -1;
+};
+
+class IoUringTransport;
+
+// One io_uring shared by any number of IoUringTransports, e.g. every bus of a
+// MultiArmExecutor: all their sends go through one submission queue and all their receive
+// completions land in one completion queue. Whichever transport is used next reaps the
+// completions of all of them.
+class IoUringContext {
+public:
+    // Throws CANSocketException if the ring cannot be set up
+    explicit IoUringContext(const IoUringConfig& config = IoUringConfig());
+    ~IoUringContext();
+
+    IoUringContext(const IoUringContext&) = delete;
+    IoUringContext& operator=(const IoUringContext&) = delete;
+
+    const IoUringConfig& get_config() const { return config_; }
+
+private:
+    friend class IoUringTransport;
+    // liburing state, kept out of this header
+    struct Ring;
+
+    IoUringConfig config_;
+    std::unique_ptr<Ring> ring_;
+    // Registered with the ring, so it becomes readable on every completion
+    int event_fd_ = -1;
+    // Transports indexed by the id in their completions' user_data
+    std::vector<IoUringTransport*> transports_;
+    bool submit_pending_ = false;
+    // The ring is used by every transport's TX and RX threads
+    std::mutex mutex_;
+
+    uint16_t add_transport(IoUringTransport* transport);
+    void remove_transport(uint16_t id);
+    // Take the completions of every transport, event_fd_ is drained first so completions
+    // arriving meanwhile signal it again
+    void reap_locked();
+    void submit_locked();
+    // Keep event_fd_ readable while any transport still has received frames queued
+    void update_readiness_locked();
+};
+
+struct IoUringTransportConfig {
+    // Buffers the kernel receives into, rounded up to a power of two (at most 32768)
+    size_t rx_buffers = 256;
+    // Received frames held until receive() takes them, rounded up to a power of two
+    size_t rx_queue_size = 4096;
+    // Frames that may be in flight to the socket at once
+    size_t tx_slots = 256;
+};
+
+// Raw CAN socket driven through an io_uring instead of sendmmsg()/recvmmsg(). A multi-shot
+// receive stays armed on the socket and the kernel picks landing buffers from a ring of
+// buffers registered with the io_uring (a provided buffer ring), so received frames cost
+// no syscall. Sends are queued as submission entries and submitted once per batch, with
+// SQPOLL without any syscall.
+// Sends complete asynchronously: send()/try_send() return the number of frames queued and
+// errors reported by their completions only show up in get_tx_errors(). Setup, filters and
+// loopback go through a SocketCANTransport owning the socket. SOFTWARE timestamps are the
+// time a completion was reaped, since multi-shot receives carry no control messages.
+// Requires Linux 6.0 or newer.
+class IoUringTransport : public CANTransport {
+public:
+    IoUringTransport(const std::string& interface, bool enable_fd,
+                     std::shared_ptr<IoUringContext> context,
+                     const IoUringTransportConfig& config = IoUringTransportConfig());
+    ~IoUringTransport() override;
+
+    IoUringTransport(const IoUringTransport&) = delete;
+    IoUringTransport& operator=(const IoUringTransport&) = delete;
+
+    const std::string& get_interface() const override { return socket_.get_interface(); }
+    bool is_canfd_enabled() const override { return socket_.is_canfd_enabled(); }
+    // The context's completion eventfd, dup()ed so every transport can be added to the
+    // same epoll set. Readable while any transport of the context has frames to receive.
+    int get_fd() const override { return event_fd_; }
+
+    size_t send(const can_frame* frames, size_t count) override;
+    size_t send(const canfd_frame* frames, size_t count) override;
+    int try_send(const TxFrame* frames, size_t count) override;
+    size_t receive(can_frame* frames, CANFrameTimestamp* timestamps, size_t max_count,
+                   CANReceiveInfo& info) override;
+    size_t receive(canfd_frame* frames, CANFrameTimestamp* timestamps, size_t max_count,
+                   CANReceiveInfo& info) override;
+
+    bool enable_timestamping(TimestampMode mode) override;
+    bool set_filters(const std::vector<can_filter>& filters) override {
+        return socket_.set_filters(filters);
+    }
+    bool set_loopback(bool enable) override { return socket_.set_loopback(enable); }
+    bool set_recv_own_msgs(bool enable) override { return socket_.set_recv_own_msgs(enable); }
+    bool set_busy_poll(int busy_poll_us) override { return socket_.set_busy_poll(busy_poll_us); }
+
+    // Sends that failed after they were queued
+    uint64_t get_tx_errors() const;
+
+private:
+    friend class IoUringContext;
+
+    struct QueuedFrame {
+        canfd_frame frame;
+        size_t size;
+        int64_t received_ns;
+    };
+
+    SocketCANTransport socket_;
+    std::shared_ptr<IoUringContext> context_;
+    uint16_t id_;
+    int event_fd_ = -1;
+    bool timestamping_ = false;
+
+    // Landing buffers of the multi-shot receive, one frame each
+    std::vector<canfd_frame> rx_buffers_;
+    io_uring_buf_ring* rx_buffer_ring_ = nullptr;
+    bool rx_armed_ = false;
+    bool closing_ = false;
+    std::vector<QueuedFrame> rx_queue_;
+    size_t rx_head_ = 0;
+    size_t rx_tail_ = 0;
+    uint32_t rx_overflows_ = 0;
+
+    std::vector<canfd_frame> tx_buffers_;
+    std::vector<uint32_t> free_tx_slots_;
+    uint64_t tx_errors_ = 0;
+
+    bool has_queued_rx() const { return rx_head_ != rx_tail_; }
+    void arm_receive_locked();
+    void complete_receive(int result, uint32_t flags);
+    void complete_send(uint32_t slot, int result);
+    // Queue one frame of the given size, false if no TX slot or submission entry is free
+    bool queue_send_locked(const void* frame, size_t size);
+    template <typename Frame>
+    size_t send_frames(const Frame* frames, size_t count);
+    template <typename Frame>
+    size_t receive_frames(Frame* frames, CANFrameTimestamp* timestamps, size_t max_count,
+                          CANReceiveInfo& info);
+};
+
+}  // namespace openarm::canbus
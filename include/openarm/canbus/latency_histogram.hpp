@@ -0,0 +1,91 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace openarm::canbus {
+
+// Point-in-time copy of a LatencyHistogram
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t min_ns = 0;
+    uint64_t max_ns = 0;
+    double mean_ns = 0;
+    // Indexed like LatencyHistogram::bucket_lower_bound()
+    std::vector<uint64_t> bucket_counts;
+
+    // Upper bound of the bucket holding the given percentile (0-100), 0 if empty
+    uint64_t value_at_percentile(double percentile) const;
+};
+
+// Lock-free log-linear (HDR-style) histogram of nanosecond durations.
+// Every power of two is split into 32 buckets, so values are kept with ~3% precision up to
+// ~18 minutes. record() is wait-free and may be called from any thread. reset() racing with
+// record() may lose the concurrent samples.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKET_COUNT = uint64_t{1} << SUB_BUCKET_BITS;
+    static constexpr int MAX_VALUE_BITS = 40;
+    static constexpr size_t BUCKET_COUNT =
+        SUB_BUCKET_COUNT * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1);
+
+    void record(uint64_t value_ns) {
+        buckets_[bucket_index(value_ns)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value_ns, std::memory_order_relaxed);
+        uint64_t min = min_.load(std::memory_order_relaxed);
+        while (value_ns < min && !min_.compare_exchange_weak(min, value_ns)) {
+        }
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value_ns > max && !max_.compare_exchange_weak(max, value_ns)) {
+        }
+    }
+    void record(std::chrono::steady_clock::duration duration) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        record(ns > 0 ? static_cast<uint64_t>(ns) : 0);
+    }
+
+    HistogramSnapshot snapshot() const;
+    void reset();
+
+    static size_t bucket_index(uint64_t value_ns) {
+        if (value_ns < SUB_BUCKET_COUNT) return value_ns;
+        int msb = 63 - __builtin_clzll(value_ns);
+        if (msb >= MAX_VALUE_BITS) return BUCKET_COUNT - 1;
+        int shift = msb - SUB_BUCKET_BITS;
+        return SUB_BUCKET_COUNT * (shift + 1) + ((value_ns >> shift) & (SUB_BUCKET_COUNT - 1));
+    }
+    static uint64_t bucket_lower_bound(size_t index) {
+        if (index < SUB_BUCKET_COUNT) return index;
+        size_t shift = index / SUB_BUCKET_COUNT - 1;
+        return (SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT) << shift;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> min_{UINT64_MAX};
+    std::atomic<uint64_t> max_{0};
+};
+
+}  // namespace openarm::canbus
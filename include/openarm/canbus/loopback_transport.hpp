@@ -0,0 +1,80 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "can_transport.hpp"
+
+namespace openarm::canbus {
+
+// In-process bus between exactly two endpoints: what one sends, the other receives, through
+// a lock-free SPSC ring per direction. No syscalls on the frame path except an eventfd
+// signal when a ring goes from empty to non-empty, so get_fd() still works with poll/epoll.
+// Filters are applied in software on the receiving side. A full ring fails sends with
+// ENOBUFS like a full kernel TX queue.
+class LoopbackTransport : public CANTransport {
+public:
+    // queue_size: frames each direction holds, rounded up to a power of two
+    static std::pair<std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>>
+    create_pair(const std::string& interface = "loopback", bool enable_fd = false,
+                size_t queue_size = 4096);
+    ~LoopbackTransport() override;
+
+    LoopbackTransport(const LoopbackTransport&) = delete;
+    LoopbackTransport& operator=(const LoopbackTransport&) = delete;
+
+    const std::string& get_interface() const override { return interface_; }
+    bool is_canfd_enabled() const override { return fd_enabled_; }
+    int get_fd() const override;
+
+    size_t send(const can_frame* frames, size_t count) override;
+    size_t send(const canfd_frame* frames, size_t count) override;
+    int try_send(const TxFrame* frames, size_t count) override;
+    size_t receive(can_frame* frames, CANFrameTimestamp* timestamps, size_t max_count,
+                   CANReceiveInfo& info) override;
+    size_t receive(canfd_frame* frames, CANFrameTimestamp* timestamps, size_t max_count,
+                   CANReceiveInfo& info) override;
+
+    // SOFTWARE stamps every frame with the steady_clock time it was sent
+    bool enable_timestamping(TimestampMode mode) override;
+    bool set_filters(const std::vector<can_filter>& filters) override;
+
+    // Shared by both endpoints, so either may be destroyed first
+    struct Queue;
+
+private:
+    LoopbackTransport(std::string interface, bool enable_fd, std::shared_ptr<Queue> rx_queue,
+                      std::shared_ptr<Queue> tx_queue);
+
+    std::string interface_;
+    bool fd_enabled_;
+    std::shared_ptr<Queue> rx_queue_;
+    std::shared_ptr<Queue> tx_queue_;
+    bool timestamping_ = false;
+    bool filtering_ = false;
+    std::vector<can_filter> filters_;
+
+    template <typename Frame>
+    size_t send_frames(const Frame* frames, size_t count);
+    template <typename Frame>
+    size_t receive_frames(Frame* frames, CANFrameTimestamp* timestamps, size_t max_count,
+                          CANReceiveInfo& info);
+};
+
+}  // namespace openarm::canbus
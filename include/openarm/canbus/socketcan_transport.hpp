@@ -0,0 +1,63 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "can_transport.hpp"
+
+namespace openarm::canbus {
+
+// A raw SocketCAN socket (CAN_RAW) bound to a kernel interface such as can0 or vcan0.
+// Sends and receives with sendmmsg()/recvmmsg(), up to 64 frames per syscall.
+class SocketCANTransport : public CANTransport {
+public:
+    // Throws CANSocketException if the socket cannot be created or bound
+    explicit SocketCANTransport(const std::string& interface, bool enable_fd = false);
+    ~SocketCANTransport() override;
+
+    SocketCANTransport(const SocketCANTransport&) = delete;
+    SocketCANTransport& operator=(const SocketCANTransport&) = delete;
+
+    const std::string& get_interface() const override { return interface_; }
+    bool is_canfd_enabled() const override { return fd_enabled_; }
+    int get_fd() const override { return socket_fd_; }
+
+    size_t send(const can_frame* frames, size_t count) override;
+    size_t send(const canfd_frame* frames, size_t count) override;
+    int try_send(const TxFrame* frames, size_t count) override;
+    size_t receive(can_frame* frames, CANFrameTimestamp* timestamps, size_t max_count,
+                   CANReceiveInfo& info) override;
+    size_t receive(canfd_frame* frames, CANFrameTimestamp* timestamps, size_t max_count,
+                   CANReceiveInfo& info) override;
+
+    // HARDWARE also asks the adapter to timestamp frames, which may need CAP_NET_ADMIN
+    bool enable_timestamping(TimestampMode mode) override;
+    bool set_filters(const std::vector<can_filter>& filters) override;
+    bool set_loopback(bool enable) override;
+    bool set_recv_own_msgs(bool enable) override;
+    bool set_busy_poll(int busy_poll_us) override;
+
+private:
+    int socket_fd_ = -1;
+    std::string interface_;
+    bool fd_enabled_;
+    bool timestamping_ = false;
+
+    bool initialize_socket();
+    void cleanup();
+};
+
+}  // namespace openarm::canbus
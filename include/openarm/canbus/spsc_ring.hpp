@@ -0,0 +1,87 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+namespace openarm::canbus {
+
+// Bounded lock-free single-producer/single-consumer ring buffer. One thread may push and
+// one (other) thread may pop concurrently without locks. The capacity is rounded up to a
+// power of two.
+template <typename T>
+class SPSCRing {
+public:
+    explicit SPSCRing(size_t capacity) {
+        if (capacity == 0) throw std::invalid_argument("SPSCRing capacity must be positive");
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        mask_ = size - 1;
+        buffer_ = std::make_unique<T[]>(size);
+    }
+
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+    // Exact on either side while the other one is idle, a snapshot otherwise
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    // Running counts of the items pushed and popped so far. An item was pushed before the
+    // producer read pushed() == n if fewer than n items were popped before it.
+    size_t pushed() const { return tail_.load(std::memory_order_acquire); }
+    size_t popped() const { return head_.load(std::memory_order_acquire); }
+
+    // Producer side, returns the number of items pushed (less than count when full)
+    size_t push(const T* items, size_t count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t n = std::min(count, capacity() - (tail - head));
+        for (size_t i = 0; i < n; i++) buffer_[(tail + i) & mask_] = items[i];
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+    bool push(const T& item) { return push(&item, 1) == 1; }
+
+    // Consumer side, returns the number of items popped
+    size_t pop(T* items, size_t max_count) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t n = std::min(max_count, tail - head);
+        for (size_t i = 0; i < n; i++) items[i] = buffer_[(head + i) & mask_];
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+    bool pop(T& item) { return pop(&item, 1) == 1; }
+
+private:
+    std::unique_ptr<T[]> buffer_;
+    size_t mask_;
+    // Separate cache lines so the two threads don't false-share the indices
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+}  // namespace openarm::canbus
@@ -0,0 +1,155 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <linux/can.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace openarm::canbus {
+
+// A classic or CAN-FD frame, size is CAN_MTU or CANFD_MTU (can_frame is a prefix of
+// canfd_frame)
+struct TxFrame {
+    canfd_frame frame;
+    size_t size;
+};
+
+struct TxSchedulerConfig {
+    // Nominal (arbitration) bitrate of the bus
+    uint32_t bitrate = 1000000;
+    // CAN-FD data phase bitrate of frames with CANFD_BRS set, 0: same as bitrate
+    uint32_t data_bitrate = 0;
+    // Bus time handed to the kernel ahead of the bus, later frames wait in our queue. Keeps
+    // the kernel TX queue short so high priority frames are not stuck behind a burst.
+    std::chrono::microseconds max_backlog{1000};
+    // Longest a single write sleeps on the calling thread, pacing frames to the bus or
+    // backing off after ENOBUFS, before leaving frames queued for the next one. 0: writes
+    // never sleep, whatever does not fit into max_backlog stays queued.
+    std::chrono::microseconds max_wait{2000};
+    // Backoff after ENOBUFS, doubled on every retry up to max_backoff
+    std::chrono::microseconds initial_backoff{50};
+    std::chrono::microseconds max_backoff{500};
+    // Frames held by the scheduler, writes beyond it are dropped
+    size_t max_queue_size = 256;
+    // A setpoint for a CAN ID that is still queued replaces the queued one (latest wins), so
+    // a stale setpoint never goes out once a newer one was written. Damiao enable, disable,
+    // set zero and clear error frames are never merged, nor is a setpoint merged into a
+    // frame written before one of them. Turn off when one ID carries other commands that
+    // must all arrive.
+    bool merge_by_id = true;
+    // Never merged, the ID addresses several devices (Damiao parameter reads and writes)
+    canid_t shared_id = 0x7FF;
+    // Length of the window used for the utilization estimate
+    std::chrono::milliseconds utilization_window{100};
+};
+
+struct TxSchedulerStats {
+    // Estimated share of the bus used by our frames and the frames we received, 0-1, over
+    // the last complete window
+    double utilization = 0.0;
+    size_t queue_depth = 0;
+    size_t max_queue_depth = 0;
+    // Sends the kernel rejected because the TX queue was full
+    uint64_t enobufs = 0;
+    // Frames dropped because the queue was full or the kernel refused them
+    uint64_t dropped = 0;
+    // Writes that returned with frames still queued
+    uint64_t deferred = 0;
+    // Queued frames replaced by a newer frame for the same ID
+    uint64_t merged = 0;
+};
+
+// Time a frame occupies the bus including worst-case bit stuffing and interframe space
+int64_t frame_duration_ns(const TxFrame& frame, uint32_t bitrate, uint32_t data_bitrate);
+int64_t frame_duration_ns(const can_frame& frame, uint32_t bitrate);
+int64_t frame_duration_ns(const canfd_frame& frame, uint32_t bitrate, uint32_t data_bitrate);
+
+// Priority queue and bus time bookkeeping behind CANSocket::enable_tx_scheduler().
+// Frames leave in CAN arbitration order (lowest ID first, so joint 1 before joint 8), and
+// in write order for the same ID unless merge_by_id replaced the older one. Queue operations
+// belong to the thread that transmits; record_bus_time() and get_stats() may be called from
+// any thread.
+class TxScheduler {
+public:
+    explicit TxScheduler(const TxSchedulerConfig& config);
+
+    const TxSchedulerConfig& get_config() const { return config_; }
+    bool empty() const { return queue_.empty(); }
+    size_t size() const { return queue_.size(); }
+
+    // Returns false (and counts a drop) when the queue is full and holds no frame to merge
+    // with
+    bool push(const TxFrame& frame);
+    // Time until the backlog leaves room for the next frame, 0 if it can be sent now
+    int64_t time_until_ready(int64_t now_ns) const;
+    // Pop up to max_count frames in priority order that fit into the backlog
+    size_t pop_ready(TxFrame* frames, size_t max_count, int64_t now_ns);
+    // Put popped frames that could not be sent back in front of everything else. With
+    // merge_by_id a setpoint whose ID got a newer setpoint meanwhile is discarded instead.
+    void requeue(const TxFrame* frames, size_t count);
+    // Account frames the kernel accepted
+    void on_sent(const TxFrame* frames, size_t count, int64_t now_ns);
+    // Bus time used by other frames, e.g. replies we received
+    void record_bus_time(int64_t duration_ns) {
+        busy_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+    }
+
+    void count_enobufs() { enobufs_.fetch_add(1, std::memory_order_relaxed); }
+    void count_dropped(size_t count) { dropped_.fetch_add(count, std::memory_order_relaxed); }
+    void count_deferred() { deferred_.fetch_add(1, std::memory_order_relaxed); }
+
+    TxSchedulerStats get_stats() const;
+    void reset_stats();
+
+private:
+    struct Entry {
+        TxFrame frame;
+        uint64_t sequence;
+    };
+    static bool lower_priority(const Entry& a, const Entry& b);
+    bool is_mergeable(const TxFrame& frame) const;
+    // The queued frame a new frame replaces, nullptr if none
+    Entry* find_merge_target(const TxFrame& frame);
+    // Whether a setpoint for the ID of a requeued frame was queued after it
+    bool has_newer_setpoint(const TxFrame& frame) const;
+
+    TxSchedulerConfig config_;
+    // Binary heap, the capacity is reserved up front
+    std::vector<Entry> queue_;
+    // push() counts up from the middle, requeue() counts down so requeued frames win ties
+    uint64_t next_sequence_ = uint64_t{1} << 63;
+    uint64_t front_sequence_ = uint64_t{1} << 63;
+    // When the bus is expected to have sent everything we handed to the kernel
+    int64_t bus_free_at_ns_ = 0;
+    int64_t window_start_ns_ = 0;
+    uint64_t window_start_busy_ns_ = 0;
+
+    std::atomic<uint64_t> busy_ns_{0};
+    std::atomic<double> utilization_{0.0};
+    std::atomic<size_t> queue_depth_{0};
+    std::atomic<size_t> max_queue_depth_{0};
+    std::atomic<uint64_t> enobufs_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> deferred_{0};
+    std::atomic<uint64_t> merged_{0};
+    void update_queue_depth();
+};
+
+}  // namespace openarm::canbus
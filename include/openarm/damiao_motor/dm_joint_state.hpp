@@ -0,0 +1,46 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace openarm::damiao_motor {
+
+// Joint state of a device collection as structure-of-arrays, indexed like
+// DMDeviceCollection::get_dm_devices().
+struct JointState {
+    std::vector<double> positions;   // rad
+    std::vector<double> velocities;  // rad/s
+    std::vector<double> torques;     // Nm
+    std::vector<int> t_mos;          // °C
+    std::vector<int> t_rotor;        // °C
+    // steady_clock time in ns when the last state frame arrived, the kernel receive time
+    // if socket timestamping is enabled (0: never updated)
+    std::vector<int64_t> timestamps_ns;
+    // adapter clock timestamp of the last state frame in ns (0: no hardware timestamp)
+    std::vector<int64_t> hw_timestamps_ns;
+    // number of state updates received
+    std::vector<uint64_t> sequences;
+
+    size_t size() const { return positions.size(); }
+    // Only allocates when the size changes
+    void resize(size_t n);
+    // Copy every array into out, allocation-free once out has the same size
+    void copy_to(JointState& out) const;
+};
+
+}  // namespace openarm::damiao_motor
@@ -14,9 +14,9 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <cstring>
-#include <map>
 
 #include "dm_motor_constants.hpp"
 
@@ -24,6 +24,7 @@ namespace openarm::damiao_motor {
 class Motor {
     friend class DMCANDevice;  // Allow MotorDeviceCan to access protected
                                // members
+    friend class DMDeviceCollection;
     friend class DMControl;
 
 public:
@@ -36,17 +37,33 @@ public:
     double get_torque() const { return state_tau_; }
     int get_state_tmos() const { return state_tmos_; }
     int get_state_trotor() const { return state_trotor_; }
+    // steady_clock time in ns when the state frame arrived: the kernel receive time if
+    // socket timestamping is enabled, the decode time otherwise (0: no state yet)
+    int64_t get_state_timestamp_ns() const { return state_timestamp_ns_; }
+    // adapter clock timestamp of the state frame in ns, 0 without hardware timestamping
+    int64_t get_state_hw_timestamp_ns() const { return state_hw_timestamp_ns_; }
 
     // Motor property getters
     uint32_t get_send_can_id() const { return send_can_id_; }
     uint32_t get_recv_can_id() const { return recv_can_id_; }
     MotorType get_motor_type() const { return motor_type_; }
 
-    // Enable status getters
+    // Enable status getters, set by DMDeviceCollection::enable_all()/disable_all()
     bool is_enabled() const { return enabled_; }
 
     // Parameter methods
+    // Last value read for RID, -1 if it was never read
     double get_param(int RID) const;
+    // Store a parameter value, e.g. one restored from a ParamCache
+    void set_temp_param(int RID, double val);
+
+    // MIT mapping ranges, MOTOR_LIMIT_PARAMS of the motor type unless overridden because
+    // this motor was configured with different PMAX/VMAX/TMAX
+    const LimitParam& get_limits() const { return limits_; }
+    // Not synchronized with decoding: only call while no other thread decodes this motor's
+    // frames
+    void set_limits(const LimitParam& limits);
+    const MITQuantization& get_mit_quantization() const { return mit_quantization_; }
 
     // Static methods for motor properties
     static LimitParam get_limit_param(MotorType motor_type);
@@ -56,8 +73,8 @@ protected:
     void update_state(double q, double dq, double tau, int tmos, int trotor);
     void set_state_tmos(int tmos);
     void set_state_trotor(int trotor);
+    void set_state_timestamp(int64_t timestamp_ns, int64_t hw_timestamp_ns);
     void set_enabled(bool enabled);
-    void set_temp_param(int RID, int val);
 
     // Motor identifiers
     uint32_t send_can_id_;
@@ -70,8 +87,13 @@ protected:
     // Current state
     double state_q_, state_dq_, state_tau_;
     int state_tmos_, state_trotor_;
+    int64_t state_timestamp_ns_ = 0;
+    int64_t state_hw_timestamp_ns_ = 0;
+
+    LimitParam limits_;
+    MITQuantization mit_quantization_;
 
-    // Parameter storage
-    std::map<int, double> temp_param_dict_;
+    // Parameter storage, indexed by RID
+    std::array<double, static_cast<size_t>(RID::COUNT)> params_;
 };
 }  // namespace openarm::damiao_motor
@@ -110,4 +110,48 @@ inline constexpr std::array<LimitParam, static_cast<std::size_t>(MotorType::COUN
         {12.5, 45, 10},   // DMH6215
         {12.5, 45, 10}    // DMG6220
     }};
+
+// MIT gain ranges shared by every motor type
+inline constexpr double MIT_KP_MAX = 500.0;
+inline constexpr double MIT_KD_MAX = 5.0;
+
+// Linear quantization of [min, max] onto an unsigned integer of a given bit width,
+// precomputed so encoding and decoding are a single multiply-add.
+struct QuantizationScale {
+    double min;
+    double max;
+    double to_uint;    // ((1 << bits) - 1) / (max - min)
+    double to_double;  // (max - min) / ((1 << bits) - 1)
+};
+
+constexpr QuantizationScale make_quantization_scale(double min, double max, int bits) {
+    double steps = static_cast<double>((1 << bits) - 1);
+    return {min, max, steps / (max - min), (max - min) / steps};
+}
+
+// Scales for every field of an MIT command / state frame of one motor type
+struct MITQuantization {
+    QuantizationScale kp;   // 12 bits
+    QuantizationScale kd;   // 12 bits
+    QuantizationScale q;    // 16 bits
+    QuantizationScale dq;   // 12 bits
+    QuantizationScale tau;  // 12 bits
+};
+
+constexpr MITQuantization make_mit_quantization(const LimitParam& limits) {
+    return {make_quantization_scale(0, MIT_KP_MAX, 12), make_quantization_scale(0, MIT_KD_MAX, 12),
+            make_quantization_scale(-limits.pMax, limits.pMax, 16),
+            make_quantization_scale(-limits.vMax, limits.vMax, 12),
+            make_quantization_scale(-limits.tMax, limits.tMax, 12)};
+}
+
+// MIT quantization table for each motor type, generated from MOTOR_LIMIT_PARAMS
+inline constexpr std::array<MITQuantization, static_cast<std::size_t>(MotorType::COUNT)>
+    MIT_QUANTIZATION = [] {
+        std::array<MITQuantization, static_cast<std::size_t>(MotorType::COUNT)> table{};
+        for (std::size_t i = 0; i < table.size(); i++) {
+            table[i] = make_mit_quantization(MOTOR_LIMIT_PARAMS[i]);
+        }
+        return table;
+    }();
 }  // namespace openarm::damiao_motor
@@ -16,6 +16,9 @@
 
 #include <linux/can.h>
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>  // for memcpy
 #include <iostream>
@@ -49,6 +52,13 @@ struct CANPacket {
     std::vector<uint8_t> data;
 };
 
+// Fixed-size counterpart of CANPacket. Every Damiao command is 8 bytes long, so the control
+// path uses this to avoid heap allocations.
+struct FixedCANPacket {
+    uint32_t send_can_id;
+    std::array<uint8_t, 8> data;
+};
+
 struct MITParam {
     double kp;
     double kd;
@@ -73,17 +83,87 @@ public:
     static CANPacket create_query_param_command(const Motor& motor, int RID);
     static CANPacket create_refresh_command(const Motor& motor);
 
-private:
-    static std::vector<uint8_t> pack_mit_control_data(MotorType motor_type,
-                                                      const MITParam& mit_param);
-    static std::vector<uint8_t> pack_posvel_control_data(MotorType motor_type,
-                                                         const PosVelParam& posvel_param);
-
-    static std::vector<uint8_t> pack_query_param_data(uint32_t send_can_id, int RID);
-    static std::vector<uint8_t> pack_command_data(uint8_t cmd);
+    // Allocation-free variants of the commands above
+    static FixedCANPacket encode_enable_command(const Motor& motor);
+    static FixedCANPacket encode_disable_command(const Motor& motor);
+    static FixedCANPacket encode_set_zero_command(const Motor& motor);
+    static FixedCANPacket encode_mit_control_command(const Motor& motor,
+                                                     const MITParam& mit_param);
+    static FixedCANPacket encode_posvel_control_command(const Motor& motor,
+                                                        const PosVelParam& posvel_param);
+    static FixedCANPacket encode_query_param_command(const Motor& motor, int RID);
+    static FixedCANPacket encode_refresh_command(const Motor& motor);
+
+    // MIT fast path for arms whose motor types are fixed at compile time. The quantization
+    // scales become constants.
+    template <MotorType motor_type>
+    static FixedCANPacket encode_mit_control_command(uint32_t send_can_id,
+                                                     const MITParam& mit_param) {
+        constexpr const MITQuantization& quantization =
+            MIT_QUANTIZATION[static_cast<std::size_t>(motor_type)];
+        return {send_can_id, pack_mit_control_data(quantization, mit_param)};
+    }
+
+    // Motor side of the protocol, used by DMMotorSimulator
+    // State reply: status in the high nibble of byte 0 (1: enabled), the low nibble of the
+    // motor's send_can_id in the low one
+    static std::array<uint8_t, 8> pack_state_data(const MITQuantization& quantization,
+                                                  uint8_t status, uint32_t send_can_id,
+                                                  const StateResult& state) {
+        uint16_t q_uint = quantize(state.position, quantization.q);
+        uint16_t dq_uint = quantize(state.velocity, quantization.dq);
+        uint16_t tau_uint = quantize(state.torque, quantization.tau);
+        return {static_cast<uint8_t>((status << 4) | (send_can_id & 0xF)),
+                static_cast<uint8_t>(q_uint >> 8),
+                static_cast<uint8_t>(q_uint & 0xFF),
+                static_cast<uint8_t>(dq_uint >> 4),
+                static_cast<uint8_t>(((dq_uint & 0xF) << 4) | ((tau_uint >> 8) & 0xF)),
+                static_cast<uint8_t>(tau_uint & 0xFF),
+                static_cast<uint8_t>(state.t_mos),
+                static_cast<uint8_t>(state.t_rotor)};
+    }
+    // Reply to a parameter read (0x33) or write (0x55)
+    static std::array<uint8_t, 8> pack_param_reply_data(uint32_t send_can_id, uint8_t command,
+                                                        int RID, double value);
 
-    static double limit_min_max(double x, double min, double max);
-    static uint16_t double_to_uint(double x, double x_min, double x_max, int bits);
+private:
+    static CANPacket to_can_packet(const FixedCANPacket& packet);
+
+    static std::array<uint8_t, 8> pack_mit_control_data(MotorType motor_type,
+                                                        const MITParam& mit_param);
+    static std::array<uint8_t, 8> pack_mit_control_data(const MITQuantization& quantization,
+                                                        const MITParam& mit_param) {
+        uint16_t kp_uint = quantize(mit_param.kp, quantization.kp);
+        uint16_t kd_uint = quantize(mit_param.kd, quantization.kd);
+        uint16_t q_uint = quantize(mit_param.q, quantization.q);
+        uint16_t dq_uint = quantize(mit_param.dq, quantization.dq);
+        uint16_t tau_uint = quantize(mit_param.tau, quantization.tau);
+
+        return {static_cast<uint8_t>((q_uint >> 8) & 0xFF),
+                static_cast<uint8_t>(q_uint & 0xFF),
+                static_cast<uint8_t>(dq_uint >> 4),
+                static_cast<uint8_t>(((dq_uint & 0xF) << 4) | ((kp_uint >> 8) & 0xF)),
+                static_cast<uint8_t>(kp_uint & 0xFF),
+                static_cast<uint8_t>(kd_uint >> 4),
+                static_cast<uint8_t>(((kd_uint & 0xF) << 4) | ((tau_uint >> 8) & 0xF)),
+                static_cast<uint8_t>(tau_uint & 0xFF)};
+    }
+    static std::array<uint8_t, 8> pack_posvel_control_data(MotorType motor_type,
+                                                           const PosVelParam& posvel_param);
+
+    static std::array<uint8_t, 8> pack_query_param_data(uint32_t send_can_id, int RID);
+    static std::array<uint8_t, 8> pack_command_data(uint8_t cmd);
+
+    static double limit_min_max(double x, double min, double max) {
+        return std::max(min, std::min(x, max));
+    }
+    static uint16_t quantize(double x, const QuantizationScale& scale) {
+        // Round to the nearest code: truncating would turn max, which the reciprocal scale
+        // maps to just below the top code, into top code - 1
+        return static_cast<uint16_t>((limit_min_max(x, scale.min, scale.max) - scale.min) *
+                                         scale.to_uint +
+                                     0.5);
+    }
     static std::array<uint8_t, 4> float_to_uint8s(float value);
 };
 
@@ -92,11 +172,62 @@ public:
     static StateResult parse_motor_state_data(const Motor& motor, const std::vector<uint8_t>& data);
     static ParamResult parse_motor_param_data(const std::vector<uint8_t>& data);
 
+    // Allocation-free variants reading directly from a frame payload
+    static StateResult parse_motor_state_data(const Motor& motor, const uint8_t* data,
+                                              size_t len);
+    static ParamResult parse_motor_param_data(const uint8_t* data, size_t len);
+
+    // State fast path for motor types known at compile time
+    template <MotorType motor_type>
+    static StateResult parse_motor_state_data(const uint8_t* data, size_t len) {
+        return decode_state(MIT_QUANTIZATION[static_cast<std::size_t>(motor_type)], data, len);
+    }
+
+    // Motor side of the protocol, used by DMMotorSimulator
+    static MITParam parse_mit_control_data(const MITQuantization& quantization,
+                                           const uint8_t* data) {
+        uint16_t q_uint = (static_cast<uint16_t>(data[0]) << 8) | data[1];
+        uint16_t dq_uint =
+            (static_cast<uint16_t>(data[2]) << 4) | (static_cast<uint16_t>(data[3]) >> 4);
+        uint16_t kp_uint = (static_cast<uint16_t>(data[3] & 0xF) << 8) | data[4];
+        uint16_t kd_uint =
+            (static_cast<uint16_t>(data[5]) << 4) | (static_cast<uint16_t>(data[6]) >> 4);
+        uint16_t tau_uint = (static_cast<uint16_t>(data[6] & 0xF) << 8) | data[7];
+        return {dequantize(kp_uint, quantization.kp), dequantize(kd_uint, quantization.kd),
+                dequantize(q_uint, quantization.q), dequantize(dq_uint, quantization.dq),
+                dequantize(tau_uint, quantization.tau)};
+    }
+    static PosVelParam parse_posvel_control_data(const uint8_t* data) {
+        float q, dq;
+        std::memcpy(&q, data, sizeof(q));
+        std::memcpy(&dq, data + 4, sizeof(dq));
+        return {q, dq};
+    }
+    // RIDs whose value is a uint32 rather than a float
+    static bool is_in_ranges(int number);
+
 private:
-    static double uint_to_double(uint16_t x, double min, double max, int bits);
+    static StateResult decode_state(const MITQuantization& quantization, const uint8_t* data,
+                                    size_t len) {
+        if (len < 8) return {0, 0, 0, 0, 0, false};
+
+        uint16_t q_uint = (static_cast<uint16_t>(data[1]) << 8) | data[2];
+        uint16_t dq_uint =
+            (static_cast<uint16_t>(data[3]) << 4) | (static_cast<uint16_t>(data[4]) >> 4);
+        uint16_t tau_uint = (static_cast<uint16_t>(data[4] & 0xf) << 8) | data[5];
+
+        return {dequantize(q_uint, quantization.q),
+                dequantize(dq_uint, quantization.dq),
+                dequantize(tau_uint, quantization.tau),
+                static_cast<int>(data[6]),
+                static_cast<int>(data[7]),
+                true};
+    }
+    static double dequantize(uint16_t x, const QuantizationScale& scale) {
+        return x * scale.to_double + scale.min;
+    }
     static float uint8s_to_float(const std::array<uint8_t, 4>& bytes);
     static uint32_t uint8s_to_uint32(uint8_t byte1, uint8_t byte2, uint8_t byte3, uint8_t byte4);
-    static bool is_in_ranges(int number);
 };
 
 }  // namespace openarm::damiao_motor
@@ -14,8 +14,13 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+
 #include "../canbus/can_device.hpp"
 #include "../canbus/can_socket.hpp"
+#include "../canbus/latency_histogram.hpp"
+#include "dm_joint_state.hpp"
 #include "dm_motor.hpp"
 #include "dm_motor_control.hpp"
 
@@ -30,21 +35,68 @@ enum CallbackMode {
 class DMCANDevice : public canbus::CANDevice {
 public:
     explicit DMCANDevice(Motor& motor, canid_t recv_can_mask, bool use_fd);
-    void callback(const can_frame& frame);
-    void callback(const canfd_frame& frame);
+    void callback(const can_frame& frame) override;
+    void callback(const canfd_frame& frame) override;
+    void callback(const can_frame& frame, const canbus::CANFrameTimestamp& timestamp) override;
+    void callback(const canfd_frame& frame, const canbus::CANFrameTimestamp& timestamp) override;
+    // Decode a state payload for this motor that arrived inside another frame, e.g. its slot
+    // of an aggregated CAN-FD reply
+    void callback_state_payload(const uint8_t* data, size_t len,
+                                const canbus::CANFrameTimestamp& timestamp);
 
     // Create frame from data array
-    can_frame create_can_frame(canid_t send_can_id, std::vector<uint8_t> data);
-    canfd_frame create_canfd_frame(canid_t send_can_id, std::vector<uint8_t> data);
+    can_frame create_can_frame(canid_t send_can_id, const std::vector<uint8_t>& data);
+    canfd_frame create_canfd_frame(canid_t send_can_id, const std::vector<uint8_t>& data);
+    can_frame create_can_frame(canid_t send_can_id, const uint8_t* data, size_t len);
+    canfd_frame create_canfd_frame(canid_t send_can_id, const uint8_t* data, size_t len);
     // Getter method to access motor state
     Motor& get_motor() { return motor_; }
     void set_callback_mode(CallbackMode callback_mode) { callback_mode_ = callback_mode; }
+    // Also publish decoded states into slot index of a collection's joint state buffer
+    void set_joint_state_slot(JointState* joint_state, size_t index) {
+        joint_state_ = joint_state;
+        joint_state_index_ = index;
+    }
+    // Copy this device's joint state slot into out[out_index]. The slot is protected by a
+    // seqlock, so this is safe to call while another thread decodes frames and never blocks
+    // that thread.
+    void read_joint_state_slot(JointState& out, size_t out_index) const;
+    // Same, but only position, velocity and torque
+    void read_joint_state_slot(double& position, double& velocity, double& torque) const;
+
+    // Round trip instrumentation: the first frame received after mark_command_sent() is
+    // recorded as the reply to that command
+    void mark_command_sent();
+    const canbus::LatencyHistogram& get_round_trip_histogram() const {
+        return round_trip_histogram_;
+    }
+    void reset_round_trip_histogram() { round_trip_histogram_.reset(); }
+
+    // Parameter queries
+    // Replies to the RIDs marked here are decoded as parameters in every callback mode, so
+    // state frames keep decoding while parameters load. Marking and decoding may happen on
+    // different threads.
+    void mark_param_query_sent(int rid);
+    bool is_param_query_outstanding(int rid) const;
+    void cancel_param_query(int rid);
 
 private:
-    std::vector<uint8_t> get_data_from_frame(const can_frame& frame);
-    std::vector<uint8_t> get_data_from_frame(const canfd_frame& frame);
+    void update_state(const StateResult& result, const canbus::CANFrameTimestamp& timestamp);
+    void record_reply(const canbus::CANFrameTimestamp& timestamp);
+    bool try_decode_param_reply(const uint8_t* data, size_t len);
+
     Motor& motor_;
+    JointState* joint_state_ = nullptr;
+    size_t joint_state_index_ = 0;
+    // Seqlock for the joint state slot: odd while an update is in progress
+    std::atomic<uint32_t> joint_state_seq_{0};
     CallbackMode callback_mode_;
     bool use_fd_;  // Track if using CAN-FD
+    // steady_clock time of the last unanswered command in ns (0: none)
+    std::atomic<int64_t> command_sent_ns_{0};
+    canbus::LatencyHistogram round_trip_histogram_;
+    // Bitmap of the RIDs with an unanswered query
+    static constexpr size_t PARAM_QUERY_WORDS = (static_cast<size_t>(RID::COUNT) + 63) / 64;
+    std::array<std::atomic<uint64_t>, PARAM_QUERY_WORDS> outstanding_param_queries_{};
 };
 }  // namespace openarm::damiao_motor
@@ -14,21 +14,51 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <memory>
+#include <optional>
+#include <utility>
 #include <vector>
 
 #include "../canbus/can_device_collection.hpp"
+#include "dm_joint_state.hpp"
 #include "dm_motor_constants.hpp"
 #include "dm_motor_control.hpp"
 #include "dm_motor_device.hpp"
 
 namespace openarm::damiao_motor {
 
+// How MIT commands are framed on a CAN-FD bus
+enum class FramingMode {
+    // one frame per motor (what stock Damiao firmware understands)
+    PER_MOTOR,
+    // the 8-byte MIT payloads of up to 8 motors share one 64-byte frame, and the motors
+    // answer with one aggregated state frame in the same slot layout
+    PACKED
+};
+
+// Describes the packed framing of firmware that supports it. Packed frame k carries the
+// motors at indices [8k, 8k + 8) (see DMDeviceCollection::get_dm_devices()), is sent to
+// send_can_id + k and answered on recv_can_id + k.
+struct PackedFramingConfig {
+    canid_t send_can_id = 0;
+    canid_t recv_can_id = 0;
+    // Oldest firmware (sw_ver, then sub_ver) that implements it
+    uint32_t min_sw_ver = 0;
+    uint32_t min_sub_ver = 0;
+};
+
 class DMDeviceCollection {
 public:
     DMDeviceCollection(canbus::CANSocket& can_socket);
     virtual ~DMDeviceCollection() = default;
 
+    // Register a motor device. Devices added to or removed from get_device_collection()
+    // directly are picked up as well.
+    void add_device(const std::shared_ptr<DMCANDevice>& dm_device);
+    void remove_device(const std::shared_ptr<DMCANDevice>& dm_device);
+
     // Common motor operations
     void enable_all();
     void disable_all();
@@ -46,18 +76,95 @@ public:
     void query_param_one(int i, int RID);
     void query_param_all(int RID);
 
+    // Pipelined parameter reads
+    // queue_param_queries_all() queues one query per RID and motor. pump_param_queries()
+    // keeps up to max_in_flight of them unanswered per motor, retransmits queries that got
+    // no reply within timeout and gives up after max_attempts. Replies are decoded in any
+    // callback mode (see DMCANDevice::mark_param_query_sent()), so state frames keep
+    // decoding, and land in Motor::get_param().
+    void queue_param_queries_all(const std::vector<int>& rids);
+    // Add queries for motor i to the ones already queued
+    void queue_param_queries(int i, const std::vector<int>& rids);
+    // Returns the number of queries still queued or unanswered, 0 once everything is done
+    size_t pump_param_queries(size_t max_in_flight, std::chrono::microseconds timeout,
+                              int max_attempts = 3);
+    bool has_param_queries() const;
+    void cancel_param_queries();
+    // (motor index, RID) of the queries given up since the last queue_param_queries_all()
+    // or clear_failed_param_queries()
+    const std::vector<std::pair<int, int>>& get_failed_param_queries() const {
+        return failed_param_queries_;
+    }
+    void clear_failed_param_queries() { failed_param_queries_.clear(); }
+
     // MIT control operations
     void mit_control_one(int i, const MITParam& mit_param);
     void mit_control_all(const std::vector<MITParam>& mit_params);
+    // Same from structure-of-arrays input (e.g. NumPy buffers), entry i goes to motor i.
+    // Allocation-free, count must not exceed the number of motors.
+    void mit_control_all(const double* kp, const double* kd, const double* q, const double* dq,
+                         const double* tau, size_t count);
 
     // PosVel control operation
     void posvel_control_one(int i, const PosVelParam& posvel_param);
     void posvel_control_all(const std::vector<PosVelParam>& posvel_params);
 
+    // Packed CAN-FD framing
+    // Needs a CAN-FD socket and has to be configured after the motors were added. Devices
+    // receiving the aggregated replies are added to get_device_collection() and returned by
+    // get_packed_reply_devices(). The framing mode stays PER_MOTOR until set_framing_mode()
+    // or select_framing_mode() changes it.
+    static constexpr size_t PACKED_SLOTS_PER_FRAME = CANFD_MAX_DLEN / 8;
+    void set_packed_framing(const PackedFramingConfig& config);
+    const std::vector<std::shared_ptr<canbus::CANDevice>>& get_packed_reply_devices() const {
+        return packed_reply_devices_;
+    }
+    void set_framing_mode(FramingMode framing_mode);
+    FramingMode get_framing_mode() const { return framing_mode_; }
+    // Whether every motor reported a firmware version (sw_ver and sub_ver, read with
+    // query_param_all() in PARAM callback mode) that supports packed framing
+    bool supports_packed_framing() const;
+    // PACKED if supports_packed_framing(), PER_MOTOR otherwise
+    FramingMode select_framing_mode();
+    // Decode an aggregated state reply, called by the packed reply devices
+    void dispatch_packed_state(size_t frame_index, const canfd_frame& frame,
+                               const canbus::CANFrameTimestamp& timestamp);
+
+    // Expected-reply tracking
+    // Every command the firmware answers (enable, disable, set zero, refresh, MIT, posvel
+    // and param query) marks the motors it addresses as pending. A motor stops being
+    // pending once a frame with its recv_can_id is received. Given a kernel receive time
+    // (CANFrameTimestamp::software_ns, 0 if unknown), frames received before the command
+    // was issued are left alone: they answer an earlier command.
+    bool has_pending_replies() const { return pending_reply_count_ > 0; }
+    std::vector<int> get_pending_replies() const;
+    // Returns true if the motor with recv_can_id was pending
+    bool clear_pending_reply(canid_t recv_can_id, int64_t received_ns = 0);
+    void clear_pending_replies();
+    // Mark every motor pending, e.g. to wait until each motor replied to frames sent outside
+    // this collection
+    void set_pending_replies_all();
+    // Restart the reply clock (and round trip measurement) of every pending motor, for
+    // commands that were held in a batch and only went out now, as in ControlLoop
+    void restamp_pending_replies();
+
+    // Bulk state snapshot into caller-owned buffers. Allocation-free once out has been sized
+    // by a previous call. Each joint is read consistently even while another thread (e.g. the
+    // OpenArm receiver) is decoding frames.
+    void read_state(JointState& out) const;
+    // Position, velocity and torque of the first count joints into plain arrays (e.g. NumPy
+    // buffers). count must not exceed the number of motors.
+    void read_state(double* positions, double* velocities, double* torques, size_t count) const;
+    // Live joint state buffers, updated in place as state frames are decoded. Use
+    // read_state() instead when frames are decoded on another thread.
+    const JointState& get_joint_state() const { return joint_state_; }
+
     // Device collection access
     std::vector<Motor> get_motors() const;
     Motor get_motor(int i) const;
     canbus::CANDeviceCollection& get_device_collection() { return *device_collection_; }
+    // Devices in recv_can_id order, the index used by the *_one() methods
+    const std::vector<DMCANDevice*>& get_dm_devices() const { return dm_devices_; }
 
 protected:
     canbus::CANSocket& can_socket_;
@@ -66,7 +173,43 @@ protected:
     std::unique_ptr<canbus::CANDeviceCollection> device_collection_;
 
     // Helper methods for subclasses
-    void send_command_to_device(std::shared_ptr<DMCANDevice> dm_device, const CANPacket& packet);
-    std::vector<std::shared_ptr<DMCANDevice>> get_dm_devices() const;
+    void send_command_to_device(DMCANDevice& dm_device, const CANPacket& packet);
+    void send_command_to_device(DMCANDevice& dm_device, const FixedCANPacket& packet);
+    void send_command_to_device(DMCANDevice& dm_device, canid_t send_can_id, const uint8_t* data,
+                                size_t len);
+    void set_pending_reply(int i);
+    void set_pending_reply(int i, int64_t since_ns);
+
+    // Non-owning, index-ordered view of the devices in device_collection_. Only rebuilt when
+    // device_collection_ changes so the hot path never walks the map.
+    std::vector<DMCANDevice*> dm_devices_;
+    void update_dm_devices();
+
+    // Structure-of-arrays joint state, one slot per entry of dm_devices_
+    JointState joint_state_;
+
+    // Packed framing
+    std::optional<PackedFramingConfig> packed_framing_;
+    FramingMode framing_mode_ = FramingMode::PER_MOTOR;
+    std::vector<std::shared_ptr<canbus::CANDevice>> packed_reply_devices_;
+    template <typename GetMITParam>
+    void send_packed_mit_control(size_t count, GetMITParam get_mit_param);
+
+    // Parameter query engine, indexed like get_dm_devices()
+    struct ParamQueryState {
+        std::vector<int> queued;
+        size_t next_queued = 0;
+        std::vector<int> in_flight;
+        std::array<int64_t, static_cast<size_t>(RID::COUNT)> sent_ns{};
+        std::array<uint8_t, static_cast<size_t>(RID::COUNT)> attempts{};
+    };
+    std::vector<ParamQueryState> param_queries_;
+    std::vector<std::pair<int, int>> failed_param_queries_;
+
+    // Pending reply bitmap indexed like get_dm_devices(), with the steady_clock time in ns
+    // each motor became pending
+    std::vector<bool> pending_replies_;
+    std::vector<int64_t> pending_since_ns_;
+    size_t pending_reply_count_ = 0;
 };
 }  // namespace openarm::damiao_motor
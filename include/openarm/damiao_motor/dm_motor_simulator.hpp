@@ -0,0 +1,174 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../canbus/can_transport.hpp"
+#include "dm_motor_constants.hpp"
+#include "dm_motor_control.hpp"
+
+namespace openarm::damiao_motor {
+
+struct DMSimulatedMotorConfig {
+    MotorType motor_type;
+    uint32_t send_can_id;
+    uint32_t recv_can_id;
+};
+
+struct DMMotorSimulatorConfig {
+    std::string interface = "dm-sim";
+    bool enable_fd = false;
+    // Time from the end of a command on the bus until the motor starts its reply
+    std::chrono::microseconds reply_latency{150};
+    // Extra latency drawn uniformly from [0, reply_jitter] per reply, so replies of
+    // different motors may arrive out of order
+    std::chrono::microseconds reply_jitter{0};
+    // Probability (0-1) that a motor does not answer a command
+    double reply_loss = 0.0;
+    uint64_t seed = 1;
+    // Joint dynamics: with joint_inertia > 0 every joint is a rotating mass driven by the MIT
+    // law tau + kp * (q - position) + kd * (dq - velocity), clamped to the motor's torque
+    // limit, against viscous damping. With joint_inertia == 0 joints follow commands ideally.
+    double joint_inertia = 0.0;  // kg*m^2
+    double joint_damping = 0.0;  // N*m*s/rad
+    // Integration step of the joint dynamics
+    std::chrono::microseconds dynamics_step{100};
+    // Bus timing of commands and replies, see canbus::frame_duration_ns()
+    uint32_t bitrate = 1000000;
+    uint32_t data_bitrate = 0;
+};
+
+// What a simulated motor currently reports
+struct DMSimulatedMotorState {
+    bool enabled = false;
+    double position = 0.0;
+    double velocity = 0.0;
+    double torque = 0.0;
+    int t_mos = 25;
+    int t_rotor = 25;
+    // commands addressed to this motor
+    uint64_t commands = 0;
+};
+
+struct DMMotorSimulatorStats {
+    uint64_t commands = 0;
+    uint64_t replies = 0;
+    // replies dropped by reply_loss
+    uint64_t lost_replies = 0;
+};
+
+// A bank of Damiao motors on one simulated bus, usable wherever a SocketCAN interface is,
+// e.g. OpenArm(std::make_unique<DMMotorSimulator>(...)). Answers enable/disable/set-zero,
+// MIT, pos-vel, refresh and parameter read/write frames like the firmware does. Each reply
+// is sent reply_latency (plus jitter) after its command left the bus and becomes receivable
+// once it left the bus itself; commands and replies share one bus timeline, so a saturated
+// bus shows up as growing latency. Without joint dynamics the joints follow commands
+// ideally: with kp > 0 an MIT command puts the joint at q, otherwise it moves at dq.
+// Pos-vel commands always put the joint at q.
+class DMMotorSimulator : public canbus::CANTransport {
+public:
+    explicit DMMotorSimulator(const std::vector<DMSimulatedMotorConfig>& motors,
+                              const DMMotorSimulatorConfig& config = DMMotorSimulatorConfig());
+    ~DMMotorSimulator() override;
+
+    DMMotorSimulator(const DMMotorSimulator&) = delete;
+    DMMotorSimulator& operator=(const DMMotorSimulator&) = delete;
+
+    const std::string& get_interface() const override { return config_.interface; }
+    bool is_canfd_enabled() const override { return config_.enable_fd; }
+    // timerfd armed for the next reply
+    int get_fd() const override { return timer_fd_; }
+
+    size_t send(const can_frame* frames, size_t count) override;
+    size_t send(const canfd_frame* frames, size_t count) override;
+    int try_send(const canbus::TxFrame* frames, size_t count) override;
+    size_t receive(can_frame* frames, canbus::CANFrameTimestamp* timestamps, size_t max_count,
+                   canbus::CANReceiveInfo& info) override;
+    size_t receive(canfd_frame* frames, canbus::CANFrameTimestamp* timestamps,
+                   size_t max_count, canbus::CANReceiveInfo& info) override;
+
+    // SOFTWARE stamps replies with the time they became receivable
+    bool enable_timestamping(canbus::TimestampMode mode) override;
+    // Replies always come from the simulated motors, which are all accepted
+    bool set_filters(const std::vector<can_filter>& /*filters*/) override { return true; }
+
+    size_t size() const { return motors_.size(); }
+    DMSimulatedMotorState get_motor_state(size_t i) const;
+    // Value a parameter read of RID returns, defaults come from the motor configuration
+    void set_param(size_t i, int rid, double value);
+    // Replies queued but not received yet
+    size_t pending_replies() const;
+    DMMotorSimulatorStats get_stats() const;
+
+private:
+    struct SimulatedMotor {
+        DMSimulatedMotorConfig config;
+        DMSimulatedMotorState state;
+        int64_t updated_ns = 0;
+        // Last MIT command, drives the joint dynamics
+        MITParam command{0, 0, 0, 0, 0};
+        std::array<double, static_cast<size_t>(RID::COUNT)> params;
+    };
+    struct PendingReply {
+        int64_t ready_ns;
+        uint64_t sequence;
+        canfd_frame frame;
+        size_t size;
+    };
+    static bool later(const PendingReply& a, const PendingReply& b);
+
+    DMMotorSimulatorConfig config_;
+    std::vector<SimulatedMotor> motors_;
+    // send_can_id -> index into motors_
+    std::map<uint32_t, size_t> motor_index_;
+    int timer_fd_ = -1;
+    bool timestamping_ = false;
+
+    // send() and receive() may run on different threads
+    mutable std::mutex mutex_;
+    // Binary heap ordered by ready_ns
+    std::vector<PendingReply> pending_;
+    uint64_t next_sequence_ = 0;
+    int64_t bus_free_ns_ = 0;
+    // When each frame of the batch being sent ends on the bus
+    std::vector<int64_t> batch_end_ns_;
+    std::mt19937_64 rng_;
+    DMMotorSimulatorStats stats_;
+
+    template <typename Frame>
+    size_t send_frames(const Frame* frames, size_t count);
+    void handle_frame(uint32_t can_id, const uint8_t* data, size_t len, int64_t ready_ns);
+    SimulatedMotor* find_motor(uint32_t send_can_id);
+    void advance(SimulatedMotor& motor, int64_t now_ns);
+    void integrate(SimulatedMotor& motor, double dt);
+    // Draw loss and jitter for a reply to a command, false if the reply is lost
+    bool reply_ready_ns(int64_t& ready_ns);
+    void queue_state_reply(const SimulatedMotor& motor, int64_t ready_ns);
+    void queue_reply(uint32_t can_id, const std::array<uint8_t, 8>& data, int64_t ready_ns);
+    template <typename Frame>
+    size_t receive_frames(Frame* frames, canbus::CANFrameTimestamp* timestamps,
+                          size_t max_count, canbus::CANReceiveInfo& info);
+    void arm_timer();
+};
+
+}  // namespace openarm::damiao_motor
@@ -23,6 +23,8 @@ Source:         https://github.com/enactic/openarm_can/archive/%{version}/openar
 
 BuildRequires:  cmake
 BuildRequires:  gcc-c++
+BuildRequires:  liburing-devel
+BuildRequires:  pkgconfig
 
 %description
 A C++ library for CAN communication with OpenArm robotic hardware,
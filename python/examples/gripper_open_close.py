@@ -13,6 +13,7 @@ Slow open/close gripper with OpenArm CAN Library (SocketCAN).
 import time
 import signal
 import sys
+from datetime import timedelta
 import openarm_can as oa
 
 # ----------- 用户需要按实际硬件修改的配置 -----------
@@ -69,46 +70,44 @@ def lerp(a: float, b: float, t: float) -> float:
 def move_gripper_slow(openarm: oa.OpenArm, q_from: float, q_to: float, duration_s: float):
     """
     缓慢移动夹爪：把目标位置从 q_from 平滑插值到 q_to。
-    每一步都发 MIT 控制，并 recv_all + sleep，保证动作慢且通信稳定。
+    由库里的 ControlLoop 定频调度：每个周期开始时发出上个周期排队的 MIT 命令，
+    收回包并更新状态，然后调用 on_tick 计算下一条命令，不会像 sleep 那样漂移。
     """
     gripper = openarm.get_gripper()
 
     steps = max(1, int(duration_s * CONTROL_HZ))
     start_t = time.perf_counter()
 
-    for i in range(steps + 1):
+    config = oa.ControlLoopConfig()
+    config.period = timedelta(seconds=DT)
+    config.rx_timeout = timedelta(microseconds=FAST_TIMEOUT_US)
+    loop = oa.ControlLoop(openarm, config)
+
+    def on_tick(tick: oa.ControlTick) -> bool:
         if _stop:
-            return
+            return False
 
-        loop_start = time.perf_counter()
+        # 打印上个命令的回包状态
+        if tick.index > 0:
+            positions = loop.get_gripper_state().positions
+            print(f"[state] pos={positions[0]:.3f} timed_out={tick.timed_out}")
 
-        t = i / steps
+        t = min(tick.index, steps) / steps
         q_cmd = lerp(q_from, q_to, t)
 
         # 关键：STATE 模式下，mit_control_all() 的回包应按状态解析
-        # 对夹爪只有一个电机，所以传入单个 MITParam
+        # 对夹爪只有一个电机，所以传入单个 MITParam；命令在下个周期开始时发出
         gripper.mit_control_all([
             oa.MITParam(KP, KD, q_cmd, 0.0, TAU_FF)
         ])
+        return tick.index < steps
 
-        # 关键：控制命令后立刻 recv，处理电机回包并更新状态
-        recv_all(openarm, FAST_TIMEOUT_US, note=f"mit q={q_cmd:.3f}")
-
-        # 可选：打印当前位置（需要你的绑定提供 get_position）
-        try:
-            m = gripper.get_motors()[0]
-            print(f"[state] target={q_cmd:.3f} pos={m.get_position():.3f}")
-        except Exception:
-            pass
-
-        # 限频：保证循环频率不超过设定（文档强调电机多时不要太快）
-        elapsed = time.perf_counter() - loop_start
-        remain = DT - elapsed
-        if remain > 0:
-            time.sleep(remain)
+    loop.run(on_tick)
 
     total = time.perf_counter() - start_t
-    print(f"[move] done in {total:.2f}s ({steps} steps @ {CONTROL_HZ}Hz)")
+    stats = loop.get_stats()
+    print(f"[move] done in {total:.2f}s ({steps} steps @ {CONTROL_HZ}Hz, "
+          f"overruns={stats.overruns})")
 
 def main():
     print("[1] Create OpenArm")
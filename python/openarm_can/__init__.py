@@ -31,6 +31,13 @@ __all__ = [
     "MotorType",
     "MotorVariable",
     "CallbackMode",
+    "ControlMode",
+    "InterpolationMode",
+    "TimestampMode",
+    "ReceiveStrategy",
+    "FramingMode",
+    "FrameDirection",
+    "PackedFramingConfig",
 
     # Data structures
     "LimitParam",
@@ -39,6 +46,33 @@ __all__ = [
     "CanFrame",
     "CanFdFrame",
     "MITParam",
+    "JointState",
+    "ThreadConfig",
+    "ReceiverConfig",
+    "PipelineConfig",
+    "ParamCache",
+    "ParamLoadResult",
+    "CycleConfig",
+    "CycleResult",
+    "ReceiveStrategyConfig",
+    "TxSchedulerConfig",
+    "TxSchedulerStats",
+    "HistogramSnapshot",
+    "CANSocketStats",
+    "MotorLatencyStats",
+    "OpenArmStats",
+    "FrameRecorderConfig",
+    "FrameRecorderStats",
+    "FrameLogRecord",
+    "ReplayStats",
+    "ControlLoopConfig",
+    "ControlTick",
+    "ControlLoopStats",
+    "TrajectoryPoint",
+    "TrajectoryStreamerConfig",
+    "TrajectoryStreamerStats",
+    "SimulatedMotorConfig",
+    "MotorSimulatorConfig",
 
     # Main C++ classes (1:1 mapping)
     "Motor",
@@ -47,6 +81,12 @@ __all__ = [
     "CANDevice",           # Base CAN device class
     "MotorDeviceCan",      # Motor device management
     "CANDeviceCollection",  # Device collection management
+    "MultiArmExecutor",    # Several buses driven from one epoll loop
+    "ControlLoop",         # Fixed-rate real-time control loop
+    "TrajectoryStreamer",  # Interpolates uploaded waypoints on a real-time thread
+    "CommandSlots",        # Per-joint setpoints from several threads, one bus owner
+    "FrameLogReader",      # Memory-mapped view of a recorded frame log
+    "FrameReplayer",       # Replays a frame log through a device collection
 
     # Exceptions
     "CANSocketException",
@@ -13,24 +13,43 @@
 // limitations under the License.
 
 #include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/array.h>
+#include <nanobind/stl/chrono.h>
+#include <nanobind/stl/function.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/pair.h>
 #include <nanobind/stl/string.h>
+#include <nanobind/stl/unique_ptr.h>
 #include <nanobind/stl/vector.h>
 
 // Include the C++ headers
 #include <linux/can.h>
 #include <linux/can/raw.h>
 
+#include <cstring>
 #include <openarm/can/socket/arm_component.hpp>
+#include <openarm/can/socket/command_slots.hpp>
+#include <openarm/can/socket/control_loop.hpp>
 #include <openarm/can/socket/gripper_component.hpp>
+#include <openarm/can/socket/multi_arm_executor.hpp>
 #include <openarm/can/socket/openarm.hpp>
+#include <openarm/can/socket/param_cache.hpp>
+#include <openarm/can/socket/realtime.hpp>
+#include <openarm/can/socket/trajectory_streamer.hpp>
 #include <openarm/canbus/can_device.hpp>
 #include <openarm/canbus/can_device_collection.hpp>
 #include <openarm/canbus/can_socket.hpp>
+#include <openarm/canbus/frame_log.hpp>
+#include <openarm/canbus/latency_histogram.hpp>
+#include <openarm/canbus/tx_scheduler.hpp>
+#include <openarm/damiao_motor/dm_joint_state.hpp>
 #include <openarm/damiao_motor/dm_motor.hpp>
 #include <openarm/damiao_motor/dm_motor_constants.hpp>
 #include <openarm/damiao_motor/dm_motor_control.hpp>
 #include <openarm/damiao_motor/dm_motor_device.hpp>
 #include <openarm/damiao_motor/dm_motor_device_collection.hpp>
+#include <openarm/damiao_motor/dm_motor_simulator.hpp>
 
 using namespace openarm::canbus;
 using namespace openarm::damiao_motor;
@@ -38,6 +57,30 @@ using namespace openarm::can::socket;
 
 namespace nb = nanobind;
 
+namespace {
+// Zero-copy 1-D NumPy view over a std::vector owned by the Python object owner
+template <typename T>
+nb::ndarray<nb::numpy, T, nb::ndim<1>> numpy_view(std::vector<T>& values, nb::handle owner) {
+    return nb::ndarray<nb::numpy, T, nb::ndim<1>>(values.data(), {values.size()}, owner);
+}
+
+// 1-D float64 NumPy inputs/outputs of the bulk APIs, read and written in place. Output
+// arguments must be .noconvert(): an implicitly converted copy would swallow the results.
+using InputArray = nb::ndarray<const double, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+using OutputArray = nb::ndarray<double, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+
+template <typename... Arrays>
+size_t common_size(const char* what, const Arrays&... arrays) {
+    size_t sizes[] = {arrays.shape(0)...};
+    for (size_t size : sizes) {
+        if (size != sizes[0]) {
+            throw std::invalid_argument(std::string(what) + ": arrays must have the same shape");
+        }
+    }
+    return sizes[0];
+}
+}  // namespace
+
 NB_MODULE(openarm_can, m) {
     m.doc() = "OpenArm CAN Python bindings for motor control via SocketCAN";
 
@@ -120,10 +163,38 @@ NB_MODULE(openarm_can, m) {
         .value("IGNORE", CallbackMode::IGNORE)
         .export_values();
 
+    nb::enum_<ControlMode>(m, "ControlMode")
+        .value("MIT", ControlMode::MIT)
+        .value("POS_VEL", ControlMode::POS_VEL)
+        .value("VEL", ControlMode::VEL)
+        .value("TORQUE_POS", ControlMode::TORQUE_POS);
+
+    nb::enum_<FramingMode>(m, "FramingMode")
+        .value("PER_MOTOR", FramingMode::PER_MOTOR)
+        .value("PACKED", FramingMode::PACKED);
+
+    nb::enum_<TimestampMode>(m, "TimestampMode")
+        .value("NONE", TimestampMode::NONE)
+        .value("SOFTWARE", TimestampMode::SOFTWARE)
+        .value("HARDWARE", TimestampMode::HARDWARE);
+
+    nb::enum_<ReceiveStrategy>(m, "ReceiveStrategy")
+        .value("BLOCKING", ReceiveStrategy::BLOCKING)
+        .value("SPIN_THEN_BLOCK", ReceiveStrategy::SPIN_THEN_BLOCK)
+        .value("BUSY_POLL", ReceiveStrategy::BUSY_POLL);
+
     // ============================================================================
     // DAMIAO MOTOR NAMESPACE - STRUCTS
     // ============================================================================
 
+    // PackedFramingConfig struct
+    nb::class_<PackedFramingConfig>(m, "PackedFramingConfig")
+        .def(nb::init<>())
+        .def_rw("send_can_id", &PackedFramingConfig::send_can_id)
+        .def_rw("recv_can_id", &PackedFramingConfig::recv_can_id)
+        .def_rw("min_sw_ver", &PackedFramingConfig::min_sw_ver)
+        .def_rw("min_sub_ver", &PackedFramingConfig::min_sub_ver);
+
     // LimitParam struct
     nb::class_<LimitParam>(m, "LimitParam")
         .def(nb::init<>())
@@ -180,6 +251,30 @@ NB_MODULE(openarm_can, m) {
             nb::arg("q"), nb::arg("dq"))
         .def_rw("q", &PosVelParam::q)
         .def_rw("dq", &PosVelParam::dq);
+    // JointState struct (structure-of-arrays, exposed as zero-copy NumPy views)
+    nb::class_<JointState>(m, "JointState")
+        .def(nb::init<>())
+        .def("size", &JointState::size)
+        .def("resize", &JointState::resize, nb::arg("n"))
+        .def_prop_ro("positions",
+                     [](JointState& self) { return numpy_view(self.positions, nb::find(self)); })
+        .def_prop_ro("velocities",
+                     [](JointState& self) { return numpy_view(self.velocities, nb::find(self)); })
+        .def_prop_ro("torques",
+                     [](JointState& self) { return numpy_view(self.torques, nb::find(self)); })
+        .def_prop_ro("t_mos",
+                     [](JointState& self) { return numpy_view(self.t_mos, nb::find(self)); })
+        .def_prop_ro("t_rotor",
+                     [](JointState& self) { return numpy_view(self.t_rotor, nb::find(self)); })
+        .def_prop_ro(
+            "timestamps_ns",
+            [](JointState& self) { return numpy_view(self.timestamps_ns, nb::find(self)); })
+        .def_prop_ro(
+            "hw_timestamps_ns",
+            [](JointState& self) { return numpy_view(self.hw_timestamps_ns, nb::find(self)); })
+        .def_prop_ro("sequences",
+                     [](JointState& self) { return numpy_view(self.sequences, nb::find(self)); });
+
     // ============================================================================
     // DAMIAO MOTOR NAMESPACE - MAIN CLASSES
     // ============================================================================
@@ -193,11 +288,15 @@ NB_MODULE(openarm_can, m) {
         .def("get_torque", &Motor::get_torque)
         .def("get_state_tmos", &Motor::get_state_tmos)
         .def("get_state_trotor", &Motor::get_state_trotor)
+        .def("get_state_timestamp_ns", &Motor::get_state_timestamp_ns)
+        .def("get_state_hw_timestamp_ns", &Motor::get_state_hw_timestamp_ns)
         .def("get_send_can_id", &Motor::get_send_can_id)
         .def("get_recv_can_id", &Motor::get_recv_can_id)
         .def("get_motor_type", &Motor::get_motor_type)
         .def("is_enabled", &Motor::is_enabled)
         .def("get_param", &Motor::get_param, nb::arg("rid"))
+        .def("get_limits", &Motor::get_limits)
+        .def("set_limits", &Motor::set_limits, nb::arg("limits"))
         .def_static("get_limit_param", &Motor::get_limit_param, nb::arg("motor_type"));
 
     // MotorControl class
@@ -219,9 +318,13 @@ NB_MODULE(openarm_can, m) {
                     nb::arg("motor"), nb::arg("rid"));
 
     nb::class_<CanPacketDecoder>(m, "CanPacketDecoder")
-        .def_static("parse_motor_state_data", &CanPacketDecoder::parse_motor_state_data,
+        .def_static("parse_motor_state_data",
+                    static_cast<StateResult (*)(const Motor&, const std::vector<uint8_t>&)>(
+                        &CanPacketDecoder::parse_motor_state_data),
                     nb::arg("motor"), nb::arg("data"))
-        .def_static("parse_motor_param_data", &CanPacketDecoder::parse_motor_param_data,
+        .def_static("parse_motor_param_data",
+                    static_cast<ParamResult (*)(const std::vector<uint8_t>&)>(
+                        &CanPacketDecoder::parse_motor_param_data),
                     nb::arg("data"));
 
     // ============================================================================
@@ -249,10 +352,14 @@ NB_MODULE(openarm_can, m) {
         .def("callback",
              static_cast<void (DMCANDevice::*)(const canfd_frame&)>(&DMCANDevice::callback),
              nb::arg("frame"))
-        .def("create_can_frame", &DMCANDevice::create_can_frame, nb::arg("send_can_id"),
-             nb::arg("data"))
-        .def("create_canfd_frame", &DMCANDevice::create_canfd_frame, nb::arg("send_can_id"),
-             nb::arg("data"))
+        .def("create_can_frame",
+             static_cast<can_frame (DMCANDevice::*)(canid_t, const std::vector<uint8_t>&)>(
+                 &DMCANDevice::create_can_frame),
+             nb::arg("send_can_id"), nb::arg("data"))
+        .def("create_canfd_frame",
+             static_cast<canfd_frame (DMCANDevice::*)(canid_t, const std::vector<uint8_t>&)>(
+                 &DMCANDevice::create_canfd_frame),
+             nb::arg("send_can_id"), nb::arg("data"))
         .def("set_callback_mode", &DMCANDevice::set_callback_mode, nb::arg("callback_mode"));
 
     // CANDeviceCollection class
@@ -271,14 +378,47 @@ NB_MODULE(openarm_can, m) {
             },
             nb::arg("device"))
         .def("dispatch_frame_callback",
-             static_cast<void (CANDeviceCollection::*)(can_frame&)>(
+             static_cast<bool (CANDeviceCollection::*)(can_frame&)>(
                  &CANDeviceCollection::dispatch_frame_callback),
              nb::arg("frame"))
         .def("dispatch_frame_callback",
-             static_cast<void (CANDeviceCollection::*)(canfd_frame&)>(
+             static_cast<bool (CANDeviceCollection::*)(canfd_frame&)>(
                  &CANDeviceCollection::dispatch_frame_callback),
              nb::arg("frame"))
-        .def("get_devices", &CANDeviceCollection::get_devices);
+        .def("get_devices", &CANDeviceCollection::get_devices)
+        .def("get_unmatched_frame_count", &CANDeviceCollection::get_unmatched_frame_count)
+        .def("reset_unmatched_frame_count", &CANDeviceCollection::reset_unmatched_frame_count)
+        .def("get_filters",
+             [](const CANDeviceCollection& self) {
+                 std::vector<std::pair<canid_t, canid_t>> filters;
+                 for (const can_filter& filter : self.get_filters()) {
+                     filters.emplace_back(filter.can_id, filter.can_mask);
+                 }
+                 return filters;
+             })
+        .def("set_kernel_filtering", &CANDeviceCollection::set_kernel_filtering,
+             nb::arg("enable"))
+        .def("is_kernel_filtering", &CANDeviceCollection::is_kernel_filtering);
+
+    // TxSchedulerConfig struct
+    nb::class_<ReceiveStrategyConfig>(m, "ReceiveStrategyConfig")
+        .def(nb::init<>())
+        .def_rw("strategy", &ReceiveStrategyConfig::strategy)
+        .def_rw("spin_duration", &ReceiveStrategyConfig::spin_duration)
+        .def_rw("socket_busy_poll_us", &ReceiveStrategyConfig::socket_busy_poll_us);
+
+    nb::class_<TxSchedulerConfig>(m, "TxSchedulerConfig")
+        .def(nb::init<>())
+        .def_rw("bitrate", &TxSchedulerConfig::bitrate)
+        .def_rw("data_bitrate", &TxSchedulerConfig::data_bitrate)
+        .def_rw("max_backlog", &TxSchedulerConfig::max_backlog)
+        .def_rw("max_wait", &TxSchedulerConfig::max_wait)
+        .def_rw("initial_backoff", &TxSchedulerConfig::initial_backoff)
+        .def_rw("max_backoff", &TxSchedulerConfig::max_backoff)
+        .def_rw("max_queue_size", &TxSchedulerConfig::max_queue_size)
+        .def_rw("merge_by_id", &TxSchedulerConfig::merge_by_id)
+        .def_rw("shared_id", &TxSchedulerConfig::shared_id)
+        .def_rw("utilization_window", &TxSchedulerConfig::utilization_window);
 
     // CAN Socket class
     nb::class_<CANSocket>(m, "CANSocket")
@@ -310,7 +450,43 @@ NB_MODULE(openarm_can, m) {
         .def("write_can_frame", &CANSocket::write_can_frame, nb::arg("frame"))
         .def("read_can_frame", &CANSocket::read_can_frame, nb::arg("frame"))
         .def("write_canfd_frame", &CANSocket::write_canfd_frame, nb::arg("frame"))
-        .def("read_canfd_frame", &CANSocket::read_canfd_frame, nb::arg("frame"));
+        .def(
+            "write_can_frames",
+            [](CANSocket& self, const std::vector<can_frame>& frames) {
+                return self.write_can_frames(frames.data(), frames.size());
+            },
+            nb::arg("frames"))
+        .def(
+            "write_canfd_frames",
+            [](CANSocket& self, const std::vector<canfd_frame>& frames) {
+                return self.write_canfd_frames(frames.data(), frames.size());
+            },
+            nb::arg("frames"))
+        .def("read_canfd_frame", &CANSocket::read_canfd_frame, nb::arg("frame"))
+        .def("enable_timestamping", &CANSocket::enable_timestamping, nb::arg("mode"))
+        .def("set_receive_strategy", &CANSocket::set_receive_strategy, nb::arg("config"))
+        .def("get_receive_strategy", &CANSocket::get_receive_strategy)
+        .def("get_timestamp_mode", &CANSocket::get_timestamp_mode)
+        .def(
+            "set_filters",
+            [](CANSocket& self, const std::vector<std::pair<canid_t, canid_t>>& filters) {
+                std::vector<can_filter> can_filters;
+                for (const auto& [can_id, can_mask] : filters) {
+                    can_filters.push_back({can_id, can_mask});
+                }
+                return self.set_filters(can_filters);
+            },
+            nb::arg("filters"))
+        .def("clear_filters", &CANSocket::clear_filters)
+        .def("set_loopback", &CANSocket::set_loopback, nb::arg("enable"))
+        .def("set_recv_own_msgs", &CANSocket::set_recv_own_msgs, nb::arg("enable"))
+        .def("enable_tx_scheduler", &CANSocket::enable_tx_scheduler,
+             nb::arg("config") = TxSchedulerConfig())
+        .def("disable_tx_scheduler", &CANSocket::disable_tx_scheduler)
+        .def("is_tx_scheduler_enabled", &CANSocket::is_tx_scheduler_enabled)
+        .def("flush_tx_queue", &CANSocket::flush_tx_queue)
+        .def("get_stats", &CANSocket::get_stats)
+        .def("reset_stats", &CANSocket::reset_stats);
 
     // ============================================================================
     // LINUX CAN FRAME STRUCTURES
@@ -358,21 +534,70 @@ NB_MODULE(openarm_can, m) {
     // GripperComponent)
     nb::class_<DMDeviceCollection>(m, "DMDeviceCollection")
         .def(nb::init<CANSocket&>(), nb::arg("can_socket"))
-        .def("enable_all", &DMDeviceCollection::enable_all)
-        .def("disable_all", &DMDeviceCollection::disable_all)
-        .def("set_zero_all", &DMDeviceCollection::set_zero_all)
-        .def("refresh_all", &DMDeviceCollection::refresh_all)
+        .def("enable_all", &DMDeviceCollection::enable_all,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("disable_all", &DMDeviceCollection::disable_all,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("set_zero_all", &DMDeviceCollection::set_zero_all,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("refresh_all", &DMDeviceCollection::refresh_all,
+             nb::call_guard<nb::gil_scoped_release>())
         .def("set_callback_mode_all", &DMDeviceCollection::set_callback_mode_all,
              nb::arg("callback_mode"))
-        .def("query_param_all", &DMDeviceCollection::query_param_all, nb::arg("rid"))
+        .def("query_param_all", &DMDeviceCollection::query_param_all, nb::arg("rid"),
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("queue_param_queries_all", &DMDeviceCollection::queue_param_queries_all,
+             nb::arg("rids"))
+        .def("pump_param_queries", &DMDeviceCollection::pump_param_queries,
+             nb::arg("max_in_flight"), nb::arg("timeout"), nb::arg("max_attempts") = 3,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("has_param_queries", &DMDeviceCollection::has_param_queries)
+        .def("cancel_param_queries", &DMDeviceCollection::cancel_param_queries)
+        .def("get_failed_param_queries", &DMDeviceCollection::get_failed_param_queries)
+        .def("clear_failed_param_queries", &DMDeviceCollection::clear_failed_param_queries)
         .def("mit_control_one", &DMDeviceCollection::mit_control_one, nb::arg("index"),
              nb::arg("mit_param"))
-        .def("mit_control_all", &DMDeviceCollection::mit_control_all, nb::arg("mit_params"))
+        .def("mit_control_all",
+             nb::overload_cast<const std::vector<MITParam>&>(&DMDeviceCollection::mit_control_all),
+             nb::arg("mit_params"), nb::call_guard<nb::gil_scoped_release>())
+        .def(
+            "mit_control_all",
+            [](DMDeviceCollection& self, InputArray kp, InputArray kd, InputArray q,
+               InputArray dq, InputArray tau) {
+                size_t count = common_size("mit_control_all", kp, kd, q, dq, tau);
+                nb::gil_scoped_release release;
+                self.mit_control_all(kp.data(), kd.data(), q.data(), dq.data(), tau.data(),
+                                     count);
+            },
+            nb::arg("kp"), nb::arg("kd"), nb::arg("q"), nb::arg("dq"), nb::arg("tau"))
         .def("posvel_control_one", &DMDeviceCollection::posvel_control_one, nb::arg("index"),
              nb::arg("posvel_param"))
         .def("posvel_control_all", &DMDeviceCollection::posvel_control_all,
-             nb::arg("posvel_params"))
+             nb::arg("posvel_params"), nb::call_guard<nb::gil_scoped_release>())
         .def("get_motors", &DMDeviceCollection::get_motors)
+        .def("read_state",
+             nb::overload_cast<JointState&>(&DMDeviceCollection::read_state, nb::const_),
+             nb::arg("out"))
+        .def(
+            "read_state",
+            [](const DMDeviceCollection& self, OutputArray positions, OutputArray velocities,
+               OutputArray torques) {
+                size_t count = common_size("read_state", positions, velocities, torques);
+                nb::gil_scoped_release release;
+                self.read_state(positions.data(), velocities.data(), torques.data(), count);
+            },
+            nb::arg("positions").noconvert(), nb::arg("velocities").noconvert(),
+            nb::arg("torques").noconvert())
+        .def("get_joint_state", &DMDeviceCollection::get_joint_state,
+             nb::rv_policy::reference_internal)
+        .def("has_pending_replies", &DMDeviceCollection::has_pending_replies)
+        .def("get_pending_replies", &DMDeviceCollection::get_pending_replies)
+        .def("set_packed_framing", &DMDeviceCollection::set_packed_framing, nb::arg("config"))
+        .def("set_framing_mode", &DMDeviceCollection::set_framing_mode,
+             nb::arg("framing_mode"))
+        .def("get_framing_mode", &DMDeviceCollection::get_framing_mode)
+        .def("supports_packed_framing", &DMDeviceCollection::supports_packed_framing)
+        .def("select_framing_mode", &DMDeviceCollection::select_framing_mode)
         .def("get_device_collection", &DMDeviceCollection::get_device_collection,
              nb::rv_policy::reference);
 
@@ -389,12 +614,208 @@ NB_MODULE(openarm_can, m) {
              nb::arg("send_can_id"), nb::arg("recv_can_id"), nb::arg("use_fd"))
         .def("open", &GripperComponent::open, nb::arg("kp") = 50.0, nb::arg("kd") = 1.0)
         .def("close", &GripperComponent::close, nb::arg("kp") = 50.0, nb::arg("kd") = 1.0)
+        .def("position_command", &GripperComponent::position_command,
+             nb::arg("gripper_position"), nb::arg("kp") = 50.0, nb::arg("kd") = 1.0)
         .def("get_motor", &GripperComponent::get_motor, nb::rv_policy::reference_internal);
 
+    // ThreadConfig struct
+    nb::class_<ThreadConfig>(m, "ThreadConfig")
+        .def(nb::init<>())
+        .def_rw("priority", &ThreadConfig::priority)
+        .def_rw("cpu", &ThreadConfig::cpu);
+
+    // ReceiverConfig struct
+    nb::class_<ReceiverConfig>(m, "ReceiverConfig")
+        .def(nb::init<>())
+        .def_rw("thread", &ReceiverConfig::thread)
+        .def_rw("poll_timeout_us", &ReceiverConfig::poll_timeout_us);
+
+    // PipelineConfig struct
+    nb::class_<PipelineConfig>(m, "PipelineConfig")
+        .def(nb::init<>())
+        .def_rw("tx_thread", &PipelineConfig::tx_thread)
+        .def_rw("rx_thread", &PipelineConfig::rx_thread)
+        .def_rw("tx_ring_size", &PipelineConfig::tx_ring_size)
+        .def_rw("rx_ring_size", &PipelineConfig::rx_ring_size)
+        .def_rw("poll_timeout_us", &PipelineConfig::poll_timeout_us);
+
+    // Parameter cache
+    nb::class_<CycleConfig>(m, "CycleConfig")
+        .def(nb::init<>())
+        .def_rw("reply_timeout", &CycleConfig::reply_timeout)
+        .def_rw("max_state_age", &CycleConfig::max_state_age)
+        .def_rw("disabled_max_state_age", &CycleConfig::disabled_max_state_age);
+
+    nb::class_<CycleResult>(m, "CycleResult")
+        .def(nb::init<>())
+        .def_ro("commands_sent", &CycleResult::commands_sent)
+        .def_ro("refreshes_sent", &CycleResult::refreshes_sent)
+        .def_ro("timed_out", &CycleResult::timed_out);
+
+    nb::class_<ParamLoadResult>(m, "ParamLoadResult")
+        .def(nb::init<>())
+        .def_ro("cached", &ParamLoadResult::cached)
+        .def_ro("queried", &ParamLoadResult::queried)
+        .def_ro("failed", &ParamLoadResult::failed);
+
+    nb::class_<ParamCache>(m, "ParamCache")
+        .def(nb::init<std::string>(), nb::arg("path") = ParamCache::default_path())
+        .def_static("default_rids", &ParamCache::default_rids)
+        .def_static("default_path", &ParamCache::default_path)
+        .def("get_path", &ParamCache::get_path)
+        .def("load", &ParamCache::load)
+        .def("save", &ParamCache::save)
+        .def("store", &ParamCache::store, nb::arg("interface"), nb::arg("motor"),
+             nb::arg("rids"))
+        .def("clear", &ParamCache::clear)
+        .def("size", &ParamCache::size);
+
+    // Simulated bus
+    nb::class_<DMSimulatedMotorConfig>(m, "SimulatedMotorConfig")
+        .def(nb::init<>())
+        .def("__init__",
+             [](DMSimulatedMotorConfig* self, MotorType motor_type, uint32_t send_can_id,
+                uint32_t recv_can_id) {
+                 new (self) DMSimulatedMotorConfig{motor_type, send_can_id, recv_can_id};
+             },
+             nb::arg("motor_type"), nb::arg("send_can_id"), nb::arg("recv_can_id"))
+        .def_rw("motor_type", &DMSimulatedMotorConfig::motor_type)
+        .def_rw("send_can_id", &DMSimulatedMotorConfig::send_can_id)
+        .def_rw("recv_can_id", &DMSimulatedMotorConfig::recv_can_id);
+
+    nb::class_<DMMotorSimulatorConfig>(m, "MotorSimulatorConfig")
+        .def(nb::init<>())
+        .def_rw("interface", &DMMotorSimulatorConfig::interface)
+        .def_rw("enable_fd", &DMMotorSimulatorConfig::enable_fd)
+        .def_rw("reply_latency", &DMMotorSimulatorConfig::reply_latency)
+        .def_rw("reply_jitter", &DMMotorSimulatorConfig::reply_jitter)
+        .def_rw("reply_loss", &DMMotorSimulatorConfig::reply_loss)
+        .def_rw("seed", &DMMotorSimulatorConfig::seed)
+        .def_rw("joint_inertia", &DMMotorSimulatorConfig::joint_inertia)
+        .def_rw("joint_damping", &DMMotorSimulatorConfig::joint_damping)
+        .def_rw("dynamics_step", &DMMotorSimulatorConfig::dynamics_step)
+        .def_rw("bitrate", &DMMotorSimulatorConfig::bitrate)
+        .def_rw("data_bitrate", &DMMotorSimulatorConfig::data_bitrate);
+
+    // Instrumentation snapshots
+    nb::class_<HistogramSnapshot>(m, "HistogramSnapshot")
+        .def(nb::init<>())
+        .def_ro("count", &HistogramSnapshot::count)
+        .def_ro("min_ns", &HistogramSnapshot::min_ns)
+        .def_ro("max_ns", &HistogramSnapshot::max_ns)
+        .def_ro("mean_ns", &HistogramSnapshot::mean_ns)
+        .def_ro("bucket_counts", &HistogramSnapshot::bucket_counts)
+        .def("value_at_percentile", &HistogramSnapshot::value_at_percentile,
+             nb::arg("percentile"))
+        .def_static("bucket_lower_bound", &LatencyHistogram::bucket_lower_bound,
+                    nb::arg("index"));
+
+    nb::class_<TxSchedulerStats>(m, "TxSchedulerStats")
+        .def(nb::init<>())
+        .def_ro("utilization", &TxSchedulerStats::utilization)
+        .def_ro("queue_depth", &TxSchedulerStats::queue_depth)
+        .def_ro("max_queue_depth", &TxSchedulerStats::max_queue_depth)
+        .def_ro("enobufs", &TxSchedulerStats::enobufs)
+        .def_ro("dropped", &TxSchedulerStats::dropped)
+        .def_ro("deferred", &TxSchedulerStats::deferred)
+        .def_ro("merged", &TxSchedulerStats::merged);
+
+    nb::class_<CANSocketStats>(m, "CANSocketStats")
+        .def(nb::init<>())
+        .def_ro("frames_sent", &CANSocketStats::frames_sent)
+        .def_ro("frames_received", &CANSocketStats::frames_received)
+        .def_ro("send_errors", &CANSocketStats::send_errors)
+        .def_ro("malformed_frames", &CANSocketStats::malformed_frames)
+        .def_ro("rx_queue_overflows", &CANSocketStats::rx_queue_overflows)
+        .def_ro("ring_overflows", &CANSocketStats::ring_overflows)
+        .def_ro("spin_wakeups", &CANSocketStats::spin_wakeups)
+        .def_ro("sleep_wakeups", &CANSocketStats::sleep_wakeups)
+        .def_ro("rx_wake", &CANSocketStats::rx_wake)
+        .def_ro("tx_batch", &CANSocketStats::tx_batch)
+        .def_ro("tx_scheduler", &CANSocketStats::tx_scheduler);
+
+    nb::class_<FrameRecorderStats>(m, "FrameRecorderStats")
+        .def(nb::init<>())
+        .def_ro("recorded", &FrameRecorderStats::recorded)
+        .def_ro("dropped", &FrameRecorderStats::dropped);
+
+    nb::class_<MotorLatencyStats>(m, "MotorLatencyStats")
+        .def_ro("recv_can_id", &MotorLatencyStats::recv_can_id)
+        .def_ro("round_trip", &MotorLatencyStats::round_trip);
+
+    nb::class_<OpenArmStats>(m, "OpenArmStats")
+        .def(nb::init<>())
+        .def_ro("socket", &OpenArmStats::socket)
+        .def_ro("recv_all", &OpenArmStats::recv_all)
+        .def_ro("rx_drain", &OpenArmStats::rx_drain)
+        .def_ro("motors", &OpenArmStats::motors)
+        .def_ro("unmatched_frames", &OpenArmStats::unmatched_frames)
+        .def_ro("recording", &OpenArmStats::recording);
+
+    // Frame capture and replay
+    nb::enum_<FrameDirection>(m, "FrameDirection")
+        .value("RX", FrameDirection::RX)
+        .value("TX", FrameDirection::TX)
+        .export_values();
+
+    nb::class_<FrameRecorderConfig>(m, "FrameRecorderConfig")
+        .def(nb::init<>())
+        .def_rw("ring_size", &FrameRecorderConfig::ring_size)
+        .def_rw("file_chunk_records", &FrameRecorderConfig::file_chunk_records)
+        .def_rw("flush_interval", &FrameRecorderConfig::flush_interval);
+
+    nb::class_<FrameLogRecord>(m, "FrameLogRecord")
+        .def_ro("timestamp_ns", &FrameLogRecord::timestamp_ns)
+        .def_ro("hw_timestamp_ns", &FrameLogRecord::hw_timestamp_ns)
+        .def_ro("can_id", &FrameLogRecord::can_id)
+        .def_ro("direction", &FrameLogRecord::direction)
+        .def_prop_ro("is_fd", [](const FrameLogRecord& self) { return self.is_fd != 0; })
+        .def_prop_ro("data", [](const FrameLogRecord& self) {
+            return nb::bytes(reinterpret_cast<const char*>(self.data), self.len);
+        });
+
+    nb::class_<FrameLogReader>(m, "FrameLogReader")
+        .def(nb::init<const std::string&>(), nb::arg("path"))
+        .def_prop_ro("interface",
+                     [](const FrameLogReader& self) {
+                         const FrameLogHeader& header = self.get_header();
+                         return std::string(header.interface,
+                                            strnlen(header.interface, sizeof(header.interface)));
+                     })
+        .def_prop_ro("start_time_ns",
+                     [](const FrameLogReader& self) { return self.get_header().start_time_ns; })
+        .def("__len__", &FrameLogReader::size)
+        .def(
+            "__getitem__",
+            [](const FrameLogReader& self, size_t i) {
+                if (i >= self.size()) throw nb::index_error();
+                return self[i];
+            },
+            nb::arg("i"));
+
+    nb::class_<ReplayStats>(m, "ReplayStats")
+        .def_ro("frames", &ReplayStats::frames)
+        .def_ro("dispatched", &ReplayStats::dispatched)
+        .def_ro("duration", &ReplayStats::duration);
+
+    nb::class_<FrameReplayer>(m, "FrameReplayer")
+        .def(nb::init<const FrameLogReader&>(), nb::arg("log"), nb::keep_alive<1, 2>())
+        .def("replay", &FrameReplayer::replay, nb::arg("collection"), nb::arg("speed") = 1.0,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("stop", &FrameReplayer::stop);
+
     // OpenArm class (main high-level interface)
     nb::class_<OpenArm>(m, "OpenArm")
         .def(nb::init<const std::string&, bool>(), nb::arg("can_interface"),
              nb::arg("enable_fd") = false)
+        .def_static(
+            "simulated",
+            [](const std::vector<DMSimulatedMotorConfig>& motors,
+               const DMMotorSimulatorConfig& config) {
+                return std::make_unique<OpenArm>(
+                    std::make_unique<DMMotorSimulator>(motors, config));
+            },
+            nb::arg("motors"), nb::arg("config") = DMMotorSimulatorConfig())
         .def("init_arm_motors", &OpenArm::init_arm_motors, nb::arg("motor_types"),
              nb::arg("send_can_ids"), nb::arg("recv_can_ids"))
         .def("init_gripper_motor", &OpenArm::init_gripper_motor, nb::arg("motor_type"),
@@ -403,11 +824,231 @@ NB_MODULE(openarm_can, m) {
         .def("get_gripper", &OpenArm::get_gripper, nb::rv_policy::reference)
         .def("get_master_can_device_collection", &OpenArm::get_master_can_device_collection,
              nb::rv_policy::reference)
-        .def("enable_all", &OpenArm::enable_all)
-        .def("disable_all", &OpenArm::disable_all)
-        .def("set_zero_all", &OpenArm::set_zero_all)
-        .def("refresh_all", &OpenArm::refresh_all)
-        .def("recv_all", &OpenArm::recv_all, nb::arg("timeout_us") = 500)
+        .def("enable_timestamping", &OpenArm::enable_timestamping, nb::arg("mode"))
+        .def("set_receive_strategy", &OpenArm::set_receive_strategy, nb::arg("config"))
+        .def("set_kernel_filtering", &OpenArm::set_kernel_filtering, nb::arg("enable"))
+        .def("set_loopback", &OpenArm::set_loopback, nb::arg("enable"))
+        .def("set_recv_own_msgs", &OpenArm::set_recv_own_msgs, nb::arg("enable"))
+        .def("enable_tx_scheduler", &OpenArm::enable_tx_scheduler,
+             nb::arg("config") = TxSchedulerConfig())
+        .def("disable_tx_scheduler", &OpenArm::disable_tx_scheduler)
+        .def("enable_all", &OpenArm::enable_all, nb::call_guard<nb::gil_scoped_release>())
+        .def("disable_all", &OpenArm::disable_all, nb::call_guard<nb::gil_scoped_release>())
+        .def("set_zero_all", &OpenArm::set_zero_all, nb::call_guard<nb::gil_scoped_release>())
+        .def("refresh_all", &OpenArm::refresh_all, nb::call_guard<nb::gil_scoped_release>())
+        .def("recv_all", &OpenArm::recv_all, nb::arg("timeout_us") = 500,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def(
+            "recv_until_complete",
+            [](OpenArm& self, int timeout_us) {
+                nb::gil_scoped_release release;
+                return self.recv_until_complete(std::chrono::steady_clock::now() +
+                                                std::chrono::microseconds(timeout_us));
+            },
+            nb::arg("timeout_us") = 500)
+        .def("recv_queued", &OpenArm::recv_queued, nb::call_guard<nb::gil_scoped_release>())
+        .def("cycle",
+             nb::overload_cast<const std::vector<MITParam>&, const CycleConfig&>(&OpenArm::cycle),
+             nb::arg("commands"), nb::arg("config") = CycleConfig(),
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("cycle",
+             nb::overload_cast<const std::vector<PosVelParam>&, const CycleConfig&>(
+                 &OpenArm::cycle),
+             nb::arg("commands"), nb::arg("config") = CycleConfig(),
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("has_pending_replies", &OpenArm::has_pending_replies)
         .def("set_callback_mode_all", &OpenArm::set_callback_mode_all, nb::arg("callback_mode"))
-        .def("query_param_all", &OpenArm::query_param_all, nb::arg("rid"));
+        .def("query_param_all", &OpenArm::query_param_all, nb::arg("rid"),
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("load_params_all", &OpenArm::load_params_all, nb::arg("rids"),
+             nb::arg("max_in_flight") = 4, nb::arg("timeout") = std::chrono::microseconds(2000),
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("load_params_cached", &OpenArm::load_params_cached,
+             nb::arg("rids") = ParamCache::default_rids(),
+             nb::arg("cache_path") = ParamCache::default_path(), nb::arg("apply_limits") = true,
+             nb::arg("max_in_flight") = 4, nb::arg("timeout") = std::chrono::microseconds(2000),
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("set_packed_framing", &OpenArm::set_packed_framing, nb::arg("config"))
+        .def("probe_framing", &OpenArm::probe_framing,
+             nb::arg("timeout") = std::chrono::microseconds(10000),
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("start_receiver", &OpenArm::start_receiver, nb::arg("config") = ReceiverConfig())
+        .def("stop_receiver", &OpenArm::stop_receiver,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("is_receiver_running", &OpenArm::is_receiver_running)
+        .def("start_pipeline", &OpenArm::start_pipeline, nb::arg("config") = PipelineConfig())
+        .def("stop_pipeline", &OpenArm::stop_pipeline,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("is_pipeline_running", &OpenArm::is_pipeline_running)
+        .def("process_replies", &OpenArm::process_replies)
+        .def("start_recording", &OpenArm::start_recording, nb::arg("path"),
+             nb::arg("config") = FrameRecorderConfig())
+        .def("stop_recording", &OpenArm::stop_recording,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("is_recording", &OpenArm::is_recording)
+        .def("get_stats", &OpenArm::get_stats)
+        .def("reset_stats", &OpenArm::reset_stats);
+
+    // ControlLoop (fixed-rate scheduler). run() releases the GIL for the whole loop and only
+    // takes it back to call the Python callback once per tick.
+    nb::class_<ControlLoopConfig>(m, "ControlLoopConfig")
+        .def(nb::init<>())
+        .def_rw("period", &ControlLoopConfig::period)
+        .def_rw("rx_timeout", &ControlLoopConfig::rx_timeout)
+        .def_rw("thread", &ControlLoopConfig::thread)
+        .def_rw("lock_memory", &ControlLoopConfig::lock_memory);
+
+    nb::class_<ControlTick>(m, "ControlTick")
+        .def_ro("index", &ControlTick::index)
+        .def_ro("scheduled_ns", &ControlTick::scheduled_ns)
+        .def_ro("wakeup_ns", &ControlTick::wakeup_ns)
+        .def_ro("timed_out", &ControlTick::timed_out);
+
+    nb::class_<ControlLoopStats>(m, "ControlLoopStats")
+        .def_ro("ticks", &ControlLoopStats::ticks)
+        .def_ro("overruns", &ControlLoopStats::overruns)
+        .def_ro("missed_ticks", &ControlLoopStats::missed_ticks)
+        .def_ro("rx_timeouts", &ControlLoopStats::rx_timeouts)
+        .def_ro("wakeup_latency", &ControlLoopStats::wakeup_latency)
+        .def_ro("tick_duration", &ControlLoopStats::tick_duration);
+
+    nb::class_<ControlLoop>(m, "ControlLoop")
+        .def(nb::init<OpenArm&, const ControlLoopConfig&>(), nb::arg("openarm"),
+             nb::arg("config") = ControlLoopConfig(), nb::keep_alive<1, 2>())
+        .def("run", &ControlLoop::run, nb::arg("callback"),
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("stop", &ControlLoop::stop)
+        .def("is_running", &ControlLoop::is_running)
+        .def("get_arm_state", &ControlLoop::get_arm_state, nb::rv_policy::reference_internal)
+        .def("get_gripper_state", &ControlLoop::get_gripper_state,
+             nb::rv_policy::reference_internal)
+        .def("get_stats", &ControlLoop::get_stats)
+        .def("reset_stats", &ControlLoop::reset_stats);
+
+    // CommandSlots (latest setpoint per joint from any thread, sent by one bus owner)
+    nb::class_<CommandSlots>(m, "CommandSlots")
+        .def(nb::init<OpenArm&>(), nb::arg("openarm"), nb::keep_alive<1, 2>())
+        .def("size", &CommandSlots::size)
+        .def("gripper_joint", &CommandSlots::gripper_joint, nb::arg("i") = 0)
+        .def("set_mit", &CommandSlots::set_mit, nb::arg("joint"), nb::arg("mit_param"))
+        .def("set_posvel", &CommandSlots::set_posvel, nb::arg("joint"), nb::arg("posvel_param"))
+        .def("set_mit_all",
+             nb::overload_cast<const std::vector<MITParam>&, size_t>(&CommandSlots::set_mit_all),
+             nb::arg("mit_params"), nb::arg("first") = 0)
+        .def("set_posvel_all",
+             nb::overload_cast<const std::vector<PosVelParam>&, size_t>(
+                 &CommandSlots::set_posvel_all),
+             nb::arg("posvel_params"), nb::arg("first") = 0)
+        .def("clear", &CommandSlots::clear, nb::arg("joint"))
+        .def("clear_all", &CommandSlots::clear_all)
+        .def("get_updates", &CommandSlots::get_updates, nb::arg("joint"))
+        .def("send", &CommandSlots::send, nb::arg("config") = CycleConfig(),
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("cycle", &CommandSlots::cycle, nb::arg("config") = CycleConfig(),
+             nb::call_guard<nb::gil_scoped_release>());
+
+    // TrajectoryStreamer (interpolating real-time thread fed by a lock-free queue)
+    m.attr("TRAJECTORY_MAX_JOINTS") = TRAJECTORY_MAX_JOINTS;
+
+    nb::enum_<InterpolationMode>(m, "InterpolationMode")
+        .value("CUBIC", InterpolationMode::CUBIC)
+        .value("QUINTIC", InterpolationMode::QUINTIC);
+
+    nb::class_<TrajectoryPoint>(m, "TrajectoryPoint")
+        .def(nb::init<>())
+        .def_rw("time_ns", &TrajectoryPoint::time_ns)
+        .def_rw("positions", &TrajectoryPoint::positions)
+        .def_rw("velocities", &TrajectoryPoint::velocities)
+        .def_rw("accelerations", &TrajectoryPoint::accelerations);
+
+    nb::class_<TrajectoryStreamerConfig>(m, "TrajectoryStreamerConfig")
+        .def(nb::init<>())
+        .def_rw("loop", &TrajectoryStreamerConfig::loop)
+        .def_rw("interpolation", &TrajectoryStreamerConfig::interpolation)
+        .def_rw("control_mode", &TrajectoryStreamerConfig::control_mode)
+        .def_rw("kp", &TrajectoryStreamerConfig::kp)
+        .def_rw("kd", &TrajectoryStreamerConfig::kd)
+        .def_rw("posvel_min_velocity", &TrajectoryStreamerConfig::posvel_min_velocity)
+        .def_rw("queue_size", &TrajectoryStreamerConfig::queue_size);
+
+    nb::class_<TrajectoryStreamerStats>(m, "TrajectoryStreamerStats")
+        .def_ro("points", &TrajectoryStreamerStats::points)
+        .def_ro("rejected_points", &TrajectoryStreamerStats::rejected_points)
+        .def_ro("hold_ticks", &TrajectoryStreamerStats::hold_ticks)
+        .def_ro("loop", &TrajectoryStreamerStats::loop);
+
+    using TimeArray = nb::ndarray<const int64_t, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+    using JointArray = nb::ndarray<const double, nb::ndim<2>, nb::c_contig, nb::device::cpu>;
+    nb::class_<TrajectoryStreamer>(m, "TrajectoryStreamer")
+        .def(nb::init<OpenArm&, const TrajectoryStreamerConfig&>(), nb::arg("openarm"),
+             nb::arg("config") = TrajectoryStreamerConfig(), nb::keep_alive<1, 2>())
+        .def("start", &TrajectoryStreamer::start)
+        .def("stop", &TrajectoryStreamer::stop, nb::call_guard<nb::gil_scoped_release>())
+        .def("is_running", &TrajectoryStreamer::is_running)
+        .def("get_error", &TrajectoryStreamer::get_error)
+        .def("push",
+             nb::overload_cast<const std::vector<TrajectoryPoint>&>(&TrajectoryStreamer::push),
+             nb::arg("points"))
+        // times_ns has shape (N,), the others (N, joints), missing ones are zero
+        .def(
+            "push_arrays",
+            [](TrajectoryStreamer& self, TimeArray times_ns, JointArray positions,
+               std::optional<JointArray> velocities, std::optional<JointArray> accelerations) {
+                const size_t count = times_ns.shape(0);
+                const size_t joints = positions.shape(1);
+                if (joints > TRAJECTORY_MAX_JOINTS) {
+                    throw std::invalid_argument("push_arrays: too many joints");
+                }
+                for (const auto* array : {&velocities, &accelerations}) {
+                    if (*array && ((*array)->shape(0) != positions.shape(0) ||
+                                   (*array)->shape(1) != joints)) {
+                        throw std::invalid_argument("push_arrays: arrays must have the same shape");
+                    }
+                }
+                if (positions.shape(0) != count) {
+                    throw std::invalid_argument("push_arrays: one row per time is needed");
+                }
+                std::vector<TrajectoryPoint> points(count);
+                for (size_t i = 0; i < count; i++) {
+                    points[i].time_ns = times_ns(i);
+                    for (size_t j = 0; j < joints; j++) {
+                        points[i].positions[j] = positions(i, j);
+                        if (velocities) points[i].velocities[j] = (*velocities)(i, j);
+                        if (accelerations) points[i].accelerations[j] = (*accelerations)(i, j);
+                    }
+                }
+                return self.push(points);
+            },
+            nb::arg("times_ns"), nb::arg("positions"), nb::arg("velocities") = nb::none(),
+            nb::arg("accelerations") = nb::none())
+        .def("queued", &TrajectoryStreamer::queued)
+        .def("flush", &TrajectoryStreamer::flush)
+        .def("read_state", &TrajectoryStreamer::read_state, nb::arg("out"))
+        .def("get_stats", &TrajectoryStreamer::get_stats)
+        .def("reset_stats", &TrajectoryStreamer::reset_stats);
+
+    // MultiArmExecutor class (several buses from one epoll loop)
+    nb::class_<MultiArmExecutor>(m, "MultiArmExecutor")
+        .def(nb::init<>())
+        .def("add_arm", &MultiArmExecutor::add_arm, nb::arg("openarm"), nb::keep_alive<1, 2>())
+        .def("size", &MultiArmExecutor::size)
+        .def("get_arm", &MultiArmExecutor::get_arm, nb::arg("i"), nb::rv_policy::reference)
+        .def("enable_all", &MultiArmExecutor::enable_all, nb::call_guard<nb::gil_scoped_release>())
+        .def("disable_all", &MultiArmExecutor::disable_all,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("refresh_all", &MultiArmExecutor::refresh_all,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def("recv_all", &MultiArmExecutor::recv_all, nb::arg("timeout_us") = 500,
+             nb::call_guard<nb::gil_scoped_release>())
+        .def(
+            "recv_until_complete",
+            [](MultiArmExecutor& self, int timeout_us) {
+                nb::gil_scoped_release release;
+                return self.recv_until_complete(std::chrono::steady_clock::now() +
+                                                std::chrono::microseconds(timeout_us));
+            },
+            nb::arg("timeout_us") = 500)
+        .def("start_receivers", &MultiArmExecutor::start_receivers, nb::arg("configs"))
+        .def("stop_receivers", &MultiArmExecutor::stop_receivers,
+             nb::call_guard<nb::gil_scoped_release>());
 }
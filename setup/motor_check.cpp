@@ -19,6 +19,10 @@
 #include <thread>
 
 namespace {
+// Upper bound for every reply, waits return as soon as the reply is in
+constexpr std::chrono::milliseconds REPLY_TIMEOUT{10};
+constexpr int REPLY_TIMEOUT_US = 10000;
+
 void print_usage(const char* program_name) {
     std::cout << "Usage: " << program_name << " <send_can_id> <recv_can_id> [can_interface] [-fd]"
               << std::endl;
@@ -109,25 +113,18 @@ int main(int argc, char* argv[]) {
         openarm.init_arm_motors({openarm::damiao_motor::MotorType::DM4310}, {send_can_id},
                                 {recv_can_id});
 
-        // Set callback mode to param for initial parameter reading
-        openarm.set_callback_mode_all(openarm::damiao_motor::CallbackMode::PARAM);
-
-        // Query motor parameters (Master ID, Baudrate, and Control Mode)
+        // Query motor parameters (Master ID, Baudrate, and Control Mode), all in flight at
+        // once and each bounded by its reply
         std::cout << "Reading motor parameters..." << std::endl;
-        openarm.query_param_all(static_cast<int>(openarm::damiao_motor::RID::MST_ID));
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        openarm.recv_all();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-        openarm.query_param_all(static_cast<int>(openarm::damiao_motor::RID::can_br));
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        openarm.recv_all();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-        openarm.query_param_all(static_cast<int>(openarm::damiao_motor::RID::CTRL_MODE));
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        openarm.recv_all();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        size_t failed_queries = openarm.load_params_all(
+            {static_cast<int>(openarm::damiao_motor::RID::MST_ID),
+             static_cast<int>(openarm::damiao_motor::RID::can_br),
+             static_cast<int>(openarm::damiao_motor::RID::CTRL_MODE)},
+            4, REPLY_TIMEOUT);
+        if (failed_queries > 0) {
+            std::cout << "Warning: " << failed_queries << " parameter queries got no reply"
+                      << std::endl;
+        }
 
         // Get motor and verify parameters
         const auto& motors = openarm.get_arm().get_motors();
@@ -161,33 +158,40 @@ int main(int argc, char* argv[]) {
             std::cout << "✓ Master ID verification passed" << std::endl;
         }
 
-        // Switch to state callback mode for motor status updates
-        openarm.set_callback_mode_all(openarm::damiao_motor::CallbackMode::STATE);
-
         // Enable the motor
         std::cout << "\n=== Enabling Motor ===" << std::endl;
         openarm.enable_all();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        openarm.recv_all();
+        openarm.recv_all(REPLY_TIMEOUT_US);
 
         // Refresh 10 times at 10Hz (100ms intervals)
         std::cout << "\n=== Refreshing Motor Status (10Hz for 1 second) ===" << std::endl;
+        auto next_refresh = std::chrono::steady_clock::now();
         for (int i = 1; i <= 10; i++) {
             openarm.refresh_all();
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            openarm.recv_all();
+            if (!openarm.recv_until_complete(std::chrono::steady_clock::now() + REPLY_TIMEOUT)
+                     .empty()) {
+                std::cout << "Warning: no reply to refresh " << i << std::endl;
+            }
 
             for (const auto& motor : openarm.get_arm().get_motors()) {
                 std::cout << "\n--- Refresh " << i << "/10 ---" << std::endl;
                 print_motor_status(motor);
             }
+            next_refresh += std::chrono::milliseconds(100);
+            std::this_thread::sleep_until(next_refresh);
+        }
+
+        for (const auto& motor : openarm.get_stats().motors) {
+            const auto& round_trip = motor.round_trip;
+            std::cout << "\nReply latency: " << round_trip.count << " replies, min "
+                      << round_trip.min_ns / 1000.0 << " us, mean " << round_trip.mean_ns / 1000.0
+                      << " us, max " << round_trip.max_ns / 1000.0 << " us" << std::endl;
         }
 
         // Disable the motor
         std::cout << "\n=== Disabling Motor ===" << std::endl;
         openarm.disable_all();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        openarm.recv_all();
+        openarm.recv_all(REPLY_TIMEOUT_US);
 
         std::cout << "\n=== Script Completed Successfully ===" << std::endl;
 
@@ -12,52 +12,270 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+// Probes every given interface concurrently: reads the parameters of all motors with the
+// pipelined query engine, measures the state round trip of every motor and collects the
+// socket and controller error counters, then prints one report (and optionally JSON).
+
 #include <linux/can.h>
+#include <linux/can/netlink.h>
 #include <linux/can/raw.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <net/if.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
-#include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <openarm/can/socket/openarm.hpp>
 #include <openarm/damiao_motor/dm_motor_constants.hpp>
+#include <openarm/damiao_motor/dm_motor_simulator.hpp>
+#include <sstream>
+#include <string>
 #include <thread>
 #include <vector>
 
-static void print_usage(const char* program_name) {
-    std::cerr << "Usage: " << program_name << " <can_interface> [-fd]" << std::endl;
+using namespace openarm;
+using damiao_motor::MotorType;
+using damiao_motor::RID;
+
+namespace {
+
+struct DiagnosisConfig {
+    std::vector<std::string> interfaces;
+    bool use_fd = false;
+    // "" for none, "-" for stdout
+    std::string json_path;
+    // state round trips per motor
+    int refreshes = 20;
+    std::chrono::milliseconds timeout{10};
+    // Probe in-process simulated motors instead of the interfaces
+    bool simulate = false;
+    size_t simulated_motors = 8;
+};
+
+// OpenArm layout: seven arm motors and the gripper
+const std::vector<MotorType> ARM_MOTOR_TYPES = {MotorType::DM8009, MotorType::DM8009,
+                                                MotorType::DM4340, MotorType::DM4340,
+                                                MotorType::DM4310, MotorType::DM4310,
+                                                MotorType::DM4310};
+const std::vector<uint32_t> ARM_SEND_CAN_IDS = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+const std::vector<uint32_t> ARM_RECV_CAN_IDS = {0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17};
+constexpr MotorType GRIPPER_MOTOR_TYPE = MotorType::DM4310;
+constexpr uint32_t GRIPPER_SEND_CAN_ID = 0x08;
+constexpr uint32_t GRIPPER_RECV_CAN_ID = 0x18;
+
+const std::vector<int> DIAGNOSIS_RIDS = {
+    static_cast<int>(RID::MST_ID), static_cast<int>(RID::can_br),
+    static_cast<int>(RID::CTRL_MODE), static_cast<int>(RID::sw_ver), static_cast<int>(RID::SN)};
+
+// Kernel view of a CAN netdev (RTM_GETLINK), every part is optional
+struct LinkInfo {
+    bool found = false;
+    std::string kind;
+    bool has_stats = false;
+    rtnl_link_stats64 stats{};
+    uint32_t bitrate = 0;
+    uint32_t data_bitrate = 0;
+    bool has_state = false;
+    uint32_t state = 0;
+    bool has_berr_counter = false;
+    can_berr_counter berr_counter{};
+    bool has_device_stats = false;
+    can_device_stats device_stats{};
+};
+
+struct MotorReport {
+    std::string name;
+    uint32_t send_can_id;
+    uint32_t recv_can_id;
+    bool responded = false;
+    bool mst_id_matches = false;
+    double mst_id = -1;
+    double can_br = -1;
+    double ctrl_mode = -1;
+    double sw_ver = -1;
+    double sn = -1;
+    // state round trips answered out of the ones sent
+    int replies = 0;
+    int refreshes = 0;
+    canbus::HistogramSnapshot round_trip;
+};
+
+struct BusReport {
+    std::string interface;
+    std::string error;
+    std::vector<std::string> warnings;
+    bool requested_fd = false;
+    bool interface_fd = false;
+    LinkInfo link_before;
+    LinkInfo link_after;
+    std::vector<MotorReport> motors;
+    canbus::CANSocketStats socket;
+    uint64_t unmatched_frames = 0;
+    double seconds = 0;
+};
+
+void print_usage(const char* program_name) {
+    std::cerr << "Usage: " << program_name << " [options] <can_interface>...\n"
+              << "  -fd, --fd           use CAN-FD\n"
+              << "  --json FILE         also write the report as JSON, - for stdout\n"
+              << "  --refreshes N       state round trips per motor (default 20)\n"
+              << "  --timeout-ms MS     reply timeout of every query (default 10)\n"
+              << "  --sim               probe simulated motors instead of the interfaces\n"
+              << "  --sim-motors N      with --sim, only the first N motors answer (default 8)\n"
+              << "Example: " << program_name << " can0 can1 can2 can3 --json report.json\n";
 }
 
 // Return true if the netdev is configured for CAN-FD (MTU == CANFD_MTU), false if Classical (MTU ==
 // CAN_MTU)
-static bool iface_is_canfd(const char* ifname) {
+bool iface_is_canfd(const char* ifname, std::vector<std::string>& warnings) {
     int s = socket(PF_CAN, SOCK_RAW, CAN_RAW);
     if (s < 0) {
-        perror("socket");
+        warnings.push_back(std::string("socket: ") + strerror(errno));
         return false;  // fall back
     }
     struct ifreq ifr{};
     std::strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
     ifr.ifr_name[IFNAMSIZ - 1] = '\0';
-    ifr.ifr_name[IFNAMSIZ] = '\0';
     if (ioctl(s, SIOCGIFMTU, &ifr) < 0) {
-        perror("ioctl(SIOCGIFMTU)");
+        warnings.push_back(std::string("ioctl(SIOCGIFMTU): ") + strerror(errno));
         close(s);
         return false;
     }
     close(s);
     if (ifr.ifr_mtu == CANFD_MTU) return true;
     if (ifr.ifr_mtu == CAN_MTU) return false;
-    std::cerr << "Warning: unexpected MTU " << ifr.ifr_mtu << " on " << ifname << "\n";
+    warnings.push_back("unexpected MTU " + std::to_string(ifr.ifr_mtu));
     return false;
 }
 
-static const char* br_label(int br_code) {
+void parse_can_info_data(const rtattr* data, LinkInfo& info) {
+    int len = RTA_PAYLOAD(data);
+    for (auto* attr = static_cast<const rtattr*>(RTA_DATA(data)); RTA_OK(attr, len);
+         attr = RTA_NEXT(attr, len)) {
+        const void* payload = RTA_DATA(attr);
+        size_t size = RTA_PAYLOAD(attr);
+        switch (attr->rta_type) {
+            case IFLA_CAN_BITTIMING:
+                if (size >= sizeof(can_bittiming)) {
+                    info.bitrate = static_cast<const can_bittiming*>(payload)->bitrate;
+                }
+                break;
+            case IFLA_CAN_DATA_BITTIMING:
+                if (size >= sizeof(can_bittiming)) {
+                    info.data_bitrate = static_cast<const can_bittiming*>(payload)->bitrate;
+                }
+                break;
+            case IFLA_CAN_STATE:
+                if (size >= sizeof(uint32_t)) {
+                    info.has_state = true;
+                    memcpy(&info.state, payload, sizeof(info.state));
+                }
+                break;
+            case IFLA_CAN_BERR_COUNTER:
+                if (size >= sizeof(can_berr_counter)) {
+                    info.has_berr_counter = true;
+                    memcpy(&info.berr_counter, payload, sizeof(info.berr_counter));
+                }
+                break;
+        }
+    }
+}
+
+void parse_link_info(const rtattr* link_info, LinkInfo& info) {
+    int len = RTA_PAYLOAD(link_info);
+    for (auto* attr = static_cast<const rtattr*>(RTA_DATA(link_info)); RTA_OK(attr, len);
+         attr = RTA_NEXT(attr, len)) {
+        if (attr->rta_type == IFLA_INFO_KIND) {
+            info.kind = static_cast<const char*>(RTA_DATA(attr));
+        } else if (attr->rta_type == IFLA_INFO_DATA) {
+            parse_can_info_data(attr, info);
+        } else if (attr->rta_type == IFLA_INFO_XSTATS &&
+                   RTA_PAYLOAD(attr) >= sizeof(can_device_stats)) {
+            info.has_device_stats = true;
+            memcpy(&info.device_stats, RTA_DATA(attr), sizeof(info.device_stats));
+        }
+    }
+}
+
+// Query interface statistics, controller state and error counters over rtnetlink
+LinkInfo read_link_info(const std::string& interface) {
+    LinkInfo info;
+    unsigned int index = if_nametoindex(interface.c_str());
+    if (index == 0) return info;
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) return info;
+
+    struct {
+        nlmsghdr header;
+        ifinfomsg message;
+    } request{};
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+    request.header.nlmsg_type = RTM_GETLINK;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.message.ifi_family = AF_UNSPEC;
+    request.message.ifi_index = static_cast<int>(index);
+    timeval timeout{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (send(fd, &request, request.header.nlmsg_len, 0) < 0) {
+        close(fd);
+        return info;
+    }
+
+    alignas(nlmsghdr) char buffer[16384];
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    close(fd);
+    if (received <= 0) return info;
+    int len = static_cast<int>(received);
+    for (auto* header = reinterpret_cast<nlmsghdr*>(buffer); NLMSG_OK(header, len);
+         header = NLMSG_NEXT(header, len)) {
+        if (header->nlmsg_type != RTM_NEWLINK) continue;
+        auto* message = static_cast<ifinfomsg*>(NLMSG_DATA(header));
+        info.found = true;
+        int attr_len = IFLA_PAYLOAD(header);
+        for (rtattr* attr = IFLA_RTA(message); RTA_OK(attr, attr_len);
+             attr = RTA_NEXT(attr, attr_len)) {
+            if (attr->rta_type == IFLA_STATS64 && RTA_PAYLOAD(attr) >= sizeof(rtnl_link_stats64)) {
+                info.has_stats = true;
+                memcpy(&info.stats, RTA_DATA(attr), sizeof(info.stats));
+            } else if (attr->rta_type == IFLA_LINKINFO) {
+                parse_link_info(attr, info);
+            }
+        }
+    }
+    return info;
+}
+
+const char* can_state_label(uint32_t state) {
+    switch (state) {
+        case CAN_STATE_ERROR_ACTIVE:
+            return "ERROR-ACTIVE";
+        case CAN_STATE_ERROR_WARNING:
+            return "ERROR-WARNING";
+        case CAN_STATE_ERROR_PASSIVE:
+            return "ERROR-PASSIVE";
+        case CAN_STATE_BUS_OFF:
+            return "BUS-OFF";
+        case CAN_STATE_STOPPED:
+            return "STOPPED";
+        case CAN_STATE_SLEEPING:
+            return "SLEEPING";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+const char* br_label(int br_code) {
     // simple mapping example
     switch (br_code) {
         case 9:
@@ -69,126 +287,433 @@ static const char* br_label(int br_code) {
     }
 }
 
-int main(int argc, char* argv[]) {
-    std::cout << "OpenArm CAN diagnostics\n";
+const char* ctrl_mode_label(int ctrl_mode) {
+    switch (ctrl_mode) {
+        case static_cast<int>(damiao_motor::ControlMode::MIT):
+            return "MIT";
+        case static_cast<int>(damiao_motor::ControlMode::POS_VEL):
+            return "POS_VEL";
+        case static_cast<int>(damiao_motor::ControlMode::VEL):
+            return "VEL";
+        case static_cast<int>(damiao_motor::ControlMode::TORQUE_POS):
+            return "TORQUE_POS";
+        default:
+            return "(unknown)";
+    }
+}
+
+bool valid_param(double value) { return value >= 0 && std::isfinite(value); }
 
-    for (int i = 1; i < argc; ++i) {
-        if (std::string_view(argv[i]) == "-h") {
-            print_usage(argv[0]);
-            return 0;
+std::unique_ptr<can::socket::OpenArm> open_bus(const DiagnosisConfig& config,
+                                               const std::string& interface) {
+    if (!config.simulate) return std::make_unique<can::socket::OpenArm>(interface, config.use_fd);
+
+    std::vector<damiao_motor::DMSimulatedMotorConfig> motors;
+    for (size_t i = 0; i < ARM_MOTOR_TYPES.size(); i++) {
+        motors.push_back({ARM_MOTOR_TYPES[i], ARM_SEND_CAN_IDS[i], ARM_RECV_CAN_IDS[i]});
+    }
+    motors.push_back({GRIPPER_MOTOR_TYPE, GRIPPER_SEND_CAN_ID, GRIPPER_RECV_CAN_ID});
+    motors.resize(std::min(motors.size(), config.simulated_motors));
+    damiao_motor::DMMotorSimulatorConfig simulator;
+    simulator.interface = interface;
+    simulator.enable_fd = config.use_fd;
+    if (config.use_fd) simulator.data_bitrate = 5000000;
+    return std::make_unique<can::socket::OpenArm>(
+        std::make_unique<damiao_motor::DMMotorSimulator>(motors, simulator));
+}
+
+// Everything the report shows about one bus, run on its own thread
+BusReport diagnose_bus(const DiagnosisConfig& config, const std::string& interface) {
+    auto start = std::chrono::steady_clock::now();
+    BusReport report;
+    report.interface = interface;
+    report.requested_fd = config.use_fd;
+    try {
+        if (config.simulate) {
+            report.interface_fd = config.use_fd;
+        } else {
+            report.interface_fd = iface_is_canfd(interface.c_str(), report.warnings);
+            if (report.interface_fd != config.use_fd) {
+                report.warnings.push_back(
+                    "requested mode and interface mode differ. Check `ip link` configuration or "
+                    "run with/without -fd accordingly.");
+            }
+            report.link_before = read_link_info(interface);
+        }
+
+        auto openarm = open_bus(config, interface);
+        openarm->init_arm_motors(ARM_MOTOR_TYPES, ARM_SEND_CAN_IDS, ARM_RECV_CAN_IDS);
+        openarm->init_gripper_motor(GRIPPER_MOTOR_TYPE, GRIPPER_SEND_CAN_ID, GRIPPER_RECV_CAN_ID);
+
+        // All RIDs of all motors, several queries in flight per motor, each one bounded by
+        // its reply or the timeout
+        openarm->set_callback_mode_all(damiao_motor::CallbackMode::STATE);
+        openarm->load_params_all(DIAGNOSIS_RIDS, 4, config.timeout);
+
+        // State round trips, refresh_all() marks every motor pending so each one is
+        // answered or times out
+        openarm->reset_stats();
+        std::vector<int> replies(ARM_RECV_CAN_IDS.size() + 1, config.refreshes);
+        for (int i = 0; i < config.refreshes; i++) {
+            openarm->refresh_all();
+            auto timed_out =
+                openarm->recv_until_complete(std::chrono::steady_clock::now() + config.timeout);
+            for (uint32_t recv_can_id : timed_out) {
+                if (recv_can_id == GRIPPER_RECV_CAN_ID) {
+                    replies.back()--;
+                } else {
+                    for (size_t j = 0; j < ARM_RECV_CAN_IDS.size(); j++) {
+                        if (ARM_RECV_CAN_IDS[j] == recv_can_id) replies[j]--;
+                    }
+                }
+            }
         }
+        can::socket::OpenArmStats stats = openarm->get_stats();
+        report.socket = stats.socket;
+        report.unmatched_frames = stats.unmatched_frames;
+
+        std::vector<damiao_motor::Motor> motors = openarm->get_arm().get_motors();
+        for (const damiao_motor::Motor& motor : openarm->get_gripper().get_motors()) {
+            motors.push_back(motor);
+        }
+        for (size_t i = 0; i < motors.size(); i++) {
+            const damiao_motor::Motor& motor = motors[i];
+            MotorReport motor_report;
+            motor_report.name =
+                i < ARM_RECV_CAN_IDS.size() ? "arm#" + std::to_string(i) : "gripper";
+            motor_report.send_can_id = motor.get_send_can_id();
+            motor_report.recv_can_id = motor.get_recv_can_id();
+            motor_report.mst_id = motor.get_param(static_cast<int>(RID::MST_ID));
+            motor_report.can_br = motor.get_param(static_cast<int>(RID::can_br));
+            motor_report.ctrl_mode = motor.get_param(static_cast<int>(RID::CTRL_MODE));
+            motor_report.sw_ver = motor.get_param(static_cast<int>(RID::sw_ver));
+            motor_report.sn = motor.get_param(static_cast<int>(RID::SN));
+            motor_report.responded = valid_param(motor_report.mst_id) || replies[i] > 0;
+            motor_report.mst_id_matches =
+                valid_param(motor_report.mst_id) &&
+                static_cast<uint32_t>(motor_report.mst_id) == motor_report.recv_can_id;
+            motor_report.replies = replies[i];
+            motor_report.refreshes = config.refreshes;
+            for (const can::socket::MotorLatencyStats& latency : stats.motors) {
+                if (latency.recv_can_id == motor_report.recv_can_id) {
+                    motor_report.round_trip = latency.round_trip;
+                }
+            }
+            report.motors.push_back(motor_report);
+        }
+
+        if (!config.simulate) report.link_after = read_link_info(interface);
+    } catch (const std::exception& e) {
+        report.error = e.what();
     }
+    report.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
 
-    // Args: <can_interface> [-fd]
-    if (argc < 2) {
-        print_usage(argv[0]);
-        return 1;
+std::string hex(uint32_t value) {
+    std::ostringstream out;
+    out << "0x" << std::hex << std::setw(2) << std::setfill('0') << value;
+    return out.str();
+}
+
+double us(uint64_t ns) { return ns / 1000.0; }
+
+bool motor_ok(const MotorReport& motor) {
+    return motor.responded && motor.mst_id_matches && motor.replies == motor.refreshes;
+}
+
+bool bus_ok(const BusReport& bus) {
+    if (!bus.error.empty()) return false;
+    for (const MotorReport& motor : bus.motors) {
+        if (!motor_ok(motor)) return false;
     }
-    std::string can_if = argv[1];
-    bool use_fd = false;
-    if (argc >= 3) {
-        std::string arg2 = argv[2];
-        if (arg2 == "-fd")
-            use_fd = true;
-        else {
-            std::cerr << "Error: Unknown argument '" << arg2 << "'. Use -fd to enable CAN-FD.\n";
-            return 1;
-        }
-    }
-
-    // Detect actual iface mode via MTU
-    bool iface_fd = iface_is_canfd(can_if.c_str());
-
-    std::cout << "CAN interface: " << can_if << std::endl;
-    std::cout << "Requested mode: " << (use_fd ? "CAN FD" : "Classical CAN") << std::endl;
-    std::cout << "Interface mode: " << (iface_fd ? "CAN FD" : "Classical CAN") << std::endl;
-
-    if (use_fd != iface_fd) {
-        std::cout << "WARNING: requested mode and interface mode differ. "
-                     "Check `ip link` configuration or run with/without -fd accordingly.\n";
-    }
-
-    std::cout << "Initializing OpenArm CAN..." << std::endl;
-    // Use the actual args
-    openarm::can::socket::OpenArm openarm(can_if, use_fd);
-
-    // Initialize arm motors
-    std::vector<openarm::damiao_motor::MotorType> motor_types = {
-        openarm::damiao_motor::MotorType::DM8009, openarm::damiao_motor::MotorType::DM8009,
-        openarm::damiao_motor::MotorType::DM4340, openarm::damiao_motor::MotorType::DM4340,
-        openarm::damiao_motor::MotorType::DM4310, openarm::damiao_motor::MotorType::DM4310,
-        openarm::damiao_motor::MotorType::DM4310};
-    std::vector<uint32_t> send_can_ids = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
-    std::vector<uint32_t> recv_can_ids = {0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17};
-    openarm.init_arm_motors(motor_types, send_can_ids, recv_can_ids);
-
-    // Initialize gripper
-    std::cout << "Initializing gripper..." << std::endl;
-    openarm.init_gripper_motor(openarm::damiao_motor::MotorType::DM4310, 0x08, 0x18);
-
-    openarm.set_callback_mode_all(openarm::damiao_motor::CallbackMode::PARAM);
-
-    std::cout << "Reading motor parameters ..." << std::endl;
-    openarm.query_param_all((int)openarm::damiao_motor::RID::MST_ID);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    openarm.recv_all();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-    openarm.query_param_all((int)openarm::damiao_motor::RID::can_br);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    openarm.recv_all();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-    // read params
-    const auto& arm_motors = openarm.get_arm().get_motors();
-    const auto& gripper_motors = openarm.get_gripper().get_motors();
-
-    std::vector<uint32_t> missing_ids;
-
-    for (size_t i = 0; i < arm_motors.size(); ++i) {
-        const auto& motor = arm_motors[i];
-        double mst = motor.get_param((int)openarm::damiao_motor::RID::MST_ID);
-        double br = motor.get_param((int)openarm::damiao_motor::RID::can_br);
-
-        if (mst < 0 || br < 0 || !std::isfinite(mst) || !std::isfinite(br)) {
-            std::cout << "[arm#" << i << "] id=0x" << std::hex << recv_can_ids[i] << std::dec
-                      << " -> NG (no response)\n";
-            missing_ids.push_back(recv_can_ids[i]);
+    return true;
+}
+
+uint32_t bus_errors_during(const BusReport& bus) {
+    if (!bus.link_before.has_device_stats || !bus.link_after.has_device_stats) return 0;
+    return bus.link_after.device_stats.bus_error - bus.link_before.device_stats.bus_error;
+}
+
+void print_bus(std::ostream& out, const BusReport& bus) {
+    out << "\n== " << bus.interface << " (" << (bus.requested_fd ? "CAN FD" : "Classical CAN")
+        << ", interface " << (bus.interface_fd ? "CAN FD" : "Classical CAN");
+    const LinkInfo& link = bus.link_after.found ? bus.link_after : bus.link_before;
+    if (link.bitrate) out << ", " << link.bitrate << " bit/s";
+    if (link.data_bitrate) out << ", data " << link.data_bitrate << " bit/s";
+    if (link.has_state) out << ", " << can_state_label(link.state);
+    out << ", " << std::fixed << std::setprecision(2) << bus.seconds << " s)\n";
+    for (const std::string& warning : bus.warnings) out << "  WARNING: " << warning << "\n";
+    if (!bus.error.empty()) {
+        out << "  NG: " << bus.error << "\n";
+        return;
+    }
+
+    out << "  motor    send  recv  status  mst_id  can_br          ctrl_mode   sw_ver  "
+           "replies  rtt_p50_us  rtt_p99_us  rtt_max_us\n";
+    for (const MotorReport& motor : bus.motors) {
+        std::ostringstream can_br, ctrl_mode, mst_id, sw_ver, replies;
+        if (valid_param(motor.mst_id)) mst_id << hex(static_cast<uint32_t>(motor.mst_id));
+        if (valid_param(motor.can_br)) {
+            can_br << static_cast<int>(motor.can_br) << " "
+                   << br_label(static_cast<int>(motor.can_br));
+        }
+        if (valid_param(motor.ctrl_mode)) {
+            ctrl_mode << ctrl_mode_label(static_cast<int>(motor.ctrl_mode));
+        }
+        if (valid_param(motor.sw_ver)) sw_ver << static_cast<uint32_t>(motor.sw_ver);
+        replies << motor.replies << "/" << motor.refreshes;
+        const char* status = !motor.responded         ? "NG"
+                             : !motor.mst_id_matches ? "ID?"
+                             : motor_ok(motor)        ? "OK"
+                                                      : "LOSS";
+        out << "  " << std::left << std::setw(9) << motor.name << std::setw(6)
+            << hex(motor.send_can_id) << std::setw(6) << hex(motor.recv_can_id) << std::setw(8)
+            << status << std::setw(8) << (mst_id.str().empty() ? "-" : mst_id.str())
+            << std::setw(16) << (can_br.str().empty() ? "-" : can_br.str()) << std::setw(12)
+            << (ctrl_mode.str().empty() ? "-" : ctrl_mode.str()) << std::setw(8)
+            << (sw_ver.str().empty() ? "-" : sw_ver.str()) << std::right << std::setw(7)
+            << replies.str() << std::setprecision(1);
+        if (motor.round_trip.count > 0) {
+            out << std::setw(12) << us(motor.round_trip.value_at_percentile(50)) << std::setw(12)
+                << us(motor.round_trip.value_at_percentile(99)) << std::setw(12)
+                << us(motor.round_trip.max_ns);
+        } else {
+            out << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(12) << "-";
+        }
+        out << "\n";
+    }
+
+    out << "  socket: " << bus.socket.frames_sent << " frames sent, "
+        << bus.socket.frames_received << " received, " << bus.socket.send_errors
+        << " send errors, " << bus.socket.rx_queue_overflows << " RX queue overflows, "
+        << bus.socket.malformed_frames << " malformed, " << bus.unmatched_frames
+        << " unmatched\n";
+    if (link.has_stats) {
+        out << "  netdev: " << link.stats.rx_errors << " RX errors, " << link.stats.tx_errors
+            << " TX errors, " << link.stats.rx_dropped << " RX dropped, "
+            << link.stats.tx_dropped << " TX dropped, " << link.stats.rx_over_errors
+            << " RX overruns\n";
+    }
+    if (link.has_device_stats) {
+        out << "  controller: " << link.device_stats.bus_error << " bus errors (+"
+            << bus_errors_during(bus) << " during the test), " << link.device_stats.error_warning
+            << " error-warning, " << link.device_stats.error_passive << " error-passive, "
+            << link.device_stats.bus_off << " bus-off, " << link.device_stats.arbitration_lost
+            << " arbitration lost, " << link.device_stats.restarts << " restarts";
+        if (link.has_berr_counter) {
+            out << ", txerr " << link.berr_counter.txerr << " rxerr " << link.berr_counter.rxerr;
+        }
+        out << "\n";
+    }
+}
+
+std::string json_string(const std::string& text) {
+    std::ostringstream out;
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+                << std::dec << std::setfill(' ');
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+// Parameters that were not read are null
+std::string json_param(double value) {
+    if (!valid_param(value)) return "null";
+    std::ostringstream out;
+    out << std::setprecision(10) << value;
+    return out.str();
+}
+
+void write_json(std::ostream& out, const std::vector<BusReport>& buses, double seconds) {
+    bool all_ok = true;
+    for (const BusReport& bus : buses) all_ok = all_ok && bus_ok(bus);
+    out << "{\n  \"ok\": " << (all_ok ? "true" : "false") << ",\n  \"seconds\": " << seconds
+        << ",\n  \"interfaces\": [";
+    for (size_t b = 0; b < buses.size(); b++) {
+        const BusReport& bus = buses[b];
+        const LinkInfo& link = bus.link_after.found ? bus.link_after : bus.link_before;
+        out << (b ? "," : "") << "\n    {\n      \"interface\": " << json_string(bus.interface)
+            << ",\n      \"ok\": " << (bus_ok(bus) ? "true" : "false")
+            << ",\n      \"error\": " << (bus.error.empty() ? "null" : json_string(bus.error))
+            << ",\n      \"requested_fd\": " << (bus.requested_fd ? "true" : "false")
+            << ",\n      \"interface_fd\": " << (bus.interface_fd ? "true" : "false")
+            << ",\n      \"seconds\": " << bus.seconds << ",\n      \"warnings\": [";
+        for (size_t i = 0; i < bus.warnings.size(); i++) {
+            out << (i ? ", " : "") << json_string(bus.warnings[i]);
+        }
+        out << "],\n      \"bitrate\": " << link.bitrate
+            << ",\n      \"data_bitrate\": " << link.data_bitrate << ",\n      \"can_state\": "
+            << (link.has_state ? json_string(can_state_label(link.state)) : "null");
+        out << ",\n      \"socket\": {\"frames_sent\": " << bus.socket.frames_sent
+            << ", \"frames_received\": " << bus.socket.frames_received
+            << ", \"send_errors\": " << bus.socket.send_errors
+            << ", \"rx_queue_overflows\": " << bus.socket.rx_queue_overflows
+            << ", \"malformed_frames\": " << bus.socket.malformed_frames
+            << ", \"unmatched_frames\": " << bus.unmatched_frames << "}";
+        out << ",\n      \"netdev\": ";
+        if (link.has_stats) {
+            out << "{\"rx_errors\": " << link.stats.rx_errors
+                << ", \"tx_errors\": " << link.stats.tx_errors
+                << ", \"rx_dropped\": " << link.stats.rx_dropped
+                << ", \"tx_dropped\": " << link.stats.tx_dropped
+                << ", \"rx_over_errors\": " << link.stats.rx_over_errors << "}";
         } else {
-            std::cout << "[arm#" << i << "] queried_mst_id: " << static_cast<uint32_t>(mst)
-                      << "  queried_br: " << static_cast<int>(br) << " ("
-                      << br_label(static_cast<int>(br)) << ")\n";
+            out << "null";
         }
+        out << ",\n      \"controller\": ";
+        if (link.has_device_stats) {
+            out << "{\"bus_error\": " << link.device_stats.bus_error
+                << ", \"bus_errors_during_test\": " << bus_errors_during(bus)
+                << ", \"error_warning\": " << link.device_stats.error_warning
+                << ", \"error_passive\": " << link.device_stats.error_passive
+                << ", \"bus_off\": " << link.device_stats.bus_off
+                << ", \"arbitration_lost\": " << link.device_stats.arbitration_lost
+                << ", \"restarts\": " << link.device_stats.restarts;
+            if (link.has_berr_counter) {
+                out << ", \"txerr\": " << link.berr_counter.txerr
+                    << ", \"rxerr\": " << link.berr_counter.rxerr;
+            }
+            out << "}";
+        } else {
+            out << "null";
+        }
+        out << ",\n      \"motors\": [";
+        for (size_t i = 0; i < bus.motors.size(); i++) {
+            const MotorReport& motor = bus.motors[i];
+            out << (i ? "," : "") << "\n        {\"name\": " << json_string(motor.name)
+                << ", \"send_can_id\": " << motor.send_can_id
+                << ", \"recv_can_id\": " << motor.recv_can_id
+                << ", \"ok\": " << (motor_ok(motor) ? "true" : "false")
+                << ", \"responded\": " << (motor.responded ? "true" : "false")
+                << ", \"mst_id_matches\": " << (motor.mst_id_matches ? "true" : "false")
+                << ", \"mst_id\": " << json_param(motor.mst_id)
+                << ", \"can_br\": " << json_param(motor.can_br)
+                << ", \"ctrl_mode\": " << json_param(motor.ctrl_mode)
+                << ", \"sw_ver\": " << json_param(motor.sw_ver)
+                << ", \"sn\": " << json_param(motor.sn) << ", \"replies\": " << motor.replies
+                << ", \"refreshes\": " << motor.refreshes << ", \"round_trip_us\": ";
+            if (motor.round_trip.count > 0) {
+                out << "{\"min\": " << us(motor.round_trip.min_ns)
+                    << ", \"mean\": " << motor.round_trip.mean_ns / 1000.0
+                    << ", \"p50\": " << us(motor.round_trip.value_at_percentile(50))
+                    << ", \"p99\": " << us(motor.round_trip.value_at_percentile(99))
+                    << ", \"max\": " << us(motor.round_trip.max_ns) << "}";
+            } else {
+                out << "null";
+            }
+            out << "}";
+        }
+        out << "\n      ]\n    }";
     }
+    out << "\n  ]\n}\n";
+}
+
+}  // namespace
 
-    for (size_t i = 0; i < gripper_motors.size(); ++i) {
-        const auto& gr = gripper_motors[i];
-        double mst = gr.get_param((int)openarm::damiao_motor::RID::MST_ID);
-        double br = gr.get_param((int)openarm::damiao_motor::RID::can_br);
+int main(int argc, char* argv[]) {
+    DiagnosisConfig config;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "-h" || arg == "--help") {
+                print_usage(argv[0]);
+                return 0;
+            } else if (arg == "-fd" || arg == "--fd") {
+                config.use_fd = true;
+            } else if (arg == "--json") {
+                config.json_path = value();
+            } else if (arg == "--refreshes") {
+                config.refreshes = std::stoi(value());
+            } else if (arg == "--timeout-ms") {
+                config.timeout = std::chrono::milliseconds(std::stol(value()));
+            } else if (arg == "--sim") {
+                config.simulate = true;
+            } else if (arg == "--sim-motors") {
+                config.simulated_motors = std::stoul(value());
+            } else if (!arg.empty() && arg[0] == '-') {
+                throw std::invalid_argument("Unknown argument '" + arg + "'");
+            } else {
+                config.interfaces.push_back(arg);
+            }
+        }
+        if (config.interfaces.empty()) {
+            if (!config.simulate) throw std::invalid_argument("No CAN interface given");
+            config.interfaces.push_back("dm-sim");
+        }
+        if (config.refreshes < 0 || config.timeout.count() <= 0) {
+            throw std::invalid_argument("--refreshes and --timeout-ms must be positive");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // With the JSON on stdout the human-readable report goes to stderr
+    std::ostream& out = config.json_path == "-" ? std::cerr : std::cout;
+    out << "OpenArm CAN diagnostics: " << config.interfaces.size() << " interface(s)"
+        << (config.simulate ? ", simulated motors" : "") << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<BusReport> buses(config.interfaces.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < config.interfaces.size(); i++) {
+        threads.emplace_back(
+            [&config, &buses, i] { buses[i] = diagnose_bus(config, config.interfaces[i]); });
+    }
+    for (std::thread& thread : threads) thread.join();
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::string> failed;
+    for (const BusReport& bus : buses) {
+        print_bus(out, bus);
+        if (!bus.error.empty()) failed.push_back(bus.interface);
+        for (const MotorReport& motor : bus.motors) {
+            if (!motor_ok(motor)) failed.push_back(bus.interface + ":" + hex(motor.recv_can_id));
+        }
+    }
 
-        if (mst < 0 || br < 0 || !std::isfinite(mst) || !std::isfinite(br)) {
-            std::cout << "[gripper] id=0x18 -> NG (no response)\n";
-            missing_ids.push_back(0x18);
+    if (!config.json_path.empty()) {
+        if (config.json_path == "-") {
+            write_json(std::cout, buses, seconds);
         } else {
-            std::cout << "[gripper] queried_mst_id: " << static_cast<uint32_t>(mst)
-                      << "  queried_br: " << static_cast<int>(br) << " ("
-                      << br_label(static_cast<int>(br)) << ")\n";
+            std::ofstream json(config.json_path);
+            write_json(json, buses, seconds);
+            if (!json) {
+                std::cerr << "WARNING: could not write " << config.json_path << std::endl;
+            }
         }
     }
 
-    if (!missing_ids.empty()) {
-        std::cout << "NG: failed IDs:";
-        for (auto id : missing_ids) std::cout << " 0x" << std::hex << id;
-        std::cout << std::dec << std::endl;
+    out << std::endl << std::fixed << std::setprecision(2);
+    if (!failed.empty()) {
+        out << "NG: failed IDs:";
+        for (const std::string& id : failed) out << " " << id;
+        out << " (" << seconds << " s)" << std::endl;
 
-        std::cout << "Hints:\n";
-        std::cout << "  • Motor internal CAN bitrate may be different from host setting\n";
-        std::cout
+        out << "Hints:\n";
+        out << "  • Motor internal CAN bitrate may be different from host setting\n";
+        out
             << "  • USB2CAN adapter mode/config may be wrong (FD vs Classical, bitrate profile)\n";
-        std::cout << "  • Wiring/power/termination/ID conflict may exist\n";
+        out << "  • Wiring/power/termination/ID conflict may exist\n";
+        out << "  • ID?: the motor answered but its MST_ID is not the expected recv_can_id\n";
         return 2;
-    } else {
-        std::cout << "OK: all motors responded\n";
-        return 0;
     }
+    out << "OK: all motors responded (" << seconds << " s)" << std::endl;
+    return 0;
 }
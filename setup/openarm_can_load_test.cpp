@@ -0,0 +1,371 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Drives OpenArm against simulated Damiao motors at a fixed rate and reports the achieved
+// rate, reply loss and round-trip latency percentiles for every combination of bus and motor
+// counts. Buses are in-process DMMotorSimulator transports, or with --vcan real SocketCAN
+// interfaces (e.g. vcan) answered by a simulator bridged onto each interface.
+
+#include <poll.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <openarm/can/socket/multi_arm_executor.hpp>
+#include <openarm/can/socket/openarm.hpp>
+#include <openarm/canbus/socketcan_transport.hpp>
+#ifdef OPENARM_CAN_HAVE_IO_URING
+#include <openarm/canbus/io_uring_transport.hpp>
+#endif
+#include <openarm/damiao_motor/dm_motor_simulator.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace openarm;
+using damiao_motor::DMMotorSimulator;
+using damiao_motor::DMMotorSimulatorConfig;
+using damiao_motor::DMSimulatedMotorConfig;
+using damiao_motor::MotorType;
+
+namespace {
+
+struct LoadTestConfig {
+    std::vector<size_t> bus_counts{1, 2, 4};
+    std::vector<size_t> motor_counts{8};
+    double rate_hz = 1000.0;
+    double seconds = 2.0;
+    bool enable_fd = false;
+    // With --vcan, bus i runs on vcan_interfaces[i]
+    std::vector<std::string> vcan_interfaces;
+    // With --vcan, drive every bus through one shared io_uring
+    bool io_uring = false;
+    DMMotorSimulatorConfig simulator;
+};
+
+struct LoadTestResult {
+    size_t buses;
+    size_t motors;
+    double achieved_hz;
+    uint64_t cycles;
+    uint64_t overruns;
+    uint64_t expected_replies;
+    uint64_t lost_replies;
+    canbus::HistogramSnapshot round_trip;
+};
+
+void print_usage(const char* program_name) {
+    std::cerr << "Usage: " << program_name << " [options]\n"
+              << "  --buses N[,N...]    bus counts to test (default 1,2,4)\n"
+              << "  --motors N[,N...]   motors per bus to test (default 8)\n"
+              << "  --rate HZ           control rate (default 1000)\n"
+              << "  --seconds S         duration of every run (default 2)\n"
+              << "  --latency-us US     simulated reply latency (default 150)\n"
+              << "  --jitter-us US      simulated reply jitter (default 0)\n"
+              << "  --loss P            simulated reply loss probability (default 0)\n"
+              << "  --fd                use CAN-FD\n"
+              << "  --vcan IF[,IF...]   run on these SocketCAN interfaces instead of in-process\n"
+#ifdef OPENARM_CAN_HAVE_IO_URING
+              << "  --io-uring          with --vcan, use one io_uring for all buses\n"
+#endif
+        ;
+}
+
+template <typename T, typename Parse>
+std::vector<T> parse_list(const std::string& text, Parse parse) {
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) values.push_back(parse(item));
+    return values;
+}
+
+std::vector<DMSimulatedMotorConfig> make_motor_configs(size_t motors) {
+    // OpenArm layout: two DM8009, two DM4340, then DM4310
+    std::vector<DMSimulatedMotorConfig> configs;
+    for (size_t i = 0; i < motors; i++) {
+        MotorType type = i < 2 ? MotorType::DM8009 : i < 4 ? MotorType::DM4340 : MotorType::DM4310;
+        configs.push_back({type, static_cast<uint32_t>(0x01 + i), static_cast<uint32_t>(0x11 + i)});
+    }
+    return configs;
+}
+
+// Answers the commands seen on a SocketCAN interface with a DMMotorSimulator
+class SimulatorBridge {
+public:
+    SimulatorBridge(const std::string& interface, const std::vector<DMSimulatedMotorConfig>& motors,
+                    const DMMotorSimulatorConfig& config)
+        : bus_(interface, config.enable_fd), simulator_(motors, config) {
+        thread_ = std::thread([this] {
+            if (simulator_.is_canfd_enabled()) {
+                run<canfd_frame>();
+            } else {
+                run<can_frame>();
+            }
+        });
+    }
+    ~SimulatorBridge() {
+        running_ = false;
+        thread_.join();
+    }
+
+private:
+    template <typename Frame>
+    void run() {
+        std::vector<Frame> frames(64);
+        canbus::CANReceiveInfo info;
+        pollfd fds[2] = {{bus_.get_fd(), POLLIN, 0}, {simulator_.get_fd(), POLLIN, 0}};
+        while (running_) {
+            if (poll(fds, 2, 10) <= 0) continue;
+            size_t count = bus_.receive(frames.data(), nullptr, frames.size(), info);
+            if (count > 0) simulator_.send(frames.data(), count);
+            count = simulator_.receive(frames.data(), nullptr, frames.size(), info);
+            if (count > 0) bus_.send(frames.data(), count);
+        }
+    }
+
+    canbus::SocketCANTransport bus_;
+    DMMotorSimulator simulator_;
+    std::atomic<bool> running_{true};
+    std::thread thread_;
+};
+
+canbus::HistogramSnapshot merge(const std::vector<canbus::HistogramSnapshot>& snapshots) {
+    canbus::HistogramSnapshot merged;
+    double sum_ns = 0;
+    for (const canbus::HistogramSnapshot& snapshot : snapshots) {
+        if (snapshot.count == 0) continue;
+        if (merged.bucket_counts.size() < snapshot.bucket_counts.size()) {
+            merged.bucket_counts.resize(snapshot.bucket_counts.size());
+        }
+        for (size_t i = 0; i < snapshot.bucket_counts.size(); i++) {
+            merged.bucket_counts[i] += snapshot.bucket_counts[i];
+        }
+        merged.min_ns =
+            merged.count == 0 ? snapshot.min_ns : std::min(merged.min_ns, snapshot.min_ns);
+        merged.max_ns = std::max(merged.max_ns, snapshot.max_ns);
+        merged.count += snapshot.count;
+        sum_ns += snapshot.mean_ns * snapshot.count;
+    }
+    if (merged.count > 0) merged.mean_ns = sum_ns / merged.count;
+    return merged;
+}
+
+LoadTestResult run_load_test(const LoadTestConfig& config, size_t buses, size_t motors) {
+    std::vector<DMSimulatedMotorConfig> motor_configs = make_motor_configs(motors);
+    std::vector<MotorType> motor_types;
+    std::vector<uint32_t> send_can_ids, recv_can_ids;
+    for (const DMSimulatedMotorConfig& motor : motor_configs) {
+        motor_types.push_back(motor.motor_type);
+        send_can_ids.push_back(motor.send_can_id);
+        recv_can_ids.push_back(motor.recv_can_id);
+    }
+
+    std::vector<std::unique_ptr<SimulatorBridge>> bridges;
+    std::vector<std::unique_ptr<can::socket::OpenArm>> arms;
+    can::socket::MultiArmExecutor executor;
+#ifdef OPENARM_CAN_HAVE_IO_URING
+    auto ring = config.io_uring ? std::make_shared<canbus::IoUringContext>() : nullptr;
+#endif
+    for (size_t bus = 0; bus < buses; bus++) {
+        DMMotorSimulatorConfig simulator = config.simulator;
+        simulator.enable_fd = config.enable_fd;
+        simulator.seed += bus;
+        if (config.vcan_interfaces.empty()) {
+            simulator.interface = "dm-sim" + std::to_string(bus);
+            arms.push_back(std::make_unique<can::socket::OpenArm>(
+                std::make_unique<DMMotorSimulator>(motor_configs, simulator)));
+        } else {
+            const std::string& interface = config.vcan_interfaces.at(bus);
+            bridges.push_back(
+                std::make_unique<SimulatorBridge>(interface, motor_configs, simulator));
+#ifdef OPENARM_CAN_HAVE_IO_URING
+            if (ring) {
+                arms.push_back(std::make_unique<can::socket::OpenArm>(
+                    std::make_unique<canbus::IoUringTransport>(interface, config.enable_fd,
+                                                               ring)));
+            } else
+#endif
+                arms.push_back(
+                    std::make_unique<can::socket::OpenArm>(interface, config.enable_fd));
+        }
+        arms.back()->init_arm_motors(motor_types, send_can_ids, recv_can_ids);
+        executor.add_arm(*arms.back());
+    }
+
+    // Collect every enable reply before measuring, a late one would otherwise be taken for
+    // the reply to the first command
+    executor.enable_all();
+    size_t missing_enable_replies = 0;
+    for (const auto& missing : executor.recv_until_complete(std::chrono::steady_clock::now() +
+                                                             std::chrono::milliseconds(50))) {
+        missing_enable_replies += missing.size();
+    }
+    if (missing_enable_replies > 0) {
+        std::cerr << "WARNING: " << missing_enable_replies << " motors did not answer enable"
+                  << std::endl;
+    }
+    for (auto& arm : arms) arm->reset_stats();
+
+    std::vector<double> kp(motors, 20.0), kd(motors, 1.0), q(motors), dq(motors), tau(motors);
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / config.rate_hz));
+    uint64_t total_cycles = static_cast<uint64_t>(config.seconds * config.rate_hz);
+
+    LoadTestResult result{buses, motors, 0, 0, 0, 0, 0, {}};
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    for (uint64_t cycle = 0; cycle < total_cycles; cycle++) {
+        double t = std::chrono::duration<double>(next - start).count();
+        for (size_t i = 0; i < motors; i++) {
+            q[i] = 0.5 * std::sin(2 * M_PI * 0.5 * t + i);
+            dq[i] = 0.5 * M_PI * std::cos(2 * M_PI * 0.5 * t + i);
+        }
+        for (auto& arm : arms) {
+            arm->get_arm().mit_control_all(kp.data(), kd.data(), q.data(), dq.data(), tau.data(),
+                                           motors);
+        }
+        next += period;
+        // Replies not in by the end of the cycle count as lost
+        for (const auto& missing : executor.recv_until_complete(next)) {
+            result.lost_replies += missing.size();
+        }
+        result.expected_replies += buses * motors;
+        result.cycles++;
+        auto now = std::chrono::steady_clock::now();
+        if (now > next) {
+            result.overruns++;
+            // Do not try to catch up on missed cycles
+            next = now;
+        } else {
+            std::this_thread::sleep_until(next);
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.achieved_hz = result.cycles / elapsed.count();
+
+    std::vector<canbus::HistogramSnapshot> round_trips;
+    for (auto& arm : arms) {
+        for (const auto& motor : arm->get_stats().motors) round_trips.push_back(motor.round_trip);
+    }
+    result.round_trip = merge(round_trips);
+
+    executor.disable_all();
+    executor.recv_until_complete(std::chrono::steady_clock::now() + std::chrono::milliseconds(50));
+    return result;
+}
+
+void print_result(const LoadTestResult& result) {
+    auto us = [](uint64_t ns) { return ns / 1000.0; };
+    double loss = result.expected_replies
+                      ? 100.0 * result.lost_replies / result.expected_replies
+                      : 0.0;
+    std::cout << std::fixed << std::setprecision(1) << std::setw(5) << result.buses
+              << std::setw(7) << result.motors << std::setw(11) << result.achieved_hz
+              << std::setw(9) << result.overruns << std::setprecision(3) << std::setw(9) << loss
+              << std::setprecision(1) << std::setw(9)
+              << us(result.round_trip.value_at_percentile(50)) << std::setw(9)
+              << us(result.round_trip.value_at_percentile(90)) << std::setw(9)
+              << us(result.round_trip.value_at_percentile(99)) << std::setw(9)
+              << us(result.round_trip.value_at_percentile(99.9)) << std::setw(9)
+              << us(result.round_trip.max_ns) << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    LoadTestConfig config;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            auto to_size = [](const std::string& text) -> size_t { return std::stoul(text); };
+            if (arg == "-h" || arg == "--help") {
+                print_usage(argv[0]);
+                return 0;
+            } else if (arg == "--buses") {
+                config.bus_counts = parse_list<size_t>(value(), to_size);
+            } else if (arg == "--motors") {
+                config.motor_counts = parse_list<size_t>(value(), to_size);
+            } else if (arg == "--rate") {
+                config.rate_hz = std::stod(value());
+            } else if (arg == "--seconds") {
+                config.seconds = std::stod(value());
+            } else if (arg == "--latency-us") {
+                config.simulator.reply_latency = std::chrono::microseconds(std::stol(value()));
+            } else if (arg == "--jitter-us") {
+                config.simulator.reply_jitter = std::chrono::microseconds(std::stol(value()));
+            } else if (arg == "--loss") {
+                config.simulator.reply_loss = std::stod(value());
+            } else if (arg == "--fd") {
+                config.enable_fd = true;
+#ifdef OPENARM_CAN_HAVE_IO_URING
+            } else if (arg == "--io-uring") {
+                config.io_uring = true;
+#endif
+            } else if (arg == "--vcan") {
+                config.vcan_interfaces =
+                    parse_list<std::string>(value(), [](const std::string& text) { return text; });
+            } else {
+                throw std::invalid_argument("Unknown argument '" + arg + "'");
+            }
+        }
+        if (config.io_uring && config.vcan_interfaces.empty()) {
+            throw std::invalid_argument("--io-uring needs --vcan");
+        }
+        if (config.rate_hz <= 0 || config.seconds <= 0) {
+            throw std::invalid_argument("--rate and --seconds must be positive");
+        }
+        for (size_t buses : config.bus_counts) {
+            if (!config.vcan_interfaces.empty() && buses > config.vcan_interfaces.size()) {
+                throw std::invalid_argument("--vcan lists fewer interfaces than buses");
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // Physical joints, so commands are tracked like a real arm would
+    config.simulator.joint_inertia = 0.02;
+    config.simulator.joint_damping = 0.1;
+    if (config.enable_fd) config.simulator.data_bitrate = 5000000;
+
+    std::cout << "OpenArm CAN load test: " << config.rate_hz << " Hz, " << config.seconds
+              << " s per run, " << (config.vcan_interfaces.empty() ? "in-process" : "SocketCAN")
+              << " buses, " << (config.enable_fd ? "CAN FD" : "Classical CAN") << "\n";
+    std::cout << "buses motors   rate_hz overruns   loss_%   p50_us   p90_us   p99_us p99.9_us"
+                 "   max_us"
+              << std::endl;
+    try {
+        for (size_t motors : config.motor_counts) {
+            for (size_t buses : config.bus_counts) {
+                print_result(run_load_test(config, buses, motors));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -36,7 +36,7 @@ void ArmComponent::init_motor_devices(const std::vector<damiao_motor::MotorType>
         // Then create the device with a reference to the stored motor
         auto motor_device =
             std::make_shared<damiao_motor::DMCANDevice>(motors_.back(), CAN_SFF_MASK, use_fd);
-        get_device_collection().add_device(motor_device);
+        add_device(motor_device);
     }
 }
 
@@ -0,0 +1,171 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <openarm/can/socket/command_slots.hpp>
+#include <stdexcept>
+#include <string>
+
+namespace openarm::can::socket {
+
+CommandSlots::CommandSlots(OpenArm& openarm)
+    : openarm_(openarm),
+      arm_joints_(openarm.get_arm().get_dm_devices().size()),
+      size_(arm_joints_ + openarm.get_gripper().get_dm_devices().size()),
+      slots_(std::make_unique<Slot[]>(size_)),
+      snapshot_(std::make_unique<Setpoint[]>(size_)) {}
+
+void CommandSlots::check_joint(size_t joint) const {
+    if (joint >= size_) {
+        throw std::invalid_argument("Joint " + std::to_string(joint) + " out of range, only " +
+                                    std::to_string(size_) + " joints");
+    }
+}
+
+void CommandSlots::check_joints(size_t first, size_t count) const {
+    if (first > size_ || count > size_ - first) {
+        throw std::invalid_argument("Joints " + std::to_string(first) + " to " +
+                                    std::to_string(first + count - 1) + " out of range, only " +
+                                    std::to_string(size_) + " joints");
+    }
+}
+
+void CommandSlots::set_mit(size_t joint, const damiao_motor::MITParam& mit_param) {
+    Setpoint setpoint;
+    setpoint.kind = SetpointKind::MIT;
+    setpoint.mit = mit_param;
+    write(joint, setpoint);
+}
+
+void CommandSlots::set_posvel(size_t joint, const damiao_motor::PosVelParam& posvel_param) {
+    Setpoint setpoint;
+    setpoint.kind = SetpointKind::POS_VEL;
+    setpoint.posvel = posvel_param;
+    write(joint, setpoint);
+}
+
+void CommandSlots::set_mit_all(const damiao_motor::MITParam* mit_params, size_t count,
+                               size_t first) {
+    write_group(first, count, [mit_params](size_t k) {
+        Setpoint setpoint;
+        setpoint.kind = SetpointKind::MIT;
+        setpoint.mit = mit_params[k];
+        return setpoint;
+    });
+}
+
+void CommandSlots::set_posvel_all(const damiao_motor::PosVelParam* posvel_params, size_t count,
+                                  size_t first) {
+    write_group(first, count, [posvel_params](size_t k) {
+        Setpoint setpoint;
+        setpoint.kind = SetpointKind::POS_VEL;
+        setpoint.posvel = posvel_params[k];
+        return setpoint;
+    });
+}
+
+void CommandSlots::clear(size_t joint) { write(joint, Setpoint()); }
+
+void CommandSlots::clear_all() {
+    write_group(0, size_, [](size_t) { return Setpoint(); });
+}
+
+uint64_t CommandSlots::get_updates(size_t joint) const {
+    check_joint(joint);
+    // Every write advances the sequence by two
+    return slots_[joint].seq.load(std::memory_order_relaxed) / 2;
+}
+
+void CommandSlots::write(size_t joint, const Setpoint& setpoint) {
+    check_joint(joint);
+    Slot& slot = slots_[joint];
+    // Seqlock write side. Unlike the joint state there may be several writers, so the odd
+    // sequence is claimed with a CAS and a second writer waits for the first to finish.
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    do {
+        while (seq & 1) seq = slot.seq.load(std::memory_order_relaxed);
+    } while (!slot.seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                             std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.setpoint = setpoint;
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+template <typename SetpointAt>
+void CommandSlots::write_group(size_t first, size_t count, const SetpointAt& setpoint_at) {
+    check_joints(first, count);
+    // Group seqlock write side, claimed like a slot. The slot writes below keep readers of
+    // single slots and writers of the same joints consistent as before.
+    uint32_t seq = group_seq_.load(std::memory_order_relaxed);
+    do {
+        while (seq & 1) seq = group_seq_.load(std::memory_order_relaxed);
+    } while (!group_seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                               std::memory_order_relaxed));
+    for (size_t k = 0; k < count; k++) write(first + k, setpoint_at(k));
+    group_seq_.store(seq + 2, std::memory_order_release);
+}
+
+CommandSlots::Setpoint CommandSlots::read(size_t joint) const {
+    const Slot& slot = slots_[joint];
+    Setpoint setpoint;
+    uint32_t seq_begin, seq_end;
+    do {
+        seq_begin = slot.seq.load(std::memory_order_acquire);
+        setpoint = slot.setpoint;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq_end = slot.seq.load(std::memory_order_relaxed);
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+    return setpoint;
+}
+
+void CommandSlots::read_snapshot() {
+    // Group seqlock read side: retry while a group write overlapped the snapshot
+    uint32_t seq_begin, seq_end;
+    do {
+        seq_begin = group_seq_.load(std::memory_order_acquire);
+        if (seq_begin & 1) continue;
+        for (size_t joint = 0; joint < size_; joint++) snapshot_[joint] = read(joint);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq_end = group_seq_.load(std::memory_order_relaxed);
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+}
+
+CycleResult CommandSlots::send(const CycleConfig& config) {
+    read_snapshot();
+    return openarm_.send_cycle(
+        [this](damiao_motor::DMDeviceCollection& device_collection, int i, size_t index) {
+            if (index >= size_) return false;
+            const Setpoint& setpoint = snapshot_[index];
+            switch (setpoint.kind) {
+                case SetpointKind::MIT:
+                    device_collection.mit_control_one(i, setpoint.mit);
+                    return true;
+                case SetpointKind::POS_VEL:
+                    device_collection.posvel_control_one(i, setpoint.posvel);
+                    return true;
+                case SetpointKind::NONE:
+                    break;
+            }
+            return false;
+        },
+        config);
+}
+
+CycleResult CommandSlots::cycle(const CycleConfig& config) {
+    auto start = std::chrono::steady_clock::now();
+    CycleResult result = send(config);
+    result.timed_out = openarm_.recv_until_complete(start + config.reply_timeout);
+    return result;
+}
+
+}  // namespace openarm::can::socket
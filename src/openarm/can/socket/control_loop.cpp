@@ -0,0 +1,151 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <time.h>
+
+#include <algorithm>
+#include <openarm/can/socket/control_loop.hpp>
+#include <stdexcept>
+
+namespace openarm::can::socket {
+
+namespace {
+// steady_clock is CLOCK_MONOTONIC, which is what clock_nanosleep() sleeps on
+int64_t monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+void sleep_until_ns(int64_t deadline_ns) {
+    struct timespec deadline;
+    deadline.tv_sec = deadline_ns / 1000000000;
+    deadline.tv_nsec = deadline_ns % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+}
+}  // namespace
+
+ControlLoop::ControlLoop(OpenArm& openarm, const ControlLoopConfig& config)
+    : openarm_(openarm), config_(config) {
+    if (config_.period.count() <= 0) {
+        throw std::invalid_argument("ControlLoop period must be positive");
+    }
+}
+
+void ControlLoop::run(const Callback& callback) {
+    if (running_.exchange(true)) {
+        throw std::logic_error("ControlLoop is already running");
+    }
+    if (config_.lock_memory) lock_process_memory();
+    configure_current_thread(config_.thread);
+
+    canbus::CANSocket& can_socket = openarm_.get_can_socket();
+    const int64_t period_ns = config_.period.count();
+    const int64_t rx_timeout_ns = std::min(config_.rx_timeout.count(), period_ns);
+    // Commands sent by the callback are held in this batch until the next tick
+    bool holding_commands = false;
+    ControlTick tick{0, 0, 0, {}};
+    int64_t scheduled_ns = monotonic_ns();
+
+    try {
+        while (running_.load(std::memory_order_relaxed)) {
+            sleep_until_ns(scheduled_ns);
+            const int64_t wakeup_ns = monotonic_ns();
+            wakeup_latency_histogram_.record(
+                static_cast<uint64_t>(std::max<int64_t>(wakeup_ns - scheduled_ns, 0)));
+
+            // 1. TX
+            if (holding_commands) {
+                can_socket.end_batch();
+                holding_commands = false;
+                // The replies are due from now, not from when the callback queued the commands
+                openarm_.restamp_pending_replies();
+            }
+
+            // 2. RX
+            receive(tick, std::chrono::steady_clock::time_point(
+                              std::chrono::nanoseconds(scheduled_ns + rx_timeout_ns)));
+
+            // 3. publish
+            openarm_.get_arm().read_state(arm_state_);
+            openarm_.get_gripper().read_state(gripper_state_);
+
+            // 4. compute
+            tick.scheduled_ns = scheduled_ns;
+            tick.wakeup_ns = wakeup_ns;
+            can_socket.begin_batch();
+            holding_commands = true;
+            bool keep_running = callback(tick);
+            tick.index++;
+
+            const int64_t done_ns = monotonic_ns();
+            tick_duration_histogram_.record(static_cast<uint64_t>(done_ns - wakeup_ns));
+            ticks_.fetch_add(1, std::memory_order_relaxed);
+
+            scheduled_ns += period_ns;
+            if (done_ns > scheduled_ns) {
+                // Run the late tick right away, but drop the ticks that are entirely
+                // in the past so the loop gets back in phase
+                overruns_.fetch_add(1, std::memory_order_relaxed);
+                int64_t missed = (done_ns - scheduled_ns) / period_ns;
+                missed_ticks_.fetch_add(missed, std::memory_order_relaxed);
+                scheduled_ns += missed * period_ns;
+            }
+            if (!keep_running) break;
+        }
+    } catch (...) {
+        if (holding_commands) can_socket.end_batch();
+        running_.store(false);
+        throw;
+    }
+
+    // The commands of the last tick still go out
+    if (holding_commands) can_socket.end_batch();
+    running_.store(false);
+}
+
+void ControlLoop::receive(ControlTick& tick, std::chrono::steady_clock::time_point deadline) {
+    if (openarm_.has_pending_replies()) {
+        tick.timed_out = openarm_.recv_until_complete(deadline);
+        rx_timeouts_.fetch_add(tick.timed_out.size(), std::memory_order_relaxed);
+    } else {
+        // Nothing to wait for, only pick up what is already queued
+        tick.timed_out.clear();
+        openarm_.recv_queued();
+    }
+}
+
+ControlLoopStats ControlLoop::get_stats() const {
+    ControlLoopStats stats;
+    stats.ticks = ticks_.load(std::memory_order_relaxed);
+    stats.overruns = overruns_.load(std::memory_order_relaxed);
+    stats.missed_ticks = missed_ticks_.load(std::memory_order_relaxed);
+    stats.rx_timeouts = rx_timeouts_.load(std::memory_order_relaxed);
+    stats.wakeup_latency = wakeup_latency_histogram_.snapshot();
+    stats.tick_duration = tick_duration_histogram_.snapshot();
+    return stats;
+}
+
+void ControlLoop::reset_stats() {
+    ticks_.store(0, std::memory_order_relaxed);
+    overruns_.store(0, std::memory_order_relaxed);
+    missed_ticks_.store(0, std::memory_order_relaxed);
+    rx_timeouts_.store(0, std::memory_order_relaxed);
+    wakeup_latency_histogram_.reset();
+    tick_duration_histogram_.reset();
+}
+
+}  // namespace openarm::can::socket
@@ -29,7 +29,7 @@ void GripperComponent::init_motor_device(damiao_motor::MotorType motor_type, uin
     motor_ = std::make_unique<damiao_motor::Motor>(motor_type, send_can_id, recv_can_id);
     // Create the device with a reference to the motor
     motor_device_ = std::make_shared<damiao_motor::DMCANDevice>(*motor_, CAN_SFF_MASK, use_fd);
-    get_device_collection().add_device(motor_device_);
+    add_device(motor_device_);
 }
 
 void GripperComponent::open(double kp, double kd) { set_position(gripper_open_position_, kp, kd); }
@@ -41,8 +41,12 @@ void GripperComponent::close(double kp, double kd) {
 void GripperComponent::set_position(double gripper_position, double kp, double kd) {
     if (!motor_device_) return;
 
+    mit_control_one(0, position_command(gripper_position, kp, kd));
+}
+
+damiao_motor::MITParam GripperComponent::position_command(double gripper_position, double kp,
+                                                          double kd) const {
     // MIT control to desired position (zero velocity and torque)
-    mit_control_one(
-        0, damiao_motor::MITParam{kp, kd, gripper_to_motor_position(gripper_position), 0.0, 0.0});
+    return damiao_motor::MITParam{kp, kd, gripper_to_motor_position(gripper_position), 0.0, 0.0};
 }
 }  // namespace openarm::can::socket
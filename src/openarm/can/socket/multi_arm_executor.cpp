@@ -0,0 +1,140 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openarm/can/socket/multi_arm_executor.hpp>
+#include <stdexcept>
+#include <string>
+
+namespace openarm::can::socket {
+
+namespace {
+// One epoll_event per bus is plenty, the openarm-can-configure-socketcan-4-arms setup has 4
+constexpr int kMaxEvents = 16;
+}  // namespace
+
+MultiArmExecutor::MultiArmExecutor() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {
+    if (epoll_fd_ < 0) {
+        throw canbus::CANSocketException(std::string("Failed to create epoll instance: ") +
+                                         strerror(errno));
+    }
+}
+
+MultiArmExecutor::~MultiArmExecutor() {
+    stop_receivers();
+    close(epoll_fd_);
+}
+
+void MultiArmExecutor::add_arm(OpenArm& openarm) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = arms_.size();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, openarm.get_socket_fd(), &event) < 0) {
+        throw canbus::CANSocketException("Failed to add " + openarm.can_interface() +
+                                         " to epoll: " + strerror(errno));
+    }
+    arms_.push_back(&openarm);
+    progress_.reserve(arms_.size());
+}
+
+void MultiArmExecutor::enable_all() {
+    for (OpenArm* arm : arms_) arm->enable_all();
+}
+
+void MultiArmExecutor::disable_all() {
+    for (OpenArm* arm : arms_) arm->disable_all();
+}
+
+void MultiArmExecutor::refresh_all() {
+    for (OpenArm* arm : arms_) arm->refresh_all();
+}
+
+void MultiArmExecutor::recv_all(int timeout_us) {
+    progress_.clear();
+    for (OpenArm* arm : arms_) progress_.push_back(arm->begin_recv());
+    while (!is_recv_complete(progress_) && wait_and_drain(timeout_us, progress_)) {
+    }
+    for (size_t i = 0; i < arms_.size(); i++) arms_[i]->end_recv(progress_[i]);
+}
+
+std::vector<std::vector<uint32_t>> MultiArmExecutor::recv_until_complete(
+    std::chrono::steady_clock::time_point deadline) {
+    progress_.clear();
+    for (OpenArm* arm : arms_) progress_.push_back(arm->begin_recv(false));
+    while (!is_recv_complete(progress_)) {
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0 || !wait_and_drain(remaining.count(), progress_)) break;
+    }
+
+    std::vector<std::vector<uint32_t>> timed_out;
+    for (size_t i = 0; i < arms_.size(); i++) timed_out.push_back(arms_[i]->end_recv(progress_[i]));
+    return timed_out;
+}
+
+bool MultiArmExecutor::is_recv_complete(
+    const std::vector<OpenArm::RecvProgress>& progress) const {
+    for (size_t i = 0; i < arms_.size(); i++) {
+        if (!arms_[i]->is_recv_complete(progress[i])) return false;
+    }
+    return true;
+}
+
+bool MultiArmExecutor::wait_and_drain(int timeout_us,
+                                      std::vector<OpenArm::RecvProgress>& progress) {
+    struct epoll_event events[kMaxEvents];
+    int n_events;
+    do {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 35))
+        // epoll_pwait2() keeps the microsecond timeout, epoll_wait() only has milliseconds
+        struct timespec timeout;
+        timeout.tv_sec = timeout_us / 1000000;
+        timeout.tv_nsec = (timeout_us % 1000000) * 1000;
+        n_events = epoll_pwait2(epoll_fd_, events, kMaxEvents, &timeout, nullptr);
+        if (n_events < 0 && errno == ENOSYS) {
+            n_events = epoll_wait(epoll_fd_, events, kMaxEvents, (timeout_us + 999) / 1000);
+        }
+#else
+        n_events = epoll_wait(epoll_fd_, events, kMaxEvents, (timeout_us + 999) / 1000);
+#endif
+    } while (n_events < 0 && errno == EINTR);
+
+    // Buses that are already complete are drained too, their frames are fresh state
+    for (int i = 0; i < n_events; i++) {
+        size_t index = events[i].data.u64;
+        arms_[index]->recv_ready(progress[index]);
+    }
+    return n_events > 0;
+}
+
+void MultiArmExecutor::start_receivers(const std::vector<ReceiverConfig>& configs) {
+    if (configs.size() != arms_.size()) {
+        throw std::invalid_argument("One receiver config per arm is required, got " +
+                                    std::to_string(configs.size()) + " for " +
+                                    std::to_string(arms_.size()) + " arms");
+    }
+    for (size_t i = 0; i < arms_.size(); i++) arms_[i]->start_receiver(configs[i]);
+}
+
+void MultiArmExecutor::stop_receivers() {
+    for (OpenArm* arm : arms_) arm->stop_receiver();
+}
+
+}  // namespace openarm::can::socket
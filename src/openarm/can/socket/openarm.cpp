@@ -17,15 +17,41 @@
 
 #include <iostream>
 #include <openarm/can/socket/openarm.hpp>
+#include <stdexcept>
 
 namespace openarm::can::socket {
 
 OpenArm::OpenArm(const std::string& can_interface, bool enable_fd)
-    : can_interface_(can_interface), enable_fd_(enable_fd) {
-    can_socket_ = std::make_unique<canbus::CANSocket>(can_interface_, enable_fd_);
+    : OpenArm(std::make_unique<canbus::CANSocket>(can_interface, enable_fd)) {}
+
+OpenArm::OpenArm(std::unique_ptr<canbus::CANTransport> transport)
+    : OpenArm(std::make_unique<canbus::CANSocket>(std::move(transport))) {}
+
+OpenArm::OpenArm(std::unique_ptr<canbus::CANSocket> can_socket)
+    : can_interface_(can_socket->get_interface()),
+      enable_fd_(can_socket->is_canfd_enabled()),
+      can_socket_(std::move(can_socket)) {
     master_can_device_collection_ = std::make_unique<canbus::CANDeviceCollection>(*can_socket_);
+    master_can_device_collection_->set_kernel_filtering(true);
+    // Receive times tell a late reply to an earlier command from the reply to the latest
+    // one (see DMDeviceCollection::clear_pending_reply()). Best effort, the stack works
+    // without them.
+    can_socket_->enable_timestamping(canbus::TimestampMode::SOFTWARE);
     arm_ = std::make_unique<ArmComponent>(*can_socket_);
     gripper_ = std::make_unique<GripperComponent>(*can_socket_);
+    if (enable_fd_) {
+        rx_canfd_frames_.resize(RECV_BATCH_SIZE);
+    } else {
+        rx_can_frames_.resize(RECV_BATCH_SIZE);
+    }
+    rx_timestamps_.resize(RECV_BATCH_SIZE);
+}
+
+OpenArm::~OpenArm() {
+    stop_receiver();
+    stop_pipeline();
+    stop_recording();
+    can_socket_->set_frame_recorder(nullptr);
 }
 
 void OpenArm::init_arm_motors(const std::vector<damiao_motor::MotorType>& motor_types,
@@ -56,18 +82,21 @@ void OpenArm::register_dm_device_collection(damiao_motor::DMDeviceCollection& de
 }
 
 void OpenArm::enable_all() {
+    canbus::CANSocketBatch batch(*can_socket_);
     for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
         device_collection->enable_all();
     }
 }
 
 void OpenArm::set_zero_all() {
+    canbus::CANSocketBatch batch(*can_socket_);
     for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
         device_collection->set_zero_all();
     }
 }
 
 void OpenArm::refresh_all() {
+    canbus::CANSocketBatch batch(*can_socket_);
     for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
         device_collection->refresh_all();
     }
@@ -80,35 +109,438 @@ void OpenArm::refresh_one(int i) {
 }
 
 void OpenArm::disable_all() {
+    canbus::CANSocketBatch batch(*can_socket_);
     for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
         device_collection->disable_all();
     }
 }
 
+size_t OpenArm::load_params_all(const std::vector<int>& rids, size_t max_in_flight,
+                                std::chrono::microseconds timeout) {
+    for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+        device_collection->queue_param_queries_all(rids);
+    }
+    return run_param_queries(max_in_flight, timeout);
+}
+
+size_t OpenArm::run_param_queries(size_t max_in_flight, std::chrono::microseconds timeout) {
+    while (true) {
+        size_t remaining = 0;
+        for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+            remaining += device_collection->pump_param_queries(max_in_flight, timeout);
+        }
+        if (remaining == 0) break;
+        if (is_receiver_running()) {
+            // The receiver decodes the replies, just give it time
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        } else if (can_socket_->is_data_available(100)) {
+            drain_socket(false);
+        }
+    }
+
+    size_t failed = 0;
+    for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+        failed += device_collection->get_failed_param_queries().size();
+    }
+    return failed;
+}
+
+ParamLoadResult OpenArm::load_params_cached(const std::vector<int>& rids,
+                                            const std::string& cache_path, bool apply_limits,
+                                            size_t max_in_flight,
+                                            std::chrono::microseconds timeout) {
+    using damiao_motor::RID;
+    // set_limits() rewrites the scales the receiver decodes state frames with
+    if (apply_limits) check_receiver_stopped("load_params_cached with apply_limits");
+    ParamLoadResult result;
+    ParamCache cache(cache_path);
+    cache.load();
+
+    // Fingerprint every motor, then fully read only those the cache doesn't cover
+    result.failed += load_params_all({static_cast<int>(RID::SN), static_cast<int>(RID::sw_ver)},
+                                     max_in_flight, timeout);
+    std::vector<damiao_motor::Motor*> queried_motors;
+    for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+        // Fingerprint failures are counted already, only count the full reads below
+        device_collection->clear_failed_param_queries();
+        const auto& dm_devices = device_collection->get_dm_devices();
+        for (size_t i = 0; i < dm_devices.size(); i++) {
+            damiao_motor::Motor& motor = dm_devices[i]->get_motor();
+            const CachedMotorParams* entry = cache.find(can_interface_, motor.get_recv_can_id());
+            if (entry && ParamCache::is_valid_for(*entry, motor, rids)) {
+                for (int rid : rids) motor.set_temp_param(rid, entry->params.at(rid));
+                result.cached++;
+            } else {
+                device_collection->queue_param_queries(i, rids);
+                queried_motors.push_back(&motor);
+            }
+        }
+    }
+    if (!queried_motors.empty()) {
+        result.queried = queried_motors.size();
+        result.failed += run_param_queries(max_in_flight, timeout);
+        for (damiao_motor::Motor* motor : queried_motors) {
+            // Without a fingerprint the entry could never be trusted later
+            if (motor->get_param(static_cast<int>(RID::SN)) < 0) continue;
+            cache.store(can_interface_, *motor, rids);
+        }
+        if (!cache.save()) {
+            std::cerr << "WARNING: could not write the parameter cache " << cache.get_path()
+                      << std::endl;
+        }
+    }
+
+    if (apply_limits) {
+        for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+            for (damiao_motor::DMCANDevice* dm_device : device_collection->get_dm_devices()) {
+                damiao_motor::Motor& motor = dm_device->get_motor();
+                damiao_motor::LimitParam limits{motor.get_param(static_cast<int>(RID::PMAX)),
+                                                motor.get_param(static_cast<int>(RID::VMAX)),
+                                                motor.get_param(static_cast<int>(RID::TMAX))};
+                if (limits.pMax > 0 && limits.vMax > 0 && limits.tMax > 0) {
+                    motor.set_limits(limits);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+void OpenArm::set_packed_framing(const damiao_motor::PackedFramingConfig& config) {
+    // The arm replaces its reply devices, drop the previous ones from the dispatch table
+    auto previous = arm_->get_packed_reply_devices();
+    arm_->set_packed_framing(config);
+    for (const auto& device : previous) master_can_device_collection_->remove_device(device);
+    for (const auto& device : arm_->get_packed_reply_devices()) {
+        master_can_device_collection_->add_device(device);
+    }
+}
+
+damiao_motor::FramingMode OpenArm::probe_framing(std::chrono::microseconds timeout) {
+    check_receiver_stopped("probe_framing");
+    arm_->set_callback_mode_all(damiao_motor::CallbackMode::PARAM);
+    for (damiao_motor::RID rid : {damiao_motor::RID::sw_ver, damiao_motor::RID::sub_ver}) {
+        arm_->query_param_all(static_cast<int>(rid));
+        recv_until_complete(std::chrono::steady_clock::now() + timeout);
+    }
+    arm_->set_callback_mode_all(damiao_motor::CallbackMode::STATE);
+    return arm_->select_framing_mode();
+}
+
 void OpenArm::recv_all(int timeout_us) {
-    // The timeout for select() is set to timeout_us (default: 500 us).
+    // The timeout for poll() is set to timeout_us (default: 500 us).
     // Tuning this value may improve the performance but should be done with caution.
+    //
+    // Each wake-up drains everything queued on the socket with one recvmmsg(). If the last
+    // commands armed expected replies, we return as soon as all of them arrived. Otherwise we
+    // return once every registered motor could have replied.
+    const auto start = std::chrono::steady_clock::now();
+    RecvProgress progress = begin_recv();
+    while (!is_recv_complete(progress) && can_socket_->is_data_available(timeout_us)) {
+        recv_ready(progress);
+    }
+    end_recv(progress);
+    recv_all_histogram_.record(std::chrono::steady_clock::now() - start);
+}
+
+std::vector<uint32_t> OpenArm::recv_until_complete(
+    std::chrono::steady_clock::time_point deadline) {
+    check_receiver_stopped("recv_until_complete");
+
+    while (has_pending_replies()) {
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0 || !can_socket_->is_data_available(remaining.count())) {
+            break;
+        }
+        drain_socket();
+    }
+    return expire_pending_replies();
+}
+
+CycleResult OpenArm::cycle(const std::vector<damiao_motor::MITParam>& commands,
+                           const CycleConfig& config) {
+    return run_cycle(
+        [&commands](damiao_motor::DMDeviceCollection& device_collection, int i, size_t index) {
+            if (index >= commands.size()) return false;
+            device_collection.mit_control_one(i, commands[index]);
+            return true;
+        },
+        config);
+}
+
+CycleResult OpenArm::cycle(const std::vector<damiao_motor::PosVelParam>& commands,
+                           const CycleConfig& config) {
+    return run_cycle(
+        [&commands](damiao_motor::DMDeviceCollection& device_collection, int i, size_t index) {
+            if (index >= commands.size()) return false;
+            device_collection.posvel_control_one(i, commands[index]);
+            return true;
+        },
+        config);
+}
+
+CycleResult OpenArm::run_cycle(const CycleCommandFn& send_command, const CycleConfig& config) {
+    auto start = std::chrono::steady_clock::now();
+    CycleResult result = send_cycle(send_command, config);
+    result.timed_out = recv_until_complete(start + config.reply_timeout);
+    return result;
+}
+
+CycleResult OpenArm::send_cycle(const CycleCommandFn& send_command, const CycleConfig& config) {
+    check_receiver_stopped("cycle");
+    // Late replies to the previous commands must not clear the pending bits armed below,
+    // also when the socket gives no timestamps to tell them apart
+    while (can_socket_->is_data_available(0)) drain_socket(false);
+    auto start = std::chrono::steady_clock::now();
+    int64_t now_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count();
+    int64_t max_age_ns = std::chrono::nanoseconds(config.max_state_age).count();
+    int64_t disabled_max_age_ns = std::chrono::nanoseconds(config.disabled_max_state_age).count();
+
+    CycleResult result;
+    {
+        canbus::CANSocketBatch batch(*can_socket_);
+        size_t index = 0;
+        for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+            device_collection->clear_pending_replies();
+            const auto& dm_devices = device_collection->get_dm_devices();
+            for (size_t i = 0; i < dm_devices.size(); i++, index++) {
+                const damiao_motor::Motor& motor = dm_devices[i]->get_motor();
+                bool enabled = motor.is_enabled();
+                if (enabled && send_command(*device_collection, i, index)) {
+                    result.commands_sent++;
+                    continue;
+                }
+                int64_t age_ns = now_ns - motor.get_state_timestamp_ns();
+                if (motor.get_state_timestamp_ns() == 0 ||
+                    age_ns >= (enabled ? max_age_ns : disabled_max_age_ns)) {
+                    device_collection->refresh_one(i);
+                    result.refreshes_sent++;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+OpenArm::RecvProgress OpenArm::begin_recv(bool expect_all) {
+    check_receiver_stopped("recv_all");
+    RecvProgress progress{false, 0};
+    if (expect_all && !has_pending_replies()) {
+        // Counting frames would let two replies of one motor cover a silent one
+        for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+            device_collection->set_pending_replies_all();
+        }
+        progress.expect_all = true;
+    }
+    return progress;
+}
+
+bool OpenArm::is_recv_complete(const RecvProgress& /*progress*/) const {
+    return !has_pending_replies();
+}
+
+void OpenArm::recv_ready(RecvProgress& progress) { progress.replies += drain_socket(); }
 
+size_t OpenArm::recv_queued() {
+    check_receiver_stopped("recv_queued");
+    size_t replies = 0;
+    while (can_socket_->is_data_available(0)) replies += drain_socket();
+    return replies;
+}
+
+std::vector<uint32_t> OpenArm::end_recv(RecvProgress& /*progress*/) {
+    return expire_pending_replies();
+}
+
+std::vector<uint32_t> OpenArm::expire_pending_replies() {
+    std::vector<uint32_t> timed_out;
+    for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+        if (!device_collection->has_pending_replies()) continue;
+        const auto& dm_devices = device_collection->get_dm_devices();
+        for (int i : device_collection->get_pending_replies()) {
+            timed_out.push_back(dm_devices[i]->get_recv_can_id());
+        }
+        device_collection->clear_pending_replies();
+    }
+    return timed_out;
+}
+
+void OpenArm::restamp_pending_replies() {
+    for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+        device_collection->restamp_pending_replies();
+    }
+}
+
+bool OpenArm::has_pending_replies() const {
+    for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+        if (device_collection->has_pending_replies()) return true;
+    }
+    return false;
+}
+
+size_t OpenArm::drain_socket(bool track_pending) {
+    const auto start = std::chrono::steady_clock::now();
+    size_t replies = 0;
     // CAN FD
     if (enable_fd_) {
-        canfd_frame response_frame;
-        while (can_socket_->is_data_available(timeout_us) &&
-               can_socket_->read_canfd_frame(response_frame)) {
-            master_can_device_collection_->dispatch_frame_callback(response_frame);
+        size_t n_frames = can_socket_->read_canfd_frames(
+            rx_canfd_frames_.data(), rx_timestamps_.data(), rx_canfd_frames_.size());
+        for (size_t i = 0; i < n_frames; i++) {
+            if (master_can_device_collection_->dispatch_frame_callback(rx_canfd_frames_[i],
+                                                                       rx_timestamps_[i])) {
+                if (track_pending) {
+                    clear_pending_reply(rx_canfd_frames_[i].can_id, rx_timestamps_[i]);
+                }
+                replies++;
+            }
         }
     }
     // CAN 2.0
     else {
-        can_frame response_frame;
-        while (can_socket_->is_data_available(timeout_us) &&
-               can_socket_->read_can_frame(response_frame)) {
-            master_can_device_collection_->dispatch_frame_callback(response_frame);
+        size_t n_frames = can_socket_->read_can_frames(rx_can_frames_.data(), rx_timestamps_.data(),
+                                                       rx_can_frames_.size());
+        for (size_t i = 0; i < n_frames; i++) {
+            if (master_can_device_collection_->dispatch_frame_callback(rx_can_frames_[i],
+                                                                       rx_timestamps_[i])) {
+                if (track_pending) {
+                    clear_pending_reply(rx_can_frames_[i].can_id, rx_timestamps_[i]);
+                }
+                replies++;
+            }
+        }
+    }
+    rx_drain_histogram_.record(std::chrono::steady_clock::now() - start);
+    return replies;
+}
+
+void OpenArm::clear_pending_reply(canid_t recv_can_id,
+                                  const canbus::CANFrameTimestamp& timestamp) {
+    for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+        if (device_collection->clear_pending_reply(recv_can_id, timestamp.software_ns)) return;
+    }
+}
+
+void OpenArm::start_receiver(const ReceiverConfig& config) {
+    if (is_pipeline_running()) {
+        throw std::logic_error("start_receiver cannot be used while the pipeline is running");
+    }
+    if (receiver_running_.exchange(true)) return;
+    receiver_thread_ = std::thread(&OpenArm::receiver_loop, this, config);
+}
+
+void OpenArm::stop_receiver() {
+    if (!receiver_running_.exchange(false)) return;
+    if (receiver_thread_.joinable()) receiver_thread_.join();
+}
+
+void OpenArm::receiver_loop(ReceiverConfig config) {
+    configure_current_thread(config.thread);
+    while (receiver_running_.load(std::memory_order_relaxed)) {
+        if (can_socket_->is_data_available(config.poll_timeout_us)) {
+            // Pending-reply bookkeeping belongs to the control thread, leave it alone
+            drain_socket(false);
+        }
+    }
+}
+
+void OpenArm::start_pipeline(const PipelineConfig& config) {
+    check_receiver_stopped("start_pipeline");
+    if (pipeline_running_.exchange(true)) return;
+    try {
+        can_socket_->enable_async_io(config.tx_ring_size, config.rx_ring_size);
+    } catch (...) {
+        pipeline_running_ = false;
+        throw;
+    }
+    pipeline_tx_thread_ = std::thread(&OpenArm::pipeline_tx_loop, this, config);
+    pipeline_rx_thread_ = std::thread(&OpenArm::pipeline_rx_loop, this, config);
+}
+
+void OpenArm::stop_pipeline() {
+    if (!pipeline_running_.exchange(false)) return;
+    can_socket_->wake_tx();
+    if (pipeline_tx_thread_.joinable()) pipeline_tx_thread_.join();
+    if (pipeline_rx_thread_.joinable()) pipeline_rx_thread_.join();
+    // Sends whatever is still queued, replies still on the RX ring are dropped
+    can_socket_->disable_async_io();
+}
+
+size_t OpenArm::process_replies() {
+    size_t replies = 0;
+    while (can_socket_->has_queued_rx()) replies += drain_socket();
+    return replies;
+}
+
+void OpenArm::pipeline_tx_loop(PipelineConfig config) {
+    configure_current_thread(config.tx_thread);
+    while (pipeline_running_.load(std::memory_order_relaxed)) {
+        can_socket_->pump_tx(config.poll_timeout_us);
+    }
+}
+
+void OpenArm::pipeline_rx_loop(PipelineConfig config) {
+    configure_current_thread(config.rx_thread);
+    while (pipeline_running_.load(std::memory_order_relaxed)) {
+        can_socket_->pump_rx(config.poll_timeout_us);
+    }
+}
+
+void OpenArm::check_receiver_stopped(const char* caller) const {
+    if (is_receiver_running()) {
+        throw std::logic_error(std::string(caller) +
+                               " cannot be used while the background receiver is running");
+    }
+}
+
+void OpenArm::start_recording(const std::string& path,
+                              const canbus::FrameRecorderConfig& config) {
+    stop_recording();
+    // A new config needs a new recorder, which can only replace the old one while no I/O
+    // thread may be recording into it
+    if (!recorder_ || (!is_receiver_running() && !is_pipeline_running())) {
+        can_socket_->set_frame_recorder(nullptr);
+        recorder_ = std::make_unique<canbus::FrameRecorder>(config);
+        can_socket_->set_frame_recorder(recorder_.get());
+    }
+    recorder_->start(path, can_interface_);
+}
+
+void OpenArm::stop_recording() {
+    if (recorder_) recorder_->stop();
+}
+
+OpenArmStats OpenArm::get_stats() const {
+    OpenArmStats stats;
+    stats.socket = can_socket_->get_stats();
+    stats.recv_all = recv_all_histogram_.snapshot();
+    stats.rx_drain = rx_drain_histogram_.snapshot();
+    for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+        for (damiao_motor::DMCANDevice* dm_device : device_collection->get_dm_devices()) {
+            stats.motors.push_back({dm_device->get_recv_can_id(),
+                                    dm_device->get_round_trip_histogram().snapshot()});
+        }
+    }
+    stats.unmatched_frames = master_can_device_collection_->get_unmatched_frame_count();
+    if (recorder_) stats.recording = recorder_->get_stats();
+    return stats;
+}
+
+void OpenArm::reset_stats() {
+    can_socket_->reset_stats();
+    recv_all_histogram_.reset();
+    rx_drain_histogram_.reset();
+    for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
+        for (damiao_motor::DMCANDevice* dm_device : device_collection->get_dm_devices()) {
+            dm_device->reset_round_trip_histogram();
         }
     }
-    // }
+    master_can_device_collection_->reset_unmatched_frame_count();
 }
 
 void OpenArm::query_param_all(int RID) {
+    canbus::CANSocketBatch batch(*can_socket_);
     for (damiao_motor::DMDeviceCollection* device_collection : sub_dm_device_collections_) {
         device_collection->query_param_all(RID);
     }
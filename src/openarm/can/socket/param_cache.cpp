@@ -0,0 +1,155 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <openarm/can/socket/param_cache.hpp>
+#include <sstream>
+
+namespace openarm::can::socket {
+
+using damiao_motor::RID;
+
+const std::vector<int>& ParamCache::default_rids() {
+    static const std::vector<int> rids = {
+        static_cast<int>(RID::PMAX),      static_cast<int>(RID::VMAX),
+        static_cast<int>(RID::TMAX),      static_cast<int>(RID::CTRL_MODE),
+        static_cast<int>(RID::MST_ID),    static_cast<int>(RID::ESC_ID),
+        static_cast<int>(RID::can_br),    static_cast<int>(RID::TIMEOUT),
+        static_cast<int>(RID::hw_ver),    static_cast<int>(RID::sub_ver)};
+    return rids;
+}
+
+std::string ParamCache::default_path() {
+    if (const char* path = std::getenv("OPENARM_CAN_PARAM_CACHE")) return path;
+    std::filesystem::path cache_home;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        cache_home = xdg;
+    } else if (const char* home = std::getenv("HOME"); home && *home) {
+        cache_home = std::filesystem::path(home) / ".cache";
+    } else {
+        cache_home = std::filesystem::temp_directory_path();
+    }
+    return (cache_home / "openarm-can" / "params.cache").string();
+}
+
+ParamCache::ParamCache(std::string path) : path_(std::move(path)) {}
+
+bool ParamCache::load() {
+    std::ifstream file(path_);
+    if (!file) return false;
+
+    entries_.clear();
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        CachedMotorParams entry;
+        if (!(fields >> entry.interface >> std::hex >> entry.recv_can_id >> std::dec >>
+              entry.sn >> entry.sw_ver)) {
+            std::cerr << "WARNING: " << path_ << ":" << line_number
+                      << ": malformed parameter cache entry" << std::endl;
+            continue;
+        }
+        std::string param;
+        bool valid = true;
+        while (fields >> param) {
+            size_t separator = param.find('=');
+            try {
+                if (separator == std::string::npos) throw std::invalid_argument(param);
+                int rid = std::stoi(param.substr(0, separator));
+                if (rid < 0 || rid >= static_cast<int>(RID::COUNT)) {
+                    throw std::out_of_range(param);
+                }
+                entry.params[rid] = std::stod(param.substr(separator + 1));
+            } catch (const std::exception&) {
+                valid = false;
+                break;
+            }
+        }
+        if (!valid) {
+            std::cerr << "WARNING: " << path_ << ":" << line_number
+                      << ": malformed parameter cache entry" << std::endl;
+            continue;
+        }
+        entries_[{entry.interface, entry.recv_can_id}] = std::move(entry);
+    }
+    return true;
+}
+
+bool ParamCache::save() const {
+    std::filesystem::path path(path_);
+    std::error_code error;
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), error);
+
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file) return false;
+        file << "# openarm-can parameter cache: <interface> <recv_can_id> <SN> <sw_ver> "
+                "<RID>=<value> ...\n";
+        file << std::setprecision(std::numeric_limits<double>::max_digits10);
+        for (const auto& [key, entry] : entries_) {
+            file << entry.interface << " " << std::hex << entry.recv_can_id << std::dec << " "
+                 << entry.sn << " " << entry.sw_ver;
+            for (const auto& [rid, value] : entry.params) file << " " << rid << "=" << value;
+            file << "\n";
+        }
+        if (!file.flush()) return false;
+    }
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+const CachedMotorParams* ParamCache::find(const std::string& interface,
+                                          uint32_t recv_can_id) const {
+    auto it = entries_.find({interface, recv_can_id});
+    return it == entries_.end() ? nullptr : &it->second;
+}
+
+bool ParamCache::is_valid_for(const CachedMotorParams& entry, const damiao_motor::Motor& motor,
+                              const std::vector<int>& rids) {
+    double sn = motor.get_param(static_cast<int>(RID::SN));
+    double sw_ver = motor.get_param(static_cast<int>(RID::sw_ver));
+    // -1: the motor did not answer, nothing to compare against
+    if (sn < 0 || sw_ver < 0 || sn != entry.sn || sw_ver != entry.sw_ver) return false;
+    for (int rid : rids) {
+        if (entry.params.count(rid) == 0) return false;
+    }
+    return true;
+}
+
+void ParamCache::store(const std::string& interface, const damiao_motor::Motor& motor,
+                       const std::vector<int>& rids) {
+    CachedMotorParams entry;
+    entry.interface = interface;
+    entry.recv_can_id = motor.get_recv_can_id();
+    entry.sn = motor.get_param(static_cast<int>(RID::SN));
+    entry.sw_ver = motor.get_param(static_cast<int>(RID::sw_ver));
+    for (int rid : rids) {
+        double value = motor.get_param(rid);
+        if (value != -1) entry.params[rid] = value;
+    }
+    entries_[{interface, entry.recv_can_id}] = std::move(entry);
+}
+
+}  // namespace openarm::can::socket
@@ -0,0 +1,64 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <iostream>
+#include <openarm/can/socket/realtime.hpp>
+
+namespace openarm::can::socket {
+
+bool configure_current_thread(const ThreadConfig& config) {
+    bool ok = true;
+
+    if (config.cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(config.cpu, &cpu_set);
+        int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+        if (result != 0) {
+            std::cerr << "WARNING: failed to pin thread to CPU " << config.cpu << ": "
+                      << strerror(result) << std::endl;
+            ok = false;
+        }
+    }
+
+    if (config.priority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = config.priority;
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result != 0) {
+            std::cerr << "WARNING: failed to set SCHED_FIFO priority " << config.priority << ": "
+                      << strerror(result) << std::endl;
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+bool lock_process_memory() {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        std::cerr << "WARNING: failed to lock process memory: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace openarm::can::socket
@@ -0,0 +1,249 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <openarm/can/socket/trajectory_streamer.hpp>
+#include <stdexcept>
+
+namespace openarm::can::socket {
+
+TrajectoryStreamer::TrajectoryStreamer(OpenArm& openarm, const TrajectoryStreamerConfig& config)
+    : openarm_(openarm),
+      config_(config),
+      joint_count_(openarm.get_arm().get_dm_devices().size()),
+      loop_(openarm, config.loop),
+      queue_(config.queue_size) {
+    if (joint_count_ > TRAJECTORY_MAX_JOINTS) {
+        throw std::invalid_argument("TrajectoryStreamer supports at most " +
+                                    std::to_string(TRAJECTORY_MAX_JOINTS) + " joints, got " +
+                                    std::to_string(joint_count_));
+    }
+    if (config_.control_mode == damiao_motor::ControlMode::MIT) {
+        if (config_.kp.size() != joint_count_ || config_.kd.size() != joint_count_) {
+            throw std::invalid_argument("TrajectoryStreamer needs kp and kd for each of the " +
+                                        std::to_string(joint_count_) + " arm joints");
+        }
+    } else if (config_.control_mode != damiao_motor::ControlMode::POS_VEL) {
+        throw std::invalid_argument("TrajectoryStreamer only supports MIT and POS_VEL control");
+    }
+    posvel_params_.resize(joint_count_);
+}
+
+TrajectoryStreamer::~TrajectoryStreamer() { stop(); }
+
+void TrajectoryStreamer::start() {
+    if (running_.load()) return;
+    // A thread that stopped on an error is still joinable
+    if (thread_.joinable()) thread_.join();
+    {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        error_.clear();
+    }
+    has_target_ = false;
+    holding_ = false;
+    running_.store(true);
+    thread_ = std::thread(&TrajectoryStreamer::thread_main, this);
+}
+
+void TrajectoryStreamer::stop() {
+    // The tick callback checks running_ too, in case stop() comes before loop_.run()
+    running_.store(false);
+    loop_.stop();
+    if (thread_.joinable()) thread_.join();
+}
+
+std::string TrajectoryStreamer::get_error() const {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    return error_;
+}
+
+size_t TrajectoryStreamer::push(const TrajectoryPoint* points, size_t count) {
+    return queue_.push(points, count);
+}
+
+void TrajectoryStreamer::read_state(damiao_motor::JointState& out) const {
+    openarm_.get_arm().read_state(out);
+}
+
+void TrajectoryStreamer::thread_main() {
+    try {
+        loop_.run([this](const ControlTick& control_tick) { return tick(control_tick); });
+    } catch (const std::exception& e) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            error_ = e.what();
+        }
+        std::cerr << "WARNING: Trajectory streaming stopped: " << e.what() << std::endl;
+    }
+    running_.store(false);
+}
+
+bool TrajectoryStreamer::tick(const ControlTick& control_tick) {
+    const int64_t period_ns = config_.loop.period.count();
+    // Commands queued now go out at the start of the next tick
+    const int64_t time_ns = control_tick.scheduled_ns + period_ns;
+
+    const size_t flush_position = flush_position_.load(std::memory_order_acquire);
+    if (queue_.popped() < flush_position) {
+        TrajectoryPoint dropped;
+        while (queue_.popped() < flush_position && queue_.pop(dropped)) {
+        }
+        if (has_target_) {
+            target_.time_ns = time_ns;
+            std::copy(q_.begin(), q_.end(), target_.positions.begin());
+            target_.velocities.fill(0.0);
+            target_.accelerations.fill(0.0);
+        }
+    }
+
+    const damiao_motor::JointState& state = loop_.get_arm_state();
+    if (!has_target_ &&
+        std::any_of(state.timestamps_ns.begin(), state.timestamps_ns.end(),
+                    [](int64_t timestamp_ns) { return timestamp_ns == 0; })) {
+        // The first segment starts at the measured positions, wait until every joint has
+        // reported one
+        openarm_.get_arm().refresh_all();
+        return running_.load(std::memory_order_relaxed);
+    }
+
+    TrajectoryPoint next;
+    while ((!has_target_ || time_ns >= target_.time_ns) && queue_.pop(next)) {
+        if (!has_target_) {
+            TrajectoryPoint measured;
+            measured.time_ns = time_ns - period_ns;
+            std::copy(state.positions.begin(), state.positions.end(), measured.positions.begin());
+            fit_segment(measured, next);
+        } else if (next.time_ns <= target_.time_ns) {
+            rejected_points_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        } else if (holding_) {
+            // The arm stood still at target_ since its time, start from there and now
+            TrajectoryPoint held;
+            held.time_ns = time_ns - period_ns;
+            held.positions = target_.positions;
+            fit_segment(held, next);
+        } else {
+            fit_segment(target_, next);
+        }
+        target_ = next;
+        has_target_ = true;
+        holding_ = false;
+        points_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!has_target_) {
+        // Nothing to stream yet, keep the state fresh
+        openarm_.get_arm().refresh_all();
+    } else {
+        if (time_ns >= target_.time_ns) {
+            q_ = target_.positions;
+            dq_.fill(0.0);
+            holding_ = true;
+            hold_ticks_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            evaluate(time_ns);
+        }
+        send_setpoint();
+    }
+    return running_.load(std::memory_order_relaxed);
+}
+
+void TrajectoryStreamer::fit_segment(const TrajectoryPoint& from, const TrajectoryPoint& to) {
+    auto& c = segment_.coefficients;
+    segment_.start_ns = from.time_ns;
+    for (auto& coefficient : c) coefficient.fill(0.0);
+    const double t = static_cast<double>(to.time_ns - from.time_ns) * 1e-9;
+    if (t <= 0.0) {
+        // Already due, jump to it
+        c[0] = to.positions;
+        return;
+    }
+
+    const double t2 = t * t;
+    const double t3 = t2 * t;
+    const double* q0 = from.positions.data();
+    const double* q1 = to.positions.data();
+    const double* v0 = from.velocities.data();
+    const double* v1 = to.velocities.data();
+    if (config_.interpolation == InterpolationMode::CUBIC) {
+        for (size_t j = 0; j < TRAJECTORY_MAX_JOINTS; j++) {
+            const double h = q1[j] - q0[j];
+            c[0][j] = q0[j];
+            c[1][j] = v0[j];
+            c[2][j] = (3.0 * h - (2.0 * v0[j] + v1[j]) * t) / t2;
+            c[3][j] = (-2.0 * h + (v0[j] + v1[j]) * t) / t3;
+        }
+    } else {
+        const double* a0 = from.accelerations.data();
+        const double* a1 = to.accelerations.data();
+        const double t4 = t3 * t;
+        const double t5 = t4 * t;
+        for (size_t j = 0; j < TRAJECTORY_MAX_JOINTS; j++) {
+            const double h = q1[j] - q0[j];
+            c[0][j] = q0[j];
+            c[1][j] = v0[j];
+            c[2][j] = 0.5 * a0[j];
+            c[3][j] = (20.0 * h - (8.0 * v1[j] + 12.0 * v0[j]) * t - (3.0 * a0[j] - a1[j]) * t2) /
+                      (2.0 * t3);
+            c[4][j] = (-30.0 * h + (14.0 * v1[j] + 16.0 * v0[j]) * t +
+                       (3.0 * a0[j] - 2.0 * a1[j]) * t2) /
+                      (2.0 * t4);
+            c[5][j] = (12.0 * h - 6.0 * (v1[j] + v0[j]) * t + (a1[j] - a0[j]) * t2) / (2.0 * t5);
+        }
+    }
+}
+
+void TrajectoryStreamer::evaluate(int64_t time_ns) {
+    const auto& c = segment_.coefficients;
+    const double s = static_cast<double>(time_ns - segment_.start_ns) * 1e-9;
+    // Horner over all lanes, the cubic case just has zero high-order coefficients
+    for (size_t j = 0; j < TRAJECTORY_MAX_JOINTS; j++) {
+        q_[j] = c[0][j] +
+                s * (c[1][j] + s * (c[2][j] + s * (c[3][j] + s * (c[4][j] + s * c[5][j]))));
+        dq_[j] = c[1][j] + s * (2.0 * c[2][j] +
+                                s * (3.0 * c[3][j] + s * (4.0 * c[4][j] + s * 5.0 * c[5][j])));
+    }
+}
+
+void TrajectoryStreamer::send_setpoint() {
+    if (config_.control_mode == damiao_motor::ControlMode::MIT) {
+        openarm_.get_arm().mit_control_all(config_.kp.data(), config_.kd.data(), q_.data(),
+                                           dq_.data(), tau_.data(), joint_count_);
+        return;
+    }
+    for (size_t j = 0; j < joint_count_; j++) {
+        posvel_params_[j] = {q_[j], std::max(std::abs(dq_[j]), config_.posvel_min_velocity)};
+    }
+    openarm_.get_arm().posvel_control_all(posvel_params_);
+}
+
+TrajectoryStreamerStats TrajectoryStreamer::get_stats() const {
+    TrajectoryStreamerStats stats;
+    stats.points = points_.load(std::memory_order_relaxed);
+    stats.rejected_points = rejected_points_.load(std::memory_order_relaxed);
+    stats.hold_ticks = hold_ticks_.load(std::memory_order_relaxed);
+    stats.loop = loop_.get_stats();
+    return stats;
+}
+
+void TrajectoryStreamer::reset_stats() {
+    points_.store(0, std::memory_order_relaxed);
+    rejected_points_.store(0, std::memory_order_relaxed);
+    hold_ticks_.store(0, std::memory_order_relaxed);
+    loop_.reset_stats();
+}
+
+}  // namespace openarm::can::socket
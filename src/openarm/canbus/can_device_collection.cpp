@@ -25,9 +25,15 @@ CANDeviceCollection::~CANDeviceCollection() {}
 void CANDeviceCollection::add_device(const std::shared_ptr<CANDevice>& device) {
     if (!device) return;
 
-    // Add device to our collection
+    // Add device to our collection, keeping a device it replaces alive for the callback
     canid_t device_id = device->get_recv_can_id();
+    std::shared_ptr<CANDevice> replaced;
+    auto it = devices_.find(device_id);
+    if (it != devices_.end()) replaced = it->second;
     devices_[device_id] = device;
+    rebuild_dispatch_table();
+    if (kernel_filtering_) install_filters();
+    if (devices_changed_callback_) devices_changed_callback_(replaced.get());
 }
 
 void CANDeviceCollection::remove_device(const std::shared_ptr<CANDevice>& device) {
@@ -37,26 +43,130 @@ void CANDeviceCollection::remove_device(const std::shared_ptr<CANDevice>& device
     auto it = devices_.find(device_id);
     if (it != devices_.end()) {
         // Remove from our collection
+        std::shared_ptr<CANDevice> removed = it->second;
         devices_.erase(it);
+        rebuild_dispatch_table();
+        if (kernel_filtering_) install_filters();
+        if (devices_changed_callback_) devices_changed_callback_(removed.get());
     }
 }
 
-void CANDeviceCollection::dispatch_frame_callback(can_frame& frame) {
-    auto it = devices_.find(frame.can_id);
-    if (it != devices_.end()) {
-        it->second->callback(frame);
+namespace {
+// Frame type flags always have to match, the recv mask only applies to the ID bits
+canid_t effective_mask(const CANDevice& device) {
+    return device.get_recv_can_mask() | CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG;
+}
+}  // namespace
+
+void CANDeviceCollection::rebuild_dispatch_table() {
+    sff_dispatch_table_.assign(CAN_SFF_MASK + 1, nullptr);
+
+    // Masked matches first, then exact recv_can_id matches so they take precedence
+    for (bool exact : {false, true}) {
+        for (const auto& [id, device] : devices_) {
+            canid_t mask = effective_mask(*device);
+            if (exact) {
+                if (id <= CAN_SFF_MASK) sff_dispatch_table_[id] = device.get();
+                continue;
+            }
+            for (canid_t can_id = 0; can_id <= CAN_SFF_MASK; can_id++) {
+                if ((can_id & mask) == (id & mask)) {
+                    sff_dispatch_table_[can_id] = device.get();
+                }
+            }
+        }
+    }
+}
+
+std::vector<can_filter> CANDeviceCollection::get_filters() const {
+    std::vector<can_filter> filters;
+    filters.reserve(devices_.size());
+    for (const auto& [id, device] : devices_) {
+        can_filter filter;
+        filter.can_id = id;
+        filter.can_mask = effective_mask(*device);
+        filters.push_back(filter);
+    }
+    return filters;
+}
+
+void CANDeviceCollection::set_kernel_filtering(bool enable) {
+    kernel_filtering_ = enable;
+    if (kernel_filtering_) {
+        install_filters();
+    } else {
+        can_socket_.clear_filters();
+    }
+}
+
+void CANDeviceCollection::install_filters() {
+    // Until a device is registered there is nothing to filter for, keep receiving
+    // everything so raw socket users are not surprised
+    if (devices_.empty()) {
+        can_socket_.clear_filters();
+        return;
+    }
+    if (devices_.size() > CAN_RAW_FILTER_MAX) {
+        std::cerr << "WARNING: " << devices_.size() << " devices exceed CAN_RAW_FILTER_MAX ("
+                  << CAN_RAW_FILTER_MAX << "), receiving every frame instead" << std::endl;
+        can_socket_.clear_filters();
+        return;
+    }
+    if (!can_socket_.set_filters(get_filters())) {
+        std::cerr << "WARNING: failed to install CAN_RAW_FILTER on " << can_socket_.get_interface()
+                  << ", receiving every frame instead" << std::endl;
+        can_socket_.clear_filters();
+    }
+}
+
+CANDevice* CANDeviceCollection::find_device(canid_t can_id) const {
+    // Fast path: plain standard frame, one indexed load
+    if ((can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) == 0) {
+        return sff_dispatch_table_.empty() ? nullptr : sff_dispatch_table_[can_id];
+    }
+
+    // Extended, RTR and error frames are rare, fall back to the map and the masks
+    auto it = devices_.find(can_id);
+    if (it != devices_.end()) return it->second.get();
+    for (const auto& [id, device] : devices_) {
+        canid_t mask = effective_mask(*device);
+        if ((can_id & mask) == (id & mask)) return device.get();
+    }
+    return nullptr;
+}
+
+bool CANDeviceCollection::dispatch_frame_callback(can_frame& frame) {
+    return dispatch_frame_callback(frame, CANFrameTimestamp());
+}
+
+bool CANDeviceCollection::dispatch_frame_callback(can_frame& frame,
+                                                  const CANFrameTimestamp& timestamp) {
+    CANDevice* device = find_device(frame.can_id);
+    if (device) {
+        device->callback(frame, timestamp);
+        return true;
     }
     // Note: Silently ignore frames for unknown devices (this is normal in CAN
-    // networks)
+    // networks), only count them
+    unmatched_frames_.fetch_add(1, std::memory_order_relaxed);
+    return false;
 }
 
-void CANDeviceCollection::dispatch_frame_callback(canfd_frame& frame) {
-    auto it = devices_.find(frame.can_id);
-    if (it != devices_.end()) {
-        it->second->callback(frame);
+bool CANDeviceCollection::dispatch_frame_callback(canfd_frame& frame) {
+    return dispatch_frame_callback(frame, CANFrameTimestamp());
+}
+
+bool CANDeviceCollection::dispatch_frame_callback(canfd_frame& frame,
+                                                  const CANFrameTimestamp& timestamp) {
+    CANDevice* device = find_device(frame.can_id);
+    if (device) {
+        device->callback(frame, timestamp);
+        return true;
     }
     // Note: Silently ignore frames for unknown devices (this is normal in CAN
-    // networks)
+    // networks), only count them
+    unmatched_frames_.fetch_add(1, std::memory_order_relaxed);
+    return false;
 }
 
 }  // namespace openarm::canbus
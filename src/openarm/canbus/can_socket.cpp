@@ -14,126 +14,680 @@
 
 #include <errno.h>
 #include <fcntl.h>
-#include <net/if.h>
+#include <poll.h>
 #include <string.h>
-#include <sys/ioctl.h>
-#include <sys/select.h>
-#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <openarm/canbus/can_socket.hpp>
+#include <openarm/canbus/frame_log.hpp>
+#include <openarm/canbus/socketcan_transport.hpp>
+#include <optional>
+#include <stdexcept>
+#include <thread>
 
 namespace openarm::canbus {
 
 CANSocket::CANSocket(const std::string& interface, bool enable_fd)
-    : socket_fd_(-1), interface_(interface), fd_enabled_(enable_fd) {
-    if (!initialize_socket(interface)) {
-        throw CANSocketException("Failed to initialize socket for interface: " + interface);
-    }
+    : CANSocket(std::make_unique<SocketCANTransport>(interface, enable_fd)) {}
+
+CANSocket::CANSocket(std::unique_ptr<CANTransport> transport) : transport_(std::move(transport)) {
+    if (!transport_) throw std::invalid_argument("CANSocket needs a transport");
+    interface_ = transport_->get_interface();
+    fd_enabled_ = transport_->is_canfd_enabled();
 }
 
 CANSocket::~CANSocket() { cleanup(); }
 
-bool CANSocket::initialize_socket(const std::string& interface) {
-    // Create socket
-    socket_fd_ = socket(PF_CAN, SOCK_RAW, CAN_RAW);
-    if (socket_fd_ < 0) {
-        return false;
+void CANSocket::cleanup() {
+    for (int* fd : {&tx_event_fd_, &rx_event_fd_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
     }
+}
 
-    struct ifreq ifr;
-    struct sockaddr_can addr;
-
-    strncpy(ifr.ifr_name, interface.c_str(), IFNAMSIZ - 1);
-    ifr.ifr_name[IFNAMSIZ - 1] = '\0';
-
-    if (ioctl(socket_fd_, SIOCGIFINDEX, &ifr) < 0) {
-        cleanup();
-        return false;
+ssize_t CANSocket::read_raw_frame(void* buffer, size_t buffer_size) {
+    if (!is_initialized()) return -1;
+    // A CAN-FD transport only delivers canfd_frames, and only into a buffer that fits one
+    if (fd_enabled_ && buffer_size >= sizeof(canfd_frame)) {
+        return read_canfd_frame(*static_cast<canfd_frame*>(buffer)) ? sizeof(canfd_frame) : -1;
     }
+    if (!fd_enabled_ && buffer_size >= sizeof(can_frame)) {
+        return read_can_frame(*static_cast<can_frame*>(buffer)) ? sizeof(can_frame) : -1;
+    }
+    errno = EINVAL;
+    return -1;
+}
 
-    memset(&addr, 0, sizeof(addr));
-    addr.can_family = AF_CAN;
-    addr.can_ifindex = ifr.ifr_ifindex;
-
-    if (fd_enabled_) {
-        int enable_canfd = 1;
-        if (setsockopt(socket_fd_, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable_canfd,
-                       sizeof(enable_canfd)) < 0) {
-            cleanup();
-            return false;
-        }
+ssize_t CANSocket::write_raw_frame(const void* buffer, size_t frame_size) {
+    if (!is_initialized()) return -1;
+    if (frame_size == sizeof(canfd_frame)) {
+        return write_canfd_frame(*static_cast<const canfd_frame*>(buffer)) ? frame_size : -1;
+    }
+    if (frame_size == sizeof(can_frame)) {
+        return write_can_frame(*static_cast<const can_frame*>(buffer)) ? frame_size : -1;
     }
+    errno = EINVAL;
+    return -1;
+}
 
-    if (bind(socket_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
-        cleanup();
-        return false;
+bool CANSocket::write_can_frame(const can_frame& frame) {
+    if (is_batching()) {
+        queue_batched(frame);
+        return true;
     }
+    if (async_io_ || tx_scheduler_) return write_frames(&frame, 1) == 1;
+    bool sent = transport_->send(&frame, 1) == 1;
+    count_sent(sent ? 1 : 0, 1);
+    if (sent) record_tx(&frame, 1);
+    return sent;
+}
 
-    struct timeval timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 100;
-    if (setsockopt(socket_fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
-        cleanup();
-        return false;
+bool CANSocket::write_canfd_frame(const canfd_frame& frame) {
+    if (is_batching()) {
+        queue_batched(frame);
+        return true;
     }
+    if (async_io_ || tx_scheduler_) return write_frames(&frame, 1) == 1;
+    bool sent = transport_->send(&frame, 1) == 1;
+    count_sent(sent ? 1 : 0, 1);
+    if (sent) record_tx(&frame, 1);
+    return sent;
+}
 
-    return true;
+void CANSocket::count_sent(size_t sent, size_t count) {
+    frames_sent_.fetch_add(sent, std::memory_order_relaxed);
+    if (sent < count) send_errors_.fetch_add(count - sent, std::memory_order_relaxed);
 }
 
-void CANSocket::cleanup() {
-    if (socket_fd_ >= 0) {
-        close(socket_fd_);
-        socket_fd_ = -1;
+namespace {
+// Number of messages handed to a single sendmmsg() call. Kept small so the
+// headers live on the stack.
+constexpr size_t kMaxFramesPerSyscall = 64;
+
+void signal_event_fd(int fd) {
+    uint64_t value = 1;
+    // Only fails when the counter would overflow, in which case it is signalled anyway
+    [[maybe_unused]] ssize_t result = write(fd, &value, sizeof(value));
+}
+
+void drain_event_fd(int fd) {
+    uint64_t value;
+    [[maybe_unused]] ssize_t result = read(fd, &value, sizeof(value));
+}
+
+int64_t steady_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+}  // namespace
+
+size_t CANSocket::write_can_frames(const can_frame* frames, size_t count) {
+    return write_frames(frames, count);
+}
+
+size_t CANSocket::write_canfd_frames(const canfd_frame* frames, size_t count) {
+    return write_frames(frames, count);
+}
+
+template <typename Frame>
+size_t CANSocket::write_frames(const Frame* frames, size_t count) {
+    if (!is_initialized() || count == 0) return 0;
+    if (!async_io_ && !tx_scheduler_) {
+        size_t sent = transport_->send(frames, count);
+        count_sent(sent, count);
+        record_tx(frames, sent);
+        return sent;
+    }
+
+    // Queue on the TX ring or in the scheduler, in write order until one is full
+    TxFrame entries[kMaxFramesPerSyscall];
+    size_t accepted = 0;
+    while (accepted < count) {
+        size_t chunk = std::min(count - accepted, kMaxFramesPerSyscall);
+        for (size_t i = 0; i < chunk; i++) {
+            memcpy(&entries[i].frame, &frames[accepted + i], sizeof(Frame));
+            entries[i].size = sizeof(Frame);
+        }
+        size_t queued =
+            async_io_ ? tx_ring_->push(entries, chunk) : schedule_frames(entries, chunk);
+        accepted += queued;
+        if (queued < chunk) break;
+    }
+    if (async_io_) {
+        if (accepted > 0) signal_event_fd(tx_event_fd_);
+        if (accepted < count) {
+            ring_overflows_.fetch_add(count - accepted, std::memory_order_relaxed);
+        }
+    } else {
+        service_tx_queue();
     }
+    if (accepted < count) send_errors_.fetch_add(count - accepted, std::memory_order_relaxed);
+    return accepted;
 }
 
-ssize_t CANSocket::read_raw_frame(void* buffer, size_t buffer_size) {
-    if (!is_initialized()) return -1;
-    return read(socket_fd_, buffer, buffer_size);
+void CANSocket::begin_batch() {
+    if (batch_depth_++ == 0) batch_start_ = std::chrono::steady_clock::now();
 }
 
-ssize_t CANSocket::write_raw_frame(const void* buffer, size_t frame_size) {
-    if (!is_initialized()) return -1;
-    return write(socket_fd_, buffer, frame_size);
+bool CANSocket::end_batch() {
+    if (batch_depth_ == 0 || --batch_depth_ > 0) return true;
+
+    // Send in write order, one write per run of equally sized frames. A failed frame ends
+    // the batch so the frames behind it can't overtake it.
+    const size_t count = batched_frames_.size();
+    size_t sent = 0;
+    while (sent < count) {
+        const size_t size = batched_frames_[sent].size;
+        size_t run = 1;
+        while (sent + run < count && batched_frames_[sent + run].size == size) run++;
+        size_t written = size == sizeof(canfd_frame)
+                             ? write_batched<canfd_frame>(&batched_frames_[sent], run)
+                             : write_batched<can_frame>(&batched_frames_[sent], run);
+        if (written < run) {
+            send_errors_.fetch_add(count - sent - run, std::memory_order_relaxed);
+            sent += written;
+            break;
+        }
+        sent += written;
+    }
+    // clear() keeps the capacity so steady-state batches do not allocate
+    batched_frames_.clear();
+    tx_batch_histogram_.record(std::chrono::steady_clock::now() - batch_start_);
+    return sent == count;
 }
 
-bool CANSocket::write_can_frame(const can_frame& frame) {
-    return write(socket_fd_, &frame, sizeof(frame)) == sizeof(frame);
+template <typename Frame>
+void CANSocket::queue_batched(const Frame& frame) {
+    batched_frames_.emplace_back();
+    TxFrame& entry = batched_frames_.back();
+    memcpy(&entry.frame, &frame, sizeof(Frame));
+    entry.size = sizeof(Frame);
 }
 
-bool CANSocket::write_canfd_frame(const canfd_frame& frame) {
-    return write(socket_fd_, &frame, sizeof(frame)) == sizeof(frame);
+// Returns the number of frames written, failed and never attempted frames count as send
+// errors
+template <typename Frame>
+size_t CANSocket::write_batched(const TxFrame* entries, size_t count) {
+    Frame frames[kMaxFramesPerSyscall];
+    size_t written = 0;
+    while (written < count) {
+        size_t chunk = std::min(count - written, kMaxFramesPerSyscall);
+        for (size_t i = 0; i < chunk; i++) {
+            memcpy(&frames[i], &entries[written + i].frame, sizeof(Frame));
+        }
+        // write_frames() counts its own failures
+        size_t accepted = write_frames(frames, chunk);
+        if (accepted < chunk) {
+            send_errors_.fetch_add(count - written - chunk, std::memory_order_relaxed);
+            return written + accepted;
+        }
+        written += chunk;
+    }
+    return written;
 }
 
 bool CANSocket::read_can_frame(can_frame& frame) {
     if (!is_initialized()) return false;
-    ssize_t bytes_read = read(socket_fd_, &frame, sizeof(frame));
-    return bytes_read == sizeof(frame);
+    if (async_io_) return dequeue_rx(&frame, nullptr, 1) == 1;
+    if (!receive_one(frame)) return false;
+    frames_received_.fetch_add(1, std::memory_order_relaxed);
+    record_rx_bus_time(&frame, 1);
+    record_rx(&frame, nullptr, 1);
+    return true;
 }
 
 bool CANSocket::read_canfd_frame(canfd_frame& frame) {
     if (!is_initialized()) return false;
-    ssize_t bytes_read = read(socket_fd_, &frame, sizeof(frame));
-    return bytes_read == sizeof(frame);
+    if (async_io_) return dequeue_rx(&frame, nullptr, 1) == 1;
+    if (!receive_one(frame)) return false;
+    frames_received_.fetch_add(1, std::memory_order_relaxed);
+    record_rx_bus_time(&frame, 1);
+    record_rx(&frame, nullptr, 1);
+    return true;
+}
+
+template <typename Frame>
+bool CANSocket::receive_one(Frame& frame) {
+    // Wait as long as a blocking read on the socket used to (SO_RCVTIMEO of 100 us)
+    CANReceiveInfo info;
+    if (transport_->receive(&frame, nullptr, 1, info) == 1) return true;
+    auto readable = [this] { return poll_fd(get_socket_fd(), 0); };
+    return wait_for_rx(get_socket_fd(), 100, readable) != WaitResult::TIMEOUT &&
+           transport_->receive(&frame, nullptr, 1, info) == 1;
+}
+
+size_t CANSocket::read_can_frames(can_frame* frames, size_t max_count) {
+    return read_can_frames(frames, nullptr, max_count);
+}
+
+size_t CANSocket::read_canfd_frames(canfd_frame* frames, size_t max_count) {
+    return read_canfd_frames(frames, nullptr, max_count);
+}
+
+size_t CANSocket::read_can_frames(can_frame* frames, CANFrameTimestamp* timestamps,
+                                  size_t max_count) {
+    if (!is_initialized() || max_count == 0) return 0;
+    if (async_io_) return dequeue_rx(frames, timestamps, max_count);
+    CANReceiveInfo info;
+    size_t received = transport_->receive(frames, timestamps, max_count, info);
+    count_received(received, info.malformed_frames, info.rx_queue_overflow_total);
+    record_rx_wake(timestamps, received);
+    record_rx_bus_time(frames, received);
+    record_rx(frames, timestamps, received);
+    return received;
+}
+
+size_t CANSocket::read_canfd_frames(canfd_frame* frames, CANFrameTimestamp* timestamps,
+                                    size_t max_count) {
+    if (!is_initialized() || max_count == 0) return 0;
+    if (async_io_) return dequeue_rx(frames, timestamps, max_count);
+    CANReceiveInfo info;
+    size_t received = transport_->receive(frames, timestamps, max_count, info);
+    count_received(received, info.malformed_frames, info.rx_queue_overflow_total);
+    record_rx_wake(timestamps, received);
+    record_rx_bus_time(frames, received);
+    record_rx(frames, timestamps, received);
+    return received;
+}
+
+bool CANSocket::enable_timestamping(TimestampMode mode) {
+    if (!is_initialized() || !transport_->enable_timestamping(mode)) return false;
+    timestamp_mode_ = mode;
+    return true;
 }
 
 bool CANSocket::is_data_available(int timeout_us) {
     if (!is_initialized()) return false;
+    if (!async_io_) {
+        auto readable = [this] { return poll_fd(get_socket_fd(), 0); };
+        return wait_for_rx(get_socket_fd(), timeout_us, readable) != WaitResult::TIMEOUT;
+    }
 
-    fd_set read_fds;
-    struct timeval timeout;
+    if (!rx_ring_->empty()) return true;
+    // Spinning on the ring needs no syscall, a stale eventfd signal left behind only makes
+    // the next sleep return early
+    auto queued = [this] { return !rx_ring_->empty(); };
+    if (wait_for_rx(rx_event_fd_, timeout_us, queued) == WaitResult::SLEPT) {
+        drain_event_fd(rx_event_fd_);
+    }
+    return !rx_ring_->empty();
+}
 
-    FD_ZERO(&read_fds);
-    FD_SET(socket_fd_, &read_fds);
+bool CANSocket::set_receive_strategy(const ReceiveStrategyConfig& config) {
+    receive_strategy_ = config;
+    if (config.socket_busy_poll_us <= 0) return true;
+    return is_initialized() && transport_->set_busy_poll(config.socket_busy_poll_us);
+}
+
+template <typename Ready>
+CANSocket::WaitResult CANSocket::wait_for_rx(int fd, int timeout_us, Ready ready) {
+    if (receive_strategy_.strategy != ReceiveStrategy::BLOCKING) {
+        auto start = std::chrono::steady_clock::now();
+        auto spin = std::chrono::microseconds(std::max(timeout_us, 0));
+        if (receive_strategy_.strategy == ReceiveStrategy::SPIN_THEN_BLOCK) {
+            spin = std::min(spin, receive_strategy_.spin_duration);
+        }
+        do {
+            if (ready()) {
+                spin_wakeups_.fetch_add(1, std::memory_order_relaxed);
+                return WaitResult::SPUN;
+            }
+        } while (std::chrono::steady_clock::now() - start < spin);
+        if (receive_strategy_.strategy == ReceiveStrategy::BUSY_POLL) return WaitResult::TIMEOUT;
+        timeout_us -= spin.count();
+        if (timeout_us <= 0) return WaitResult::TIMEOUT;
+    }
+    if (!poll_fd(fd, timeout_us)) return WaitResult::TIMEOUT;
+    sleep_wakeups_.fetch_add(1, std::memory_order_relaxed);
+    return WaitResult::SLEPT;
+}
 
+void CANSocket::record_rx_wake(const CANFrameTimestamp* timestamps, size_t count) {
+    if (!timestamps || count == 0 || timestamps[0].software_ns == 0) return;
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    rx_wake_histogram_.record(now - std::chrono::nanoseconds(timestamps[0].software_ns));
+}
+
+bool CANSocket::poll_fd(int fd, int timeout_us) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    // poll() only has millisecond resolution, use ppoll() to keep the microsecond timeout
+    struct timespec timeout;
     timeout.tv_sec = timeout_us / 1000000;
-    timeout.tv_usec = (timeout_us % 1000000);
+    timeout.tv_nsec = (timeout_us % 1000000) * 1000;
+
+    int result = ppoll(&pfd, 1, &timeout, nullptr);
 
-    int result = select(socket_fd_ + 1, &read_fds, nullptr, nullptr, &timeout);
+    return (result > 0 && (pfd.revents & POLLIN));
+}
+
+void CANSocket::enable_async_io(size_t tx_ring_size, size_t rx_ring_size) {
+    if (!is_initialized()) throw CANSocketException("Socket is not initialized");
+    if (async_io_) throw std::logic_error("Async I/O is already enabled");
+
+    tx_ring_ = std::make_unique<SPSCRing<TxFrame>>(tx_ring_size);
+    rx_ring_ = std::make_unique<SPSCRing<RingFrame>>(rx_ring_size);
+    tx_event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    rx_event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (tx_event_fd_ < 0 || rx_event_fd_ < 0) {
+        std::string error = strerror(errno);
+        for (int* fd : {&tx_event_fd_, &rx_event_fd_}) {
+            if (*fd >= 0) close(*fd);
+            *fd = -1;
+        }
+        throw CANSocketException("Failed to create eventfd: " + error);
+    }
+    async_io_ = true;
+}
+
+void CANSocket::disable_async_io() {
+    if (!async_io_) return;
+    // Don't lose commands that were queued but not sent yet
+    while (pump_tx(0) > 0) {
+    }
+    async_io_ = false;
+    close(tx_event_fd_);
+    close(rx_event_fd_);
+    tx_event_fd_ = -1;
+    rx_event_fd_ = -1;
+    tx_ring_.reset();
+    rx_ring_.reset();
+}
+
+template <typename Frame>
+size_t CANSocket::dequeue_rx(Frame* frames, CANFrameTimestamp* timestamps, size_t max_count) {
+    RingFrame entries[kMaxFramesPerSyscall];
+    size_t received = 0;
+    size_t malformed = 0;
+    while (received < max_count) {
+        size_t chunk = std::min(max_count - received, kMaxFramesPerSyscall);
+        size_t popped = rx_ring_->pop(entries, chunk);
+        for (size_t i = 0; i < popped; i++) {
+            if (entries[i].size != sizeof(Frame)) {
+                malformed++;
+                continue;
+            }
+            memcpy(&frames[received], &entries[i].frame, sizeof(Frame));
+            if (timestamps) timestamps[received] = entries[i].timestamp;
+            received++;
+        }
+        if (popped < chunk) break;
+    }
+    if (malformed > 0) malformed_frames_.fetch_add(malformed, std::memory_order_relaxed);
+    return received;
+}
+
+size_t CANSocket::pump_tx(int timeout_us) {
+    if (!async_io_) return 0;
+
+    TxFrame entries[kMaxFramesPerSyscall];
+    size_t count = tx_ring_->pop(entries, kMaxFramesPerSyscall);
+    bool scheduled = tx_scheduler_ && !tx_scheduler_->empty();
+    if (count == 0 && !scheduled) {
+        if (timeout_us <= 0 || !poll_fd(tx_event_fd_, timeout_us)) return 0;
+        drain_event_fd(tx_event_fd_);
+        count = tx_ring_->pop(entries, kMaxFramesPerSyscall);
+        if (count == 0) return 0;
+    }
+
+    if (tx_scheduler_) {
+        schedule_frames(entries, count);
+        return service_tx_queue();
+    }
+    // One sendmmsg() for everything popped, classic and FD frames may be mixed
+    size_t sent = 0;
+    while (sent < count) {
+        int result = transport_->try_send(entries + sent, count - sent);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        sent += result;
+        if (result == 0) break;
+    }
+    count_sent(sent, count);
+    record_tx(entries, sent);
+    return sent;
+}
+
+size_t CANSocket::pump_rx(int timeout_us) {
+    if (!async_io_) return 0;
+    auto readable = [this] { return poll_fd(get_socket_fd(), 0); };
+    if (wait_for_rx(get_socket_fd(), timeout_us, readable) == WaitResult::TIMEOUT) return 0;
+
+    RingFrame entries[kMaxFramesPerSyscall];
+    CANFrameTimestamp timestamps[kMaxFramesPerSyscall];
+    CANReceiveInfo info;
+    size_t received;
+    if (fd_enabled_) {
+        canfd_frame frames[kMaxFramesPerSyscall];
+        received = transport_->receive(frames, timestamps, kMaxFramesPerSyscall, info);
+        record_rx_bus_time(frames, received);
+        record_rx(frames, timestamps, received);
+        for (size_t i = 0; i < received; i++) {
+            entries[i].frame = frames[i];
+            entries[i].size = sizeof(canfd_frame);
+            entries[i].timestamp = timestamps[i];
+        }
+    } else {
+        can_frame frames[kMaxFramesPerSyscall];
+        received = transport_->receive(frames, timestamps, kMaxFramesPerSyscall, info);
+        record_rx_bus_time(frames, received);
+        record_rx(frames, timestamps, received);
+        for (size_t i = 0; i < received; i++) {
+            memcpy(&entries[i].frame, &frames[i], sizeof(can_frame));
+            entries[i].size = sizeof(can_frame);
+            entries[i].timestamp = timestamps[i];
+        }
+    }
+    count_received(received, info.malformed_frames, info.rx_queue_overflow_total);
+    record_rx_wake(timestamps, received);
+
+    size_t queued = rx_ring_->push(entries, received);
+    if (queued < received) {
+        ring_overflows_.fetch_add(received - queued, std::memory_order_relaxed);
+    }
+    if (queued > 0) signal_event_fd(rx_event_fd_);
+    return queued;
+}
+
+void CANSocket::enable_tx_scheduler(const TxSchedulerConfig& config) {
+    if (async_io_) {
+        throw std::logic_error("enable_tx_scheduler cannot be used while async I/O is enabled");
+    }
+    if (tx_scheduler_) disable_tx_scheduler();
+    tx_scheduler_ = std::make_unique<TxScheduler>(config);
+}
+
+void CANSocket::disable_tx_scheduler() {
+    if (!tx_scheduler_) return;
+    if (async_io_) {
+        throw std::logic_error("disable_tx_scheduler cannot be used while async I/O is enabled");
+    }
+    service_tx_queue();
+    if (!tx_scheduler_->empty()) {
+        send_errors_.fetch_add(tx_scheduler_->size(), std::memory_order_relaxed);
+    }
+    tx_scheduler_.reset();
+}
+
+size_t CANSocket::flush_tx_queue() {
+    if (!tx_scheduler_ || async_io_) return 0;
+    return service_tx_queue();
+}
+
+size_t CANSocket::schedule_frames(const TxFrame* frames, size_t count) {
+    size_t queued = 0;
+    while (queued < count && tx_scheduler_->push(frames[queued])) queued++;
+    return queued;
+}
+
+size_t CANSocket::service_tx_queue() {
+    TxScheduler& scheduler = *tx_scheduler_;
+    const TxSchedulerConfig& config = scheduler.get_config();
+    const int64_t deadline_ns =
+        steady_clock_ns() +
+        std::chrono::duration_cast<std::chrono::nanoseconds>(config.max_wait).count();
+    auto backoff = config.initial_backoff;
+
+    TxFrame frames[kMaxFramesPerSyscall];
+    size_t total_sent = 0;
+    while (!scheduler.empty()) {
+        int64_t now_ns = steady_clock_ns();
+        int64_t wait_ns = scheduler.time_until_ready(now_ns);
+        if (wait_ns > 0) {
+            // The bus is still busy with what we handed over, pace instead of flooding it
+            if (now_ns + wait_ns > deadline_ns) break;
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait_ns));
+            continue;
+        }
+
+        size_t count = scheduler.pop_ready(frames, kMaxFramesPerSyscall, now_ns);
+        int result = transport_->try_send(frames, count);
+        int error = result < 0 ? errno : 0;
+        size_t sent = result > 0 ? static_cast<size_t>(result) : 0;
+        scheduler.on_sent(frames, sent, now_ns);
+        record_tx(frames, sent);
+        frames_sent_.fetch_add(sent, std::memory_order_relaxed);
+        total_sent += sent;
+        if (sent == count) {
+            backoff = config.initial_backoff;
+            continue;
+        }
+        if (result >= 0 || error == EINTR) {
+            // The next sendmmsg() reports why the rest failed
+            scheduler.requeue(frames + sent, count - sent);
+            continue;
+        }
+        if (error != ENOBUFS && error != EAGAIN) {
+            // Not transient (e.g. a CAN-FD frame on a classic socket), drop the offending frame
+            scheduler.requeue(frames + 1, count - 1);
+            scheduler.count_dropped(1);
+            send_errors_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // The kernel TX queue is full, keep the frames and let the controller drain it
+        scheduler.requeue(frames, count);
+        scheduler.count_enobufs();
+        if (steady_clock_ns() +
+                std::chrono::duration_cast<std::chrono::nanoseconds>(backoff).count() >
+            deadline_ns) {
+            break;
+        }
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min(backoff * 2, config.max_backoff);
+    }
+    if (!scheduler.empty()) scheduler.count_deferred();
+    return total_sent;
+}
+
+template <typename Frame>
+void CANSocket::record_rx_bus_time(const Frame* frames, size_t count) {
+    if (!tx_scheduler_) return;
+    const TxSchedulerConfig& config = tx_scheduler_->get_config();
+    for (size_t i = 0; i < count; i++) {
+        if constexpr (sizeof(Frame) == CANFD_MTU) {
+            tx_scheduler_->record_bus_time(
+                frame_duration_ns(frames[i], config.bitrate, config.data_bitrate));
+        } else {
+            tx_scheduler_->record_bus_time(frame_duration_ns(frames[i], config.bitrate));
+        }
+    }
+}
+
+template <typename Frame>
+void CANSocket::record_tx(const Frame* frames, size_t count) {
+    if (count == 0) return;
+    if (FrameRecorder* recorder = frame_recorder_.load(std::memory_order_acquire)) {
+        recorder->record_tx(frames, count);
+    }
+}
+
+template <typename Frame>
+void CANSocket::record_rx(const Frame* frames, const CANFrameTimestamp* timestamps,
+                          size_t count) {
+    if (count == 0) return;
+    if (FrameRecorder* recorder = frame_recorder_.load(std::memory_order_acquire)) {
+        recorder->record_rx(frames, timestamps, count);
+    }
+}
+
+void CANSocket::wake_tx() {
+    if (async_io_) signal_event_fd(tx_event_fd_);
+}
+
+void CANSocket::count_received(size_t received, size_t malformed_frames,
+                               std::optional<uint32_t> rx_queue_overflow_total) {
+    frames_received_.fetch_add(received, std::memory_order_relaxed);
+    if (malformed_frames > 0) {
+        malformed_frames_.fetch_add(malformed_frames, std::memory_order_relaxed);
+    }
+    if (rx_queue_overflow_total) {
+        rx_queue_overflow_total_.store(*rx_queue_overflow_total, std::memory_order_relaxed);
+    }
+}
+
+bool CANSocket::set_filters(const std::vector<can_filter>& filters) {
+    return is_initialized() && transport_->set_filters(filters);
+}
+
+bool CANSocket::clear_filters() {
+    // Same as a freshly bound socket: one filter matching everything
+    return set_filters({can_filter{0, 0}});
+}
+
+bool CANSocket::set_loopback(bool enable) {
+    return is_initialized() && transport_->set_loopback(enable);
+}
+
+bool CANSocket::set_recv_own_msgs(bool enable) {
+    return is_initialized() && transport_->set_recv_own_msgs(enable);
+}
+
+CANSocketStats CANSocket::get_stats() const {
+    CANSocketStats stats;
+    stats.frames_sent = frames_sent_.load(std::memory_order_relaxed);
+    stats.frames_received = frames_received_.load(std::memory_order_relaxed);
+    stats.send_errors = send_errors_.load(std::memory_order_relaxed);
+    stats.malformed_frames = malformed_frames_.load(std::memory_order_relaxed);
+    // uint32_t arithmetic handles the kernel counter wrapping around
+    stats.rx_queue_overflows = static_cast<uint32_t>(
+        rx_queue_overflow_total_.load(std::memory_order_relaxed) -
+        rx_queue_overflow_base_.load(std::memory_order_relaxed));
+    stats.ring_overflows = ring_overflows_.load(std::memory_order_relaxed);
+    stats.spin_wakeups = spin_wakeups_.load(std::memory_order_relaxed);
+    stats.sleep_wakeups = sleep_wakeups_.load(std::memory_order_relaxed);
+    stats.rx_wake = rx_wake_histogram_.snapshot();
+    stats.tx_batch = tx_batch_histogram_.snapshot();
+    if (tx_scheduler_) stats.tx_scheduler = tx_scheduler_->get_stats();
+    return stats;
+}
 
-    return (result > 0 && FD_ISSET(socket_fd_, &read_fds));
+void CANSocket::reset_stats() {
+    frames_sent_.store(0, std::memory_order_relaxed);
+    frames_received_.store(0, std::memory_order_relaxed);
+    send_errors_.store(0, std::memory_order_relaxed);
+    malformed_frames_.store(0, std::memory_order_relaxed);
+    rx_queue_overflow_base_.store(rx_queue_overflow_total_.load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+    ring_overflows_.store(0, std::memory_order_relaxed);
+    spin_wakeups_.store(0, std::memory_order_relaxed);
+    sleep_wakeups_.store(0, std::memory_order_relaxed);
+    rx_wake_histogram_.reset();
+    tx_batch_histogram_.reset();
+    if (tx_scheduler_) tx_scheduler_->reset_stats();
 }
 
 }  // namespace openarm::canbus
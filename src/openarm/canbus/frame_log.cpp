@@ -0,0 +1,343 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <openarm/canbus/can_device_collection.hpp>
+#include <openarm/canbus/frame_log.hpp>
+#include <stdexcept>
+
+namespace openarm::canbus {
+
+namespace {
+// Records converted per push(), kept small so they live on the stack
+constexpr size_t kRecordChunk = 64;
+
+int64_t steady_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void fill_record(FrameLogRecord& record, const can_frame& frame) {
+    record.can_id = frame.can_id;
+    record.len = std::min<uint8_t>(frame.can_dlc, CAN_MAX_DLEN);
+    record.fd_flags = 0;
+    record.is_fd = 0;
+    std::memcpy(record.data, frame.data, record.len);
+}
+
+void fill_record(FrameLogRecord& record, const canfd_frame& frame) {
+    record.can_id = frame.can_id;
+    record.len = std::min<uint8_t>(frame.len, CANFD_MAX_DLEN);
+    record.fd_flags = frame.flags;
+    record.is_fd = 1;
+    std::memcpy(record.data, frame.data, record.len);
+}
+
+void fill_record(FrameLogRecord& record, const TxFrame& frame) {
+    if (frame.size == CANFD_MTU) {
+        fill_record(record, frame.frame);
+    } else {
+        fill_record(record, reinterpret_cast<const can_frame&>(frame.frame));
+    }
+}
+
+std::string errno_message() { return std::strerror(errno); }
+}  // namespace
+
+can_frame to_can_frame(const FrameLogRecord& record) {
+    can_frame frame;
+    std::memset(&frame, 0, sizeof(frame));
+    frame.can_id = record.can_id;
+    frame.can_dlc = std::min<uint8_t>(record.len, CAN_MAX_DLEN);
+    std::memcpy(frame.data, record.data, frame.can_dlc);
+    return frame;
+}
+
+canfd_frame to_canfd_frame(const FrameLogRecord& record) {
+    canfd_frame frame;
+    std::memset(&frame, 0, sizeof(frame));
+    frame.can_id = record.can_id;
+    frame.len = std::min<uint8_t>(record.len, CANFD_MAX_DLEN);
+    frame.flags = record.fd_flags;
+    std::memcpy(frame.data, record.data, frame.len);
+    return frame;
+}
+
+FrameRecorder::FrameRecorder(const FrameRecorderConfig& config)
+    : config_(config), tx_ring_(config.ring_size), rx_ring_(config.ring_size) {
+    if (config_.file_chunk_records == 0) {
+        throw std::invalid_argument("FrameRecorderConfig::file_chunk_records must be positive");
+    }
+}
+
+FrameRecorder::~FrameRecorder() { stop(); }
+
+void FrameRecorder::start(const std::string& path, const std::string& interface) {
+    if (is_recording() || writer_thread_.joinable()) {
+        throw std::logic_error("FrameRecorder is already recording");
+    }
+
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to create frame log " + path + ": " + errno_message());
+    }
+    map_records_ = config_.file_chunk_records;
+    size_t map_size = sizeof(FrameLogHeader) + map_records_ * sizeof(FrameLogRecord);
+    if (ftruncate(fd_, map_size) < 0 ||
+        (map_ = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0)) ==
+            MAP_FAILED) {
+        std::string message = errno_message();
+        map_ = nullptr;
+        close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Failed to map frame log " + path + ": " + message);
+    }
+
+    FrameLogHeader* log_header = header();
+    std::memcpy(log_header->magic, FRAME_LOG_MAGIC, sizeof(FRAME_LOG_MAGIC));
+    log_header->version = FRAME_LOG_VERSION;
+    log_header->record_size = sizeof(FrameLogRecord);
+    log_header->record_count = 0;
+    log_header->start_time_ns = steady_clock_ns();
+    std::memset(log_header->interface, 0, sizeof(log_header->interface));
+    std::strncpy(log_header->interface, interface.c_str(), sizeof(log_header->interface) - 1);
+
+    // Discard records that raced with the previous stop()
+    FrameLogRecord stale[kRecordChunk];
+    while (tx_ring_.pop(stale, kRecordChunk) > 0) {
+    }
+    while (rx_ring_.pop(stale, kRecordChunk) > 0) {
+    }
+
+    recording_.store(true, std::memory_order_release);
+    writer_thread_ = std::thread(&FrameRecorder::writer_loop, this);
+}
+
+void FrameRecorder::stop() {
+    recording_.store(false, std::memory_order_release);
+    if (writer_thread_.joinable()) writer_thread_.join();
+    if (!map_) return;
+
+    size_t count = header()->record_count;
+    munmap(map_, sizeof(FrameLogHeader) + map_records_ * sizeof(FrameLogRecord));
+    map_ = nullptr;
+    // Drop the unused tail of the last chunk
+    [[maybe_unused]] int result =
+        ftruncate(fd_, sizeof(FrameLogHeader) + count * sizeof(FrameLogRecord));
+    close(fd_);
+    fd_ = -1;
+}
+
+void FrameRecorder::record_tx(const can_frame* frames, size_t count) {
+    record(FrameDirection::TX, frames, nullptr, count);
+}
+
+void FrameRecorder::record_tx(const canfd_frame* frames, size_t count) {
+    record(FrameDirection::TX, frames, nullptr, count);
+}
+
+void FrameRecorder::record_tx(const TxFrame* frames, size_t count) {
+    record(FrameDirection::TX, frames, nullptr, count);
+}
+
+void FrameRecorder::record_rx(const can_frame* frames, const CANFrameTimestamp* timestamps,
+                              size_t count) {
+    record(FrameDirection::RX, frames, timestamps, count);
+}
+
+void FrameRecorder::record_rx(const canfd_frame* frames, const CANFrameTimestamp* timestamps,
+                              size_t count) {
+    record(FrameDirection::RX, frames, timestamps, count);
+}
+
+template <typename Frame>
+void FrameRecorder::record(FrameDirection direction, const Frame* frames,
+                           const CANFrameTimestamp* timestamps, size_t count) {
+    if (count == 0 || !is_recording()) return;
+
+    SPSCRing<FrameLogRecord>& ring = direction == FrameDirection::TX ? tx_ring_ : rx_ring_;
+    int64_t now_ns = steady_clock_ns();
+    FrameLogRecord records[kRecordChunk];
+    for (size_t base = 0; base < count; base += kRecordChunk) {
+        size_t chunk = std::min(count - base, kRecordChunk);
+        for (size_t i = 0; i < chunk; i++) {
+            FrameLogRecord& record = records[i];
+            fill_record(record, frames[base + i]);
+            record.direction = direction;
+            const CANFrameTimestamp* timestamp = timestamps ? &timestamps[base + i] : nullptr;
+            record.timestamp_ns =
+                timestamp && timestamp->software_ns != 0 ? timestamp->software_ns : now_ns;
+            record.hw_timestamp_ns = timestamp ? timestamp->hardware_ns : 0;
+        }
+        push(ring, records, chunk);
+    }
+}
+
+void FrameRecorder::push(SPSCRing<FrameLogRecord>& ring, const FrameLogRecord* records,
+                         size_t count) {
+    size_t pushed = ring.push(records, count);
+    recorded_.fetch_add(pushed, std::memory_order_relaxed);
+    if (pushed < count) dropped_.fetch_add(count - pushed, std::memory_order_relaxed);
+}
+
+FrameRecorderStats FrameRecorder::get_stats() const {
+    FrameRecorderStats stats;
+    stats.recorded = recorded_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void FrameRecorder::writer_loop() {
+    std::vector<FrameLogRecord> tx(tx_ring_.capacity());
+    std::vector<FrameLogRecord> rx(rx_ring_.capacity());
+    while (true) {
+        bool recording = is_recording();
+        size_t flushed = flush(tx, rx);
+        if (!recording && flushed == 0) break;
+        if (flushed == 0) std::this_thread::sleep_for(config_.flush_interval);
+    }
+}
+
+size_t FrameRecorder::flush(std::vector<FrameLogRecord>& tx, std::vector<FrameLogRecord>& rx) {
+    size_t tx_count = tx_ring_.pop(tx.data(), tx.size());
+    size_t rx_count = rx_ring_.pop(rx.data(), rx.size());
+
+    // Merge both directions by timestamp
+    size_t t = 0, r = 0;
+    while (t < tx_count || r < rx_count) {
+        bool take_tx =
+            r == rx_count || (t < tx_count && tx[t].timestamp_ns <= rx[r].timestamp_ns);
+        const FrameLogRecord& record = take_tx ? tx[t++] : rx[r++];
+        if (!append(record)) {
+            size_t lost = (tx_count - t) + (rx_count - r) + 1;
+            recorded_.fetch_sub(lost, std::memory_order_relaxed);
+            dropped_.fetch_add(lost, std::memory_order_relaxed);
+            break;
+        }
+    }
+    return tx_count + rx_count;
+}
+
+bool FrameRecorder::append(const FrameLogRecord& record) {
+    FrameLogHeader* log_header = header();
+    if (log_header->record_count == map_records_ && !grow()) return false;
+    log_header = header();
+    records()[log_header->record_count] = record;
+    log_header->record_count++;
+    return true;
+}
+
+bool FrameRecorder::grow() {
+    size_t old_size = sizeof(FrameLogHeader) + map_records_ * sizeof(FrameLogRecord);
+    size_t new_records = map_records_ + config_.file_chunk_records;
+    size_t new_size = sizeof(FrameLogHeader) + new_records * sizeof(FrameLogRecord);
+    if (ftruncate(fd_, new_size) < 0) {
+        std::cerr << "WARNING: Failed to grow frame log: " << errno_message() << std::endl;
+        return false;
+    }
+    void* map = mremap(map_, old_size, new_size, MREMAP_MAYMOVE);
+    if (map == MAP_FAILED) {
+        std::cerr << "WARNING: Failed to remap frame log: " << errno_message() << std::endl;
+        return false;
+    }
+    map_ = map;
+    map_records_ = new_records;
+    return true;
+}
+
+FrameLogReader::FrameLogReader(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open frame log " + path + ": " + errno_message());
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(FrameLogHeader)) {
+        close(fd);
+        throw std::runtime_error("Not a frame log: " + path);
+    }
+    map_size_ = st.st_size;
+    map_ = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        throw std::runtime_error("Failed to map frame log " + path + ": " + errno_message());
+    }
+
+    header_ = static_cast<const FrameLogHeader*>(map_);
+    if (std::memcmp(header_->magic, FRAME_LOG_MAGIC, sizeof(FRAME_LOG_MAGIC)) != 0 ||
+        header_->version != FRAME_LOG_VERSION || header_->record_size != sizeof(FrameLogRecord)) {
+        munmap(map_, map_size_);
+        map_ = nullptr;
+        throw std::runtime_error("Not a supported frame log: " + path);
+    }
+    records_ = reinterpret_cast<const FrameLogRecord*>(static_cast<const char*>(map_) +
+                                                       sizeof(FrameLogHeader));
+    size_t capacity = (map_size_ - sizeof(FrameLogHeader)) / sizeof(FrameLogRecord);
+    size_ = std::min<size_t>(header_->record_count, capacity);
+}
+
+FrameLogReader::~FrameLogReader() {
+    if (map_) munmap(map_, map_size_);
+}
+
+ReplayStats FrameReplayer::replay(CANDeviceCollection& collection, double speed) {
+    ReplayStats stats;
+    stop_requested_.store(false, std::memory_order_relaxed);
+
+    const auto start = std::chrono::steady_clock::now();
+    const int64_t start_ns = steady_clock_ns();
+    int64_t first_ns = 0;
+    bool first = true;
+    for (const FrameLogRecord& record : log_) {
+        if (stop_requested_.load(std::memory_order_relaxed)) break;
+        if (record.direction != FrameDirection::RX) continue;
+        if (first) {
+            first_ns = record.timestamp_ns;
+            first = false;
+        }
+
+        int64_t offset_ns = record.timestamp_ns - first_ns;
+        if (speed > 0) {
+            offset_ns = static_cast<int64_t>(offset_ns / speed);
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(offset_ns));
+        }
+        CANFrameTimestamp timestamp;
+        timestamp.software_ns = speed > 0 ? start_ns + offset_ns : steady_clock_ns();
+        timestamp.hardware_ns = record.hw_timestamp_ns;
+
+        bool dispatched;
+        if (record.is_fd) {
+            canfd_frame frame = to_canfd_frame(record);
+            dispatched = collection.dispatch_frame_callback(frame, timestamp);
+        } else {
+            can_frame frame = to_can_frame(record);
+            dispatched = collection.dispatch_frame_callback(frame, timestamp);
+        }
+        stats.frames++;
+        if (dispatched) stats.dispatched++;
+    }
+    stats.duration = std::chrono::steady_clock::now() - start;
+    return stats;
+}
+
+}  // namespace openarm::canbus
@@ -0,0 +1,378 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <liburing.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <openarm/canbus/can_socket.hpp>
+#include <openarm/canbus/io_uring_transport.hpp>
+
+namespace openarm::canbus {
+
+namespace {
+// Completion user_data: transport id, operation and TX slot
+enum class Operation : uint8_t { RECEIVE = 1, SEND = 2, CANCEL = 3 };
+
+constexpr uint64_t encode_user_data(uint16_t id, Operation operation, uint32_t slot = 0) {
+    return (static_cast<uint64_t>(id) << 48) | (static_cast<uint64_t>(operation) << 32) | slot;
+}
+
+int64_t steady_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+size_t next_power_of_two(size_t value) {
+    size_t power = 1;
+    while (power < value) power <<= 1;
+    return power;
+}
+}  // namespace
+
+struct IoUringContext::Ring {
+    io_uring ring;
+};
+
+IoUringContext::IoUringContext(const IoUringConfig& config)
+    : config_(config), ring_(std::make_unique<Ring>()) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    if (config.sqpoll) {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = config.sqpoll_idle.count();
+        if (config.sqpoll_cpu >= 0) {
+            params.flags |= IORING_SETUP_SQ_AFF;
+            params.sq_thread_cpu = config.sqpoll_cpu;
+        }
+    }
+    int ret = io_uring_queue_init_params(config.entries, &ring_->ring, &params);
+    if (ret < 0) {
+        throw CANSocketException(std::string("Failed to set up io_uring: ") + strerror(-ret));
+    }
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0 || io_uring_register_eventfd(&ring_->ring, event_fd_) < 0) {
+        int error = errno;
+        if (event_fd_ >= 0) close(event_fd_);
+        io_uring_queue_exit(&ring_->ring);
+        throw CANSocketException(std::string("Failed to register io_uring eventfd: ") +
+                                 strerror(error));
+    }
+}
+
+IoUringContext::~IoUringContext() {
+    // Transports hold a shared_ptr to their context, so none is left here
+    io_uring_queue_exit(&ring_->ring);
+    close(event_fd_);
+}
+
+uint16_t IoUringContext::add_transport(IoUringTransport* transport) {
+    for (size_t id = 0; id < transports_.size(); id++) {
+        if (!transports_[id]) {
+            transports_[id] = transport;
+            return id;
+        }
+    }
+    if (transports_.size() > UINT16_MAX) {
+        throw std::invalid_argument("Too many transports on one io_uring");
+    }
+    transports_.push_back(transport);
+    return transports_.size() - 1;
+}
+
+void IoUringContext::remove_transport(uint16_t id) { transports_[id] = nullptr; }
+
+void IoUringContext::reap_locked() {
+    uint64_t value;
+    [[maybe_unused]] ssize_t result = read(event_fd_, &value, sizeof(value));
+
+    io_uring_cqe* cqe;
+    unsigned head;
+    unsigned count = 0;
+    io_uring_for_each_cqe(&ring_->ring, head, cqe) {
+        count++;
+        uint64_t user_data = io_uring_cqe_get_data64(cqe);
+        uint16_t id = user_data >> 48;
+        auto operation = static_cast<Operation>((user_data >> 32) & 0xFF);
+        if (id >= transports_.size() || !transports_[id]) continue;
+        if (operation == Operation::RECEIVE) {
+            transports_[id]->complete_receive(cqe->res, cqe->flags);
+        } else if (operation == Operation::SEND) {
+            transports_[id]->complete_send(user_data & 0xFFFFFFFF, cqe->res);
+        }
+    }
+    io_uring_cq_advance(&ring_->ring, count);
+    // Completions may have re-armed receives
+    submit_locked();
+}
+
+void IoUringContext::submit_locked() {
+    if (!submit_pending_) return;
+    submit_pending_ = false;
+    int ret = io_uring_submit(&ring_->ring);
+    if (ret < 0) {
+        std::cerr << "WARNING: io_uring_submit failed: " << strerror(-ret) << std::endl;
+    }
+}
+
+void IoUringContext::update_readiness_locked() {
+    for (IoUringTransport* transport : transports_) {
+        if (transport && transport->has_queued_rx()) {
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t result = write(event_fd_, &one, sizeof(one));
+            return;
+        }
+    }
+}
+
+IoUringTransport::IoUringTransport(const std::string& interface, bool enable_fd,
+                                   std::shared_ptr<IoUringContext> context,
+                                   const IoUringTransportConfig& config)
+    : socket_(interface, enable_fd), context_(std::move(context)) {
+    if (!context_) throw std::invalid_argument("IoUringTransport needs an IoUringContext");
+    size_t rx_buffers = next_power_of_two(config.rx_buffers);
+    if (rx_buffers > 32768 || config.tx_slots == 0) {
+        throw std::invalid_argument("Invalid IoUringTransportConfig");
+    }
+    rx_buffers_.resize(rx_buffers);
+    rx_queue_.resize(next_power_of_two(config.rx_queue_size));
+    tx_buffers_.resize(config.tx_slots);
+    for (size_t slot = config.tx_slots; slot > 0; slot--) free_tx_slots_.push_back(slot - 1);
+
+    std::lock_guard<std::mutex> lock(context_->mutex_);
+    id_ = context_->add_transport(this);
+    int ret = 0;
+    // The buffer group id is the transport id
+    rx_buffer_ring_ =
+        io_uring_setup_buf_ring(&context_->ring_->ring, rx_buffers, id_, 0, &ret);
+    if (!rx_buffer_ring_) {
+        context_->remove_transport(id_);
+        throw CANSocketException(std::string("Failed to register io_uring receive buffers: ") +
+                                 strerror(-ret));
+    }
+    int mask = io_uring_buf_ring_mask(rx_buffers);
+    for (size_t bid = 0; bid < rx_buffers; bid++) {
+        io_uring_buf_ring_add(rx_buffer_ring_, &rx_buffers_[bid], sizeof(canfd_frame), bid, mask,
+                              bid);
+    }
+    io_uring_buf_ring_advance(rx_buffer_ring_, rx_buffers);
+
+    event_fd_ = fcntl(context_->event_fd_, F_DUPFD_CLOEXEC, 0);
+    if (event_fd_ < 0) {
+        int error = errno;
+        io_uring_free_buf_ring(&context_->ring_->ring, rx_buffer_ring_, rx_buffers, id_);
+        context_->remove_transport(id_);
+        throw CANSocketException(std::string("Failed to dup io_uring eventfd: ") +
+                                 strerror(error));
+    }
+
+    arm_receive_locked();
+    context_->submit_locked();
+}
+
+IoUringTransport::~IoUringTransport() {
+    std::lock_guard<std::mutex> lock(context_->mutex_);
+    io_uring* ring = &context_->ring_->ring;
+    closing_ = true;
+    // The buffers must not be freed while the kernel may still use them: cancel everything
+    // on the socket and wait for the receive and all sends to complete
+    io_uring_sqe* sqe = io_uring_get_sqe(ring);
+    if (!sqe) {
+        io_uring_submit(ring);
+        sqe = io_uring_get_sqe(ring);
+    }
+    if (sqe) {
+        io_uring_prep_cancel_fd(sqe, socket_.get_fd(), IORING_ASYNC_CANCEL_ALL);
+        io_uring_sqe_set_data64(sqe, encode_user_data(id_, Operation::CANCEL));
+        context_->submit_pending_ = true;
+        context_->submit_locked();
+    }
+    for (int attempt = 0;
+         attempt < 10 && (rx_armed_ || free_tx_slots_.size() < tx_buffers_.size()); attempt++) {
+        io_uring_cqe* cqe;
+        __kernel_timespec timeout{0, 100000000};
+        io_uring_wait_cqe_timeout(ring, &cqe, &timeout);
+        context_->reap_locked();
+    }
+    if (rx_armed_ || free_tx_slots_.size() < tx_buffers_.size()) {
+        std::cerr << "WARNING: io_uring requests on " << get_interface()
+                  << " did not complete before close" << std::endl;
+    }
+    io_uring_free_buf_ring(ring, rx_buffer_ring_, rx_buffers_.size(), id_);
+    context_->remove_transport(id_);
+    close(event_fd_);
+}
+
+void IoUringTransport::arm_receive_locked() {
+    io_uring* ring = &context_->ring_->ring;
+    io_uring_sqe* sqe = io_uring_get_sqe(ring);
+    if (!sqe) {
+        io_uring_submit(ring);
+        sqe = io_uring_get_sqe(ring);
+        if (!sqe) {
+            std::cerr << "WARNING: io_uring submission queue full, receive on "
+                      << get_interface() << " not armed" << std::endl;
+            return;
+        }
+    }
+    io_uring_prep_recv_multishot(sqe, socket_.get_fd(), nullptr, 0, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = id_;
+    io_uring_sqe_set_data64(sqe, encode_user_data(id_, Operation::RECEIVE));
+    context_->submit_pending_ = true;
+    rx_armed_ = true;
+}
+
+void IoUringTransport::complete_receive(int result, uint32_t flags) {
+    if (flags & IORING_CQE_F_BUFFER) {
+        uint16_t bid = flags >> IORING_CQE_BUFFER_SHIFT;
+        if (result > 0) {
+            if (rx_tail_ - rx_head_ < rx_queue_.size()) {
+                QueuedFrame& queued = rx_queue_[rx_tail_ & (rx_queue_.size() - 1)];
+                memcpy(&queued.frame, &rx_buffers_[bid], result);
+                queued.size = result;
+                queued.received_ns = timestamping_ ? steady_clock_ns() : 0;
+                rx_tail_++;
+            } else {
+                rx_overflows_++;
+            }
+        }
+        // Hand the buffer straight back to the kernel
+        io_uring_buf_ring_add(rx_buffer_ring_, &rx_buffers_[bid], sizeof(canfd_frame), bid,
+                              io_uring_buf_ring_mask(rx_buffers_.size()), 0);
+        io_uring_buf_ring_advance(rx_buffer_ring_, 1);
+    } else if (result == -ENOBUFS) {
+        // Every buffer was in use, the kernel dropped frames
+        rx_overflows_++;
+    } else if (result < 0 && result != -ECANCELED) {
+        std::cerr << "WARNING: io_uring receive on " << get_interface()
+                  << " failed: " << strerror(-result) << std::endl;
+    }
+    if (!(flags & IORING_CQE_F_MORE)) {
+        rx_armed_ = false;
+        if (!closing_) arm_receive_locked();
+    }
+}
+
+void IoUringTransport::complete_send(uint32_t slot, int result) {
+    if (result < 0) tx_errors_++;
+    free_tx_slots_.push_back(slot);
+}
+
+bool IoUringTransport::queue_send_locked(const void* frame, size_t size) {
+    io_uring* ring = &context_->ring_->ring;
+    if (free_tx_slots_.empty()) {
+        context_->reap_locked();
+        if (free_tx_slots_.empty()) return false;
+    }
+    io_uring_sqe* sqe = io_uring_get_sqe(ring);
+    if (!sqe) {
+        io_uring_submit(ring);
+        context_->submit_pending_ = false;
+        sqe = io_uring_get_sqe(ring);
+        if (!sqe) return false;
+    }
+    uint32_t slot = free_tx_slots_.back();
+    free_tx_slots_.pop_back();
+    memcpy(&tx_buffers_[slot], frame, size);
+    io_uring_prep_send(sqe, socket_.get_fd(), &tx_buffers_[slot], size, 0);
+    io_uring_sqe_set_data64(sqe, encode_user_data(id_, Operation::SEND, slot));
+    context_->submit_pending_ = true;
+    return true;
+}
+
+template <typename Frame>
+size_t IoUringTransport::send_frames(const Frame* frames, size_t count) {
+    std::lock_guard<std::mutex> lock(context_->mutex_);
+    size_t sent = 0;
+    while (sent < count && queue_send_locked(&frames[sent], sizeof(Frame))) sent++;
+    context_->submit_locked();
+    if (sent < count) errno = ENOBUFS;
+    return sent;
+}
+
+size_t IoUringTransport::send(const can_frame* frames, size_t count) {
+    return send_frames(frames, count);
+}
+
+size_t IoUringTransport::send(const canfd_frame* frames, size_t count) {
+    return send_frames(frames, count);
+}
+
+int IoUringTransport::try_send(const TxFrame* frames, size_t count) {
+    std::lock_guard<std::mutex> lock(context_->mutex_);
+    size_t sent = 0;
+    while (sent < count && queue_send_locked(&frames[sent].frame, frames[sent].size)) sent++;
+    context_->submit_locked();
+    if (sent == 0 && count > 0) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    return static_cast<int>(sent);
+}
+
+template <typename Frame>
+size_t IoUringTransport::receive_frames(Frame* frames, CANFrameTimestamp* timestamps,
+                                        size_t max_count, CANReceiveInfo& info) {
+    std::lock_guard<std::mutex> lock(context_->mutex_);
+    if (!has_queued_rx()) context_->reap_locked();
+    size_t received = 0;
+    while (received < max_count && has_queued_rx()) {
+        const QueuedFrame& queued = rx_queue_[rx_head_ & (rx_queue_.size() - 1)];
+        if (queued.size == sizeof(Frame)) {
+            memcpy(&frames[received], &queued.frame, sizeof(Frame));
+            if (timestamps) {
+                timestamps[received] = CANFrameTimestamp();
+                timestamps[received].software_ns = queued.received_ns;
+            }
+            received++;
+        } else {
+            info.malformed_frames++;
+        }
+        rx_head_++;
+    }
+    if (rx_overflows_ > 0) info.rx_queue_overflow_total = rx_overflows_;
+    context_->update_readiness_locked();
+    return received;
+}
+
+size_t IoUringTransport::receive(can_frame* frames, CANFrameTimestamp* timestamps,
+                                 size_t max_count, CANReceiveInfo& info) {
+    return receive_frames(frames, timestamps, max_count, info);
+}
+
+size_t IoUringTransport::receive(canfd_frame* frames, CANFrameTimestamp* timestamps,
+                                 size_t max_count, CANReceiveInfo& info) {
+    return receive_frames(frames, timestamps, max_count, info);
+}
+
+bool IoUringTransport::enable_timestamping(TimestampMode mode) {
+    if (mode == TimestampMode::HARDWARE) return false;
+    std::lock_guard<std::mutex> lock(context_->mutex_);
+    timestamping_ = mode == TimestampMode::SOFTWARE;
+    return true;
+}
+
+uint64_t IoUringTransport::get_tx_errors() const {
+    std::lock_guard<std::mutex> lock(context_->mutex_);
+    return tx_errors_;
+}
+
+}  // namespace openarm::canbus
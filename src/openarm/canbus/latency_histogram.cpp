@@ -0,0 +1,67 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <openarm/canbus/latency_histogram.hpp>
+
+namespace openarm::canbus {
+
+uint64_t HistogramSnapshot::value_at_percentile(double percentile) const {
+    if (count == 0) return 0;
+    percentile = std::clamp(percentile, 0.0, 100.0);
+    uint64_t target = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(count))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucket_counts.size(); i++) {
+        seen += bucket_counts[i];
+        if (seen >= target) {
+            if (i + 1 >= bucket_counts.size()) return max_ns;
+            return std::min(LatencyHistogram::bucket_lower_bound(i + 1) - 1, max_ns);
+        }
+    }
+    return max_ns;
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+    HistogramSnapshot snapshot;
+    snapshot.bucket_counts.resize(BUCKET_COUNT);
+    uint64_t count = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        snapshot.bucket_counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        count += snapshot.bucket_counts[i];
+    }
+    // Derive the count from the buckets so percentiles stay consistent with concurrent records
+    snapshot.count = count;
+    if (count > 0) {
+        snapshot.min_ns = min_.load(std::memory_order_relaxed);
+        snapshot.max_ns = max_.load(std::memory_order_relaxed);
+        uint64_t recorded = count_.load(std::memory_order_relaxed);
+        if (recorded > 0) {
+            snapshot.mean_ns = static_cast<double>(sum_.load(std::memory_order_relaxed)) /
+                               static_cast<double>(recorded);
+        }
+    }
+    return snapshot;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace openarm::canbus
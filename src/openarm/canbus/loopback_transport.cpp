@@ -0,0 +1,207 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <openarm/canbus/can_socket.hpp>
+#include <openarm/canbus/loopback_transport.hpp>
+#include <openarm/canbus/spsc_ring.hpp>
+
+namespace openarm::canbus {
+
+namespace {
+// Frames moved per ring operation, kept small so they live on the stack
+constexpr size_t kChunkSize = 64;
+
+struct QueuedFrame {
+    canfd_frame frame;
+    size_t size;
+    int64_t sent_ns;
+};
+
+int64_t steady_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+}  // namespace
+
+// signaled is set while event_fd is readable (or about to be drained by the consumer), so
+// the producer only makes a syscall when the consumer may be asleep
+struct LoopbackTransport::Queue {
+    explicit Queue(size_t size) : ring(size) {
+        event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (event_fd < 0) {
+            throw CANSocketException(std::string("Failed to create eventfd: ") +
+                                     strerror(errno));
+        }
+    }
+    ~Queue() { close(event_fd); }
+
+    size_t push(const QueuedFrame* frames, size_t count) {
+        size_t pushed = ring.push(frames, count);
+        if (pushed > 0) signal();
+        return pushed;
+    }
+
+    size_t pop(QueuedFrame* frames, size_t max_count) {
+        if (signaled.load(std::memory_order_acquire)) {
+            uint64_t value;
+            [[maybe_unused]] ssize_t result = read(event_fd, &value, sizeof(value));
+            signaled.exchange(false, std::memory_order_acq_rel);
+        }
+        size_t popped = ring.pop(frames, max_count);
+        // Frames left behind must keep the fd readable
+        if (!ring.empty()) signal();
+        return popped;
+    }
+
+    void signal() {
+        if (signaled.exchange(true, std::memory_order_acq_rel)) return;
+        uint64_t value = 1;
+        [[maybe_unused]] ssize_t result = write(event_fd, &value, sizeof(value));
+    }
+
+    SPSCRing<QueuedFrame> ring;
+    int event_fd;
+    std::atomic<bool> signaled{false};
+};
+
+std::pair<std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>>
+LoopbackTransport::create_pair(const std::string& interface, bool enable_fd, size_t queue_size) {
+    auto a_to_b = std::make_shared<Queue>(queue_size);
+    auto b_to_a = std::make_shared<Queue>(queue_size);
+    std::unique_ptr<LoopbackTransport> a(
+        new LoopbackTransport(interface, enable_fd, b_to_a, a_to_b));
+    std::unique_ptr<LoopbackTransport> b(
+        new LoopbackTransport(interface, enable_fd, a_to_b, b_to_a));
+    return {std::move(a), std::move(b)};
+}
+
+LoopbackTransport::LoopbackTransport(std::string interface, bool enable_fd,
+                                     std::shared_ptr<Queue> rx_queue,
+                                     std::shared_ptr<Queue> tx_queue)
+    : interface_(std::move(interface)),
+      fd_enabled_(enable_fd),
+      rx_queue_(std::move(rx_queue)),
+      tx_queue_(std::move(tx_queue)) {}
+
+LoopbackTransport::~LoopbackTransport() = default;
+
+int LoopbackTransport::get_fd() const { return rx_queue_->event_fd; }
+
+size_t LoopbackTransport::send(const can_frame* frames, size_t count) {
+    return send_frames(frames, count);
+}
+
+size_t LoopbackTransport::send(const canfd_frame* frames, size_t count) {
+    return send_frames(frames, count);
+}
+
+template <typename Frame>
+size_t LoopbackTransport::send_frames(const Frame* frames, size_t count) {
+    QueuedFrame entries[kChunkSize];
+    int64_t now_ns = steady_clock_ns();
+    size_t sent = 0;
+    while (sent < count) {
+        size_t chunk = std::min(count - sent, kChunkSize);
+        for (size_t i = 0; i < chunk; i++) {
+            memcpy(&entries[i].frame, &frames[sent + i], sizeof(Frame));
+            entries[i].size = sizeof(Frame);
+            entries[i].sent_ns = now_ns;
+        }
+        size_t pushed = tx_queue_->push(entries, chunk);
+        sent += pushed;
+        if (pushed < chunk) {
+            errno = ENOBUFS;
+            break;
+        }
+    }
+    return sent;
+}
+
+int LoopbackTransport::try_send(const TxFrame* frames, size_t count) {
+    QueuedFrame entries[kChunkSize];
+    int64_t now_ns = steady_clock_ns();
+    count = std::min(count, kChunkSize);
+    for (size_t i = 0; i < count; i++) {
+        entries[i].frame = frames[i].frame;
+        entries[i].size = frames[i].size;
+        entries[i].sent_ns = now_ns;
+    }
+    size_t pushed = tx_queue_->push(entries, count);
+    if (pushed == 0 && count > 0) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    return static_cast<int>(pushed);
+}
+
+size_t LoopbackTransport::receive(can_frame* frames, CANFrameTimestamp* timestamps,
+                                  size_t max_count, CANReceiveInfo& info) {
+    return receive_frames(frames, timestamps, max_count, info);
+}
+
+size_t LoopbackTransport::receive(canfd_frame* frames, CANFrameTimestamp* timestamps,
+                                  size_t max_count, CANReceiveInfo& info) {
+    return receive_frames(frames, timestamps, max_count, info);
+}
+
+template <typename Frame>
+size_t LoopbackTransport::receive_frames(Frame* frames, CANFrameTimestamp* timestamps,
+                                         size_t max_count, CANReceiveInfo& info) {
+    QueuedFrame entries[kChunkSize];
+    size_t received = 0;
+    while (received < max_count) {
+        size_t chunk = std::min(max_count - received, kChunkSize);
+        size_t popped = rx_queue_->pop(entries, chunk);
+        for (size_t i = 0; i < popped; i++) {
+            if (entries[i].size != sizeof(Frame)) {
+                info.malformed_frames++;
+                continue;
+            }
+            if (filtering_ && !matches_can_filters(filters_, entries[i].frame.can_id)) continue;
+            memcpy(&frames[received], &entries[i].frame, sizeof(Frame));
+            if (timestamps) {
+                timestamps[received] = CANFrameTimestamp();
+                if (timestamping_) timestamps[received].software_ns = entries[i].sent_ns;
+            }
+            received++;
+        }
+        if (popped < chunk) break;
+    }
+    return received;
+}
+
+bool LoopbackTransport::enable_timestamping(TimestampMode mode) {
+    if (mode == TimestampMode::HARDWARE) return false;
+    timestamping_ = mode == TimestampMode::SOFTWARE;
+    return true;
+}
+
+bool LoopbackTransport::set_filters(const std::vector<can_filter>& filters) {
+    filters_ = filters;
+    // A single match-all filter is what a fresh socket has
+    filtering_ = !(filters.size() == 1 && filters[0].can_mask == 0 &&
+                   !(filters[0].can_id & CAN_INV_FILTER));
+    return true;
+}
+
+}  // namespace openarm::canbus
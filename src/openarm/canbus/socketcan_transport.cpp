@@ -0,0 +1,315 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/can/raw.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+#include <net/if.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <openarm/canbus/can_socket.hpp>
+#include <openarm/canbus/socketcan_transport.hpp>
+
+namespace openarm::canbus {
+
+namespace {
+// Number of messages handed to a single sendmmsg()/recvmmsg() call. Kept small so the
+// headers live on the stack.
+constexpr size_t kMaxFramesPerSyscall = 64;
+
+template <typename Frame>
+size_t send_frames(int socket_fd, const Frame* frames, size_t count) {
+    struct mmsghdr msgs[kMaxFramesPerSyscall];
+    struct iovec iovs[kMaxFramesPerSyscall];
+
+    size_t sent = 0;
+    while (sent < count) {
+        size_t chunk = std::min(count - sent, kMaxFramesPerSyscall);
+        for (size_t i = 0; i < chunk; i++) {
+            iovs[i].iov_base = const_cast<Frame*>(&frames[sent + i]);
+            iovs[i].iov_len = sizeof(Frame);
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int result = sendmmsg(socket_fd, msgs, chunk, 0);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        sent += result;
+        if (static_cast<size_t>(result) < chunk) {
+            // Partial send (e.g. the TX queue is full), stop here and let the caller decide.
+            break;
+        }
+    }
+    return sent;
+}
+
+// Space for the SO_RXQ_OVFL and SO_TIMESTAMPING control messages of one received frame
+constexpr size_t kRecvControlSize =
+    CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(struct scm_timestamping));
+
+int64_t timespec_to_ns(const struct timespec& ts) {
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Software timestamps use CLOCK_REALTIME, steady_clock is CLOCK_MONOTONIC
+int64_t realtime_to_monotonic_offset_ns() {
+    struct timespec realtime, monotonic;
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    clock_gettime(CLOCK_MONOTONIC, &monotonic);
+    return timespec_to_ns(realtime) - timespec_to_ns(monotonic);
+}
+
+void parse_timestamping(const struct cmsghdr* cmsg, int64_t realtime_offset_ns,
+                        CANFrameTimestamp& timestamp) {
+    struct scm_timestamping timestamping;
+    memcpy(&timestamping, CMSG_DATA(cmsg), sizeof(timestamping));
+    // ts[0]: software, ts[2]: raw hardware
+    if (timestamping.ts[0].tv_sec || timestamping.ts[0].tv_nsec) {
+        timestamp.software_ns = timespec_to_ns(timestamping.ts[0]) - realtime_offset_ns;
+    }
+    timestamp.hardware_ns = timespec_to_ns(timestamping.ts[2]);
+}
+
+template <typename Frame>
+size_t recv_frames(int socket_fd, Frame* frames, CANFrameTimestamp* timestamps,
+                   size_t max_count, bool timestamping, CANReceiveInfo& info) {
+    struct mmsghdr msgs[kMaxFramesPerSyscall];
+    struct iovec iovs[kMaxFramesPerSyscall];
+    alignas(struct cmsghdr) char controls[kMaxFramesPerSyscall][kRecvControlSize];
+
+    size_t received = 0;
+    while (received < max_count) {
+        size_t chunk = std::min(max_count - received, kMaxFramesPerSyscall);
+        for (size_t i = 0; i < chunk; i++) {
+            iovs[i].iov_base = &frames[received + i];
+            iovs[i].iov_len = sizeof(Frame);
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = controls[i];
+            msgs[i].msg_hdr.msg_controllen = kRecvControlSize;
+        }
+        int result = recvmmsg(socket_fd, msgs, chunk, MSG_DONTWAIT, nullptr);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            // EAGAIN: nothing (more) queued
+            break;
+        }
+        int64_t realtime_offset_ns = timestamping ? realtime_to_monotonic_offset_ns() : 0;
+
+        // Drop short frames (e.g. classic frames on a CAN-FD socket) by compacting the array
+        size_t valid = 0;
+        for (int i = 0; i < result; i++) {
+            CANFrameTimestamp timestamp;
+            for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg;
+                 cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+                if (cmsg->cmsg_level != SOL_SOCKET) continue;
+                if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+                    uint32_t total;
+                    memcpy(&total, CMSG_DATA(cmsg), sizeof(total));
+                    info.rx_queue_overflow_total = total;
+                } else if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                    parse_timestamping(cmsg, realtime_offset_ns, timestamp);
+                }
+            }
+            if (msgs[i].msg_len != sizeof(Frame)) {
+                info.malformed_frames++;
+                continue;
+            }
+            if (valid != static_cast<size_t>(i)) {
+                frames[received + valid] = frames[received + i];
+            }
+            if (timestamps) timestamps[received + valid] = timestamp;
+            valid++;
+        }
+        received += valid;
+        if (static_cast<size_t>(result) < chunk) break;
+    }
+    return received;
+}
+}  // namespace
+
+SocketCANTransport::SocketCANTransport(const std::string& interface, bool enable_fd)
+    : interface_(interface), fd_enabled_(enable_fd) {
+    if (!initialize_socket()) {
+        throw CANSocketException("Failed to initialize socket for interface: " + interface);
+    }
+}
+
+SocketCANTransport::~SocketCANTransport() { cleanup(); }
+
+bool SocketCANTransport::initialize_socket() {
+    // Create socket
+    socket_fd_ = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (socket_fd_ < 0) {
+        return false;
+    }
+
+    struct ifreq ifr;
+    struct sockaddr_can addr;
+
+    strncpy(ifr.ifr_name, interface_.c_str(), IFNAMSIZ - 1);
+    ifr.ifr_name[IFNAMSIZ - 1] = '\0';
+
+    if (ioctl(socket_fd_, SIOCGIFINDEX, &ifr) < 0) {
+        cleanup();
+        return false;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+
+    if (fd_enabled_) {
+        int enable_canfd = 1;
+        if (setsockopt(socket_fd_, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable_canfd,
+                       sizeof(enable_canfd)) < 0) {
+            cleanup();
+            return false;
+        }
+    }
+
+    if (bind(socket_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        cleanup();
+        return false;
+    }
+
+    // Report kernel receive queue drops, without it we just lose frames silently
+    int enable_rxq_ovfl = 1;
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_RXQ_OVFL, &enable_rxq_ovfl,
+                   sizeof(enable_rxq_ovfl)) < 0) {
+        std::cerr << "WARNING: SO_RXQ_OVFL is not supported, receive queue overflows are not "
+                     "counted"
+                  << std::endl;
+    }
+
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 100;
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+        cleanup();
+        return false;
+    }
+
+    return true;
+}
+
+void SocketCANTransport::cleanup() {
+    if (socket_fd_ >= 0) {
+        close(socket_fd_);
+        socket_fd_ = -1;
+    }
+}
+
+size_t SocketCANTransport::send(const can_frame* frames, size_t count) {
+    if (count == 1) return write(socket_fd_, frames, sizeof(can_frame)) == sizeof(can_frame);
+    return send_frames(socket_fd_, frames, count);
+}
+
+size_t SocketCANTransport::send(const canfd_frame* frames, size_t count) {
+    if (count == 1) {
+        return write(socket_fd_, frames, sizeof(canfd_frame)) == sizeof(canfd_frame);
+    }
+    return send_frames(socket_fd_, frames, count);
+}
+
+// A single sendmmsg() for up to kMaxFramesPerSyscall mixed classic and FD frames
+int SocketCANTransport::try_send(const TxFrame* frames, size_t count) {
+    struct mmsghdr msgs[kMaxFramesPerSyscall];
+    struct iovec iovs[kMaxFramesPerSyscall];
+    count = std::min(count, kMaxFramesPerSyscall);
+    for (size_t i = 0; i < count; i++) {
+        iovs[i].iov_base = const_cast<canfd_frame*>(&frames[i].frame);
+        iovs[i].iov_len = frames[i].size;
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    return sendmmsg(socket_fd_, msgs, count, MSG_DONTWAIT);
+}
+
+size_t SocketCANTransport::receive(can_frame* frames, CANFrameTimestamp* timestamps,
+                                   size_t max_count, CANReceiveInfo& info) {
+    return recv_frames(socket_fd_, frames, timestamps, max_count, timestamping_, info);
+}
+
+size_t SocketCANTransport::receive(canfd_frame* frames, CANFrameTimestamp* timestamps,
+                                   size_t max_count, CANReceiveInfo& info) {
+    return recv_frames(socket_fd_, frames, timestamps, max_count, timestamping_, info);
+}
+
+bool SocketCANTransport::enable_timestamping(TimestampMode mode) {
+    int flags = 0;
+    if (mode != TimestampMode::NONE) {
+        flags |= SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    }
+    if (mode == TimestampMode::HARDWARE) {
+        flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+
+        // Most CAN drivers timestamp unconditionally, the rest need to be told to
+        struct hwtstamp_config config;
+        memset(&config, 0, sizeof(config));
+        config.tx_type = HWTSTAMP_TX_OFF;
+        config.rx_filter = HWTSTAMP_FILTER_ALL;
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, interface_.c_str(), IFNAMSIZ - 1);
+        ifr.ifr_data = reinterpret_cast<char*>(&config);
+        if (ioctl(socket_fd_, SIOCSHWTSTAMP, &ifr) < 0) {
+            std::cerr << "WARNING: could not enable hardware timestamping on " << interface_
+                      << ": " << strerror(errno) << std::endl;
+        }
+    }
+
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0) {
+        return false;
+    }
+    timestamping_ = mode != TimestampMode::NONE;
+    return true;
+}
+
+bool SocketCANTransport::set_filters(const std::vector<can_filter>& filters) {
+    return setsockopt(socket_fd_, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(),
+                      filters.size() * sizeof(can_filter)) == 0;
+}
+
+bool SocketCANTransport::set_loopback(bool enable) {
+    int value = enable ? 1 : 0;
+    return setsockopt(socket_fd_, SOL_CAN_RAW, CAN_RAW_LOOPBACK, &value, sizeof(value)) == 0;
+}
+
+bool SocketCANTransport::set_recv_own_msgs(bool enable) {
+    int value = enable ? 1 : 0;
+    return setsockopt(socket_fd_, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &value, sizeof(value)) ==
+           0;
+}
+
+bool SocketCANTransport::set_busy_poll(int busy_poll_us) {
+    return setsockopt(socket_fd_, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_us,
+                      sizeof(busy_poll_us)) == 0;
+}
+
+}  // namespace openarm::canbus
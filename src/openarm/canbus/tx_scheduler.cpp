@@ -0,0 +1,205 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <openarm/canbus/tx_scheduler.hpp>
+#include <stdexcept>
+
+namespace openarm::canbus {
+
+namespace {
+int64_t bits_to_ns(int64_t bits, uint32_t bitrate) {
+    return bits * 1000000000 / static_cast<int64_t>(bitrate);
+}
+
+// Damiao clear error, enable, disable and set zero (FF FF FF FF FF FF FF FB-FE) go to the
+// setpoint ID of the motor, but every one of them has to arrive
+bool is_command_frame(const TxFrame& frame) {
+    const canfd_frame& f = frame.frame;
+    if (f.len != 8) return false;
+    return std::all_of(f.data, f.data + 7, [](uint8_t byte) { return byte == 0xFF; }) &&
+           f.data[7] >= 0xFB && f.data[7] <= 0xFE;
+}
+}  // namespace
+
+int64_t frame_duration_ns(const can_frame& frame, uint32_t bitrate) {
+    int64_t data_bits = 8 * std::min<int64_t>(frame.can_dlc, CAN_MAX_DLEN);
+    // SOF, arbitration, control, data and CRC are stuffed, the trailer is not
+    int64_t stuffed = ((frame.can_id & CAN_EFF_FLAG) ? 54 : 34) + data_bits;
+    // CRC delimiter, ACK, EOF and interframe space
+    int64_t trailer = 13;
+    return bits_to_ns(stuffed + (stuffed - 1) / 4 + trailer, bitrate);
+}
+
+int64_t frame_duration_ns(const canfd_frame& frame, uint32_t bitrate, uint32_t data_bitrate) {
+    int64_t length = std::min<int64_t>(frame.len, CANFD_MAX_DLEN);
+    // Nominal bitrate: SOF up to BRS, then CRC delimiter to interframe space
+    int64_t arbitration = (frame.can_id & CAN_EFF_FLAG) ? 36 : 17;
+    int64_t nominal_bits = arbitration + arbitration / 4 + 13;
+    // Data bitrate: ESI, DLC, data, stuff count and CRC with their stuff bits
+    int64_t crc = length <= 16 ? 17 : 21;
+    int64_t payload = 5 + 8 * length;
+    int64_t data_bits = payload + payload / 4 + 4 + crc + (4 + crc + 3) / 4;
+    uint32_t data_rate = (frame.flags & CANFD_BRS) && data_bitrate ? data_bitrate : bitrate;
+    return bits_to_ns(nominal_bits, bitrate) + bits_to_ns(data_bits, data_rate);
+}
+
+int64_t frame_duration_ns(const TxFrame& frame, uint32_t bitrate, uint32_t data_bitrate) {
+    if (frame.size == CANFD_MTU) return frame_duration_ns(frame.frame, bitrate, data_bitrate);
+    return frame_duration_ns(reinterpret_cast<const can_frame&>(frame.frame), bitrate);
+}
+
+TxScheduler::TxScheduler(const TxSchedulerConfig& config) : config_(config) {
+    if (config_.bitrate == 0) throw std::invalid_argument("TxScheduler bitrate must be positive");
+    if (config_.max_queue_size == 0) {
+        throw std::invalid_argument("TxScheduler max_queue_size must be positive");
+    }
+    queue_.reserve(config_.max_queue_size);
+}
+
+bool TxScheduler::lower_priority(const Entry& a, const Entry& b) {
+    canid_t a_id = a.frame.frame.can_id & CAN_EFF_MASK;
+    canid_t b_id = b.frame.frame.can_id & CAN_EFF_MASK;
+    if (a_id != b_id) return a_id > b_id;
+    return a.sequence > b.sequence;
+}
+
+bool TxScheduler::is_mergeable(const TxFrame& frame) const {
+    return config_.merge_by_id && frame.frame.can_id != config_.shared_id &&
+           !is_command_frame(frame);
+}
+
+TxScheduler::Entry* TxScheduler::find_merge_target(const TxFrame& frame) {
+    if (!is_mergeable(frame)) return nullptr;
+    // Only the newest frame for the ID: merging past a command frame would reorder the two
+    Entry* newest = nullptr;
+    for (Entry& entry : queue_) {
+        if (entry.frame.frame.can_id != frame.frame.can_id) continue;
+        if (!newest || entry.sequence > newest->sequence) newest = &entry;
+    }
+    return newest && !is_command_frame(newest->frame) ? newest : nullptr;
+}
+
+bool TxScheduler::has_newer_setpoint(const TxFrame& frame) const {
+    if (!is_mergeable(frame)) return false;
+    return std::any_of(queue_.begin(), queue_.end(), [&](const Entry& entry) {
+        return entry.frame.frame.can_id == frame.frame.can_id && !is_command_frame(entry.frame);
+    });
+}
+
+bool TxScheduler::push(const TxFrame& frame) {
+    // Same ID, same heap position: replacing the frame keeps the heap valid
+    if (Entry* queued = find_merge_target(frame)) {
+        queued->frame = frame;
+        merged_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (queue_.size() >= config_.max_queue_size) {
+        count_dropped(1);
+        return false;
+    }
+    queue_.push_back({frame, next_sequence_++});
+    std::push_heap(queue_.begin(), queue_.end(), lower_priority);
+    update_queue_depth();
+    return true;
+}
+
+int64_t TxScheduler::time_until_ready(int64_t now_ns) const {
+    int64_t max_backlog_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(config_.max_backlog).count();
+    return std::max<int64_t>(0, bus_free_at_ns_ - now_ns - max_backlog_ns);
+}
+
+size_t TxScheduler::pop_ready(TxFrame* frames, size_t max_count, int64_t now_ns) {
+    int64_t budget_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(config_.max_backlog).count() -
+        std::max<int64_t>(0, bus_free_at_ns_ - now_ns);
+    size_t count = 0;
+    while (count < max_count && !queue_.empty() && budget_ns >= 0) {
+        std::pop_heap(queue_.begin(), queue_.end(), lower_priority);
+        frames[count] = queue_.back().frame;
+        queue_.pop_back();
+        budget_ns -= frame_duration_ns(frames[count], config_.bitrate, config_.data_bitrate);
+        count++;
+    }
+    update_queue_depth();
+    return count;
+}
+
+void TxScheduler::requeue(const TxFrame* frames, size_t count) {
+    // Backwards, so the first frame gets the smallest sequence number
+    for (size_t i = count; i-- > 0;) {
+        // Anything queued for the same ID was written after this frame
+        if (has_newer_setpoint(frames[i])) {
+            merged_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        queue_.push_back({frames[i], --front_sequence_});
+        std::push_heap(queue_.begin(), queue_.end(), lower_priority);
+    }
+    update_queue_depth();
+}
+
+void TxScheduler::on_sent(const TxFrame* frames, size_t count, int64_t now_ns) {
+    int64_t bus_time_ns = 0;
+    for (size_t i = 0; i < count; i++) {
+        bus_time_ns += frame_duration_ns(frames[i], config_.bitrate, config_.data_bitrate);
+    }
+    bus_free_at_ns_ = std::max(bus_free_at_ns_, now_ns) + bus_time_ns;
+    record_bus_time(bus_time_ns);
+
+    int64_t window_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(config_.utilization_window).count();
+    if (window_start_ns_ == 0) {
+        window_start_ns_ = now_ns;
+        window_start_busy_ns_ = busy_ns_.load(std::memory_order_relaxed);
+    } else if (now_ns - window_start_ns_ >= window_ns) {
+        uint64_t busy_ns = busy_ns_.load(std::memory_order_relaxed);
+        utilization_.store(static_cast<double>(busy_ns - window_start_busy_ns_) /
+                               static_cast<double>(now_ns - window_start_ns_),
+                           std::memory_order_relaxed);
+        window_start_ns_ = now_ns;
+        window_start_busy_ns_ = busy_ns;
+    }
+}
+
+void TxScheduler::update_queue_depth() {
+    queue_depth_.store(queue_.size(), std::memory_order_relaxed);
+    if (queue_.size() > max_queue_depth_.load(std::memory_order_relaxed)) {
+        max_queue_depth_.store(queue_.size(), std::memory_order_relaxed);
+    }
+}
+
+TxSchedulerStats TxScheduler::get_stats() const {
+    TxSchedulerStats stats;
+    stats.utilization = utilization_.load(std::memory_order_relaxed);
+    stats.queue_depth = queue_depth_.load(std::memory_order_relaxed);
+    stats.max_queue_depth = max_queue_depth_.load(std::memory_order_relaxed);
+    stats.enobufs = enobufs_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.deferred = deferred_.load(std::memory_order_relaxed);
+    stats.merged = merged_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void TxScheduler::reset_stats() {
+    max_queue_depth_.store(queue_depth_.load(std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+    enobufs_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+    deferred_.store(0, std::memory_order_relaxed);
+    merged_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace openarm::canbus
@@ -0,0 +1,44 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <openarm/damiao_motor/dm_joint_state.hpp>
+
+namespace openarm::damiao_motor {
+
+void JointState::resize(size_t n) {
+    if (size() == n) return;
+    positions.resize(n, 0.0);
+    velocities.resize(n, 0.0);
+    torques.resize(n, 0.0);
+    t_mos.resize(n, 0);
+    t_rotor.resize(n, 0);
+    timestamps_ns.resize(n, 0);
+    hw_timestamps_ns.resize(n, 0);
+    sequences.resize(n, 0);
+}
+
+void JointState::copy_to(JointState& out) const {
+    out.resize(size());
+    std::copy(positions.begin(), positions.end(), out.positions.begin());
+    std::copy(velocities.begin(), velocities.end(), out.velocities.begin());
+    std::copy(torques.begin(), torques.end(), out.torques.begin());
+    std::copy(t_mos.begin(), t_mos.end(), out.t_mos.begin());
+    std::copy(t_rotor.begin(), t_rotor.end(), out.t_rotor.begin());
+    std::copy(timestamps_ns.begin(), timestamps_ns.end(), out.timestamps_ns.begin());
+    std::copy(hw_timestamps_ns.begin(), hw_timestamps_ns.end(), out.hw_timestamps_ns.begin());
+    std::copy(sequences.begin(), sequences.end(), out.sequences.begin());
+}
+
+}  // namespace openarm::damiao_motor
@@ -29,7 +29,19 @@ Motor::Motor(MotorType motor_type, uint32_t send_can_id, uint32_t recv_can_id)
       state_dq_(0.0),
       state_tau_(0.0),
       state_tmos_(0),
-      state_trotor_(0) {}
+      state_trotor_(0),
+      limits_(get_limit_param(motor_type)),
+      mit_quantization_(make_mit_quantization(limits_)) {
+    params_.fill(-1);
+}
+
+void Motor::set_limits(const LimitParam& limits) {
+    if (!(limits.pMax > 0 && limits.vMax > 0 && limits.tMax > 0)) {
+        throw std::invalid_argument("Motor limits must be positive");
+    }
+    limits_ = limits;
+    mit_quantization_ = make_mit_quantization(limits_);
+}
 
 // Enable methods
 void Motor::set_enabled(bool enable) { this->enabled_ = enable; }
@@ -38,11 +50,14 @@ void Motor::set_enabled(bool enable) { this->enabled_ = enable; }
 // TODO: storing temp params in motor object might not be a good idea
 // also -1 is not a good default value, consider using a different value
 double Motor::get_param(int RID) const {
-    auto it = temp_param_dict_.find(RID);
-    return (it != temp_param_dict_.end()) ? it->second : -1;
+    if (RID < 0 || static_cast<size_t>(RID) >= params_.size()) return -1;
+    return params_[RID];
 }
 
-void Motor::set_temp_param(int RID, int val) { temp_param_dict_[RID] = val; }
+void Motor::set_temp_param(int RID, double val) {
+    if (RID < 0 || static_cast<size_t>(RID) >= params_.size()) return;
+    params_[RID] = val;
+}
 
 // State update methods
 void Motor::update_state(double q, double dq, double tau, int tmos, int trotor) {
@@ -57,6 +72,11 @@ void Motor::set_state_tmos(int tmos) { state_tmos_ = tmos; }
 
 void Motor::set_state_trotor(int trotor) { state_trotor_ = trotor; }
 
+void Motor::set_state_timestamp(int64_t timestamp_ns, int64_t hw_timestamp_ns) {
+    state_timestamp_ns_ = timestamp_ns;
+    state_hw_timestamp_ns_ = hw_timestamp_ns;
+}
+
 // Static methods
 LimitParam Motor::get_limit_param(MotorType motor_type) {
     size_t index = static_cast<size_t>(motor_type);
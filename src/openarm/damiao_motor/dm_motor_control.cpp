@@ -23,73 +23,99 @@ namespace openarm::damiao_motor {
 
 // Command creation methods (return data array, can_id handled externally)
 CANPacket CanPacketEncoder::create_enable_command(const Motor& motor) {
-    return {motor.get_send_can_id(), pack_command_data(0xFC)};
+    return to_can_packet(encode_enable_command(motor));
 }
 
 CANPacket CanPacketEncoder::create_disable_command(const Motor& motor) {
-    return {motor.get_send_can_id(), pack_command_data(0xFD)};
+    return to_can_packet(encode_disable_command(motor));
 }
 
 CANPacket CanPacketEncoder::create_set_zero_command(const Motor& motor) {
-    return {motor.get_send_can_id(), pack_command_data(0xFE)};
+    return to_can_packet(encode_set_zero_command(motor));
 }
 
 CANPacket CanPacketEncoder::create_mit_control_command(const Motor& motor,
                                                        const MITParam& mit_param) {
-    return {motor.get_send_can_id(), pack_mit_control_data(motor.get_motor_type(), mit_param)};
+    return to_can_packet(encode_mit_control_command(motor, mit_param));
 }
 
 CANPacket CanPacketEncoder::create_posvel_control_command(const Motor& motor,
                                                           const PosVelParam& posvel_param) {
+    return to_can_packet(encode_posvel_control_command(motor, posvel_param));
+}
+
+CANPacket CanPacketEncoder::create_query_param_command(const Motor& motor, int RID) {
+    return to_can_packet(encode_query_param_command(motor, RID));
+}
+
+CANPacket CanPacketEncoder::create_refresh_command(const Motor& motor) {
+    return to_can_packet(encode_refresh_command(motor));
+}
+
+CANPacket CanPacketEncoder::to_can_packet(const FixedCANPacket& packet) {
+    return {packet.send_can_id, std::vector<uint8_t>(packet.data.begin(), packet.data.end())};
+}
+
+// Allocation-free command creation methods
+FixedCANPacket CanPacketEncoder::encode_enable_command(const Motor& motor) {
+    return {motor.get_send_can_id(), pack_command_data(0xFC)};
+}
+
+FixedCANPacket CanPacketEncoder::encode_disable_command(const Motor& motor) {
+    return {motor.get_send_can_id(), pack_command_data(0xFD)};
+}
+
+FixedCANPacket CanPacketEncoder::encode_set_zero_command(const Motor& motor) {
+    return {motor.get_send_can_id(), pack_command_data(0xFE)};
+}
+
+FixedCANPacket CanPacketEncoder::encode_mit_control_command(const Motor& motor,
+                                                            const MITParam& mit_param) {
+    return {motor.get_send_can_id(),
+            pack_mit_control_data(motor.get_mit_quantization(), mit_param)};
+}
+
+FixedCANPacket CanPacketEncoder::encode_posvel_control_command(const Motor& motor,
+                                                               const PosVelParam& posvel_param) {
     // pos vel mode needs extra 0x100
     return {motor.get_send_can_id() + 0x100,
             pack_posvel_control_data(motor.get_motor_type(), posvel_param)};
 }
 
-CANPacket CanPacketEncoder::create_query_param_command(const Motor& motor, int RID) {
+FixedCANPacket CanPacketEncoder::encode_query_param_command(const Motor& motor, int RID) {
     return {0x7FF, pack_query_param_data(motor.get_send_can_id(), RID)};
 }
 
-CANPacket CanPacketEncoder::create_refresh_command(const Motor& motor) {
+FixedCANPacket CanPacketEncoder::encode_refresh_command(const Motor& motor) {
     uint8_t send_can_id = motor.get_send_can_id();
-    std::vector<uint8_t> data = {static_cast<uint8_t>(send_can_id & 0xFF),
-                                 static_cast<uint8_t>((send_can_id >> 8) & 0xFF),
-                                 0xCC,
-                                 0x00,
-                                 0x00,
-                                 0x00,
-                                 0x00,
-                                 0x00};
-    return {0x7FF, data};
+    return {0x7FF,
+            {static_cast<uint8_t>(send_can_id & 0xFF),
+             static_cast<uint8_t>((send_can_id >> 8) & 0xFF), 0xCC, 0x00, 0x00, 0x00, 0x00,
+             0x00}};
 }
 
 // Data interpretation methods (use recv_can_id for received data)
 StateResult CanPacketDecoder::parse_motor_state_data(const Motor& motor,
                                                      const std::vector<uint8_t>& data) {
-    if (data.size() < 8) {
+    return parse_motor_state_data(motor, data.data(), data.size());
+}
+
+ParamResult CanPacketDecoder::parse_motor_param_data(const std::vector<uint8_t>& data) {
+    return parse_motor_param_data(data.data(), data.size());
+}
+
+StateResult CanPacketDecoder::parse_motor_state_data(const Motor& motor, const uint8_t* data,
+                                                     size_t len) {
+    if (len < 8) {
         std::cerr << "Warning: Skipping motor state data less than 8 bytes" << std::endl;
         return {0, 0, 0, 0, 0, false};
     }
 
-    // Parse state data
-    uint16_t q_uint = (static_cast<uint16_t>(data[1]) << 8) | data[2];
-    uint16_t dq_uint =
-        (static_cast<uint16_t>(data[3]) << 4) | (static_cast<uint16_t>(data[4]) >> 4);
-    uint16_t tau_uint = (static_cast<uint16_t>(data[4] & 0xf) << 8) | data[5];
-    int t_mos = static_cast<int>(data[6]);
-    int t_rotor = static_cast<int>(data[7]);
-
-    // Convert to physical values
-    LimitParam limits = MOTOR_LIMIT_PARAMS[static_cast<int>(motor.get_motor_type())];
-    double recv_q = CanPacketDecoder::uint_to_double(q_uint, -limits.pMax, limits.pMax, 16);
-    double recv_dq = CanPacketDecoder::uint_to_double(dq_uint, -limits.vMax, limits.vMax, 12);
-    double recv_tau = CanPacketDecoder::uint_to_double(tau_uint, -limits.tMax, limits.tMax, 12);
-
-    return {recv_q, recv_dq, recv_tau, t_mos, t_rotor, true};
+    return decode_state(motor.get_mit_quantization(), data, len);
 }
 
-ParamResult CanPacketDecoder::parse_motor_param_data(const std::vector<uint8_t>& data) {
-    if (data.size() < 8) return {0, NAN, false};
+ParamResult CanPacketDecoder::parse_motor_param_data(const uint8_t* data, size_t len) {
+    if (len < 8) return {0, NAN, false};
 
     if ((data[2] == 0x33 || data[2] == 0x55)) {
         uint8_t RID = data[3];
@@ -108,30 +134,14 @@ ParamResult CanPacketDecoder::parse_motor_param_data(const std::vector<uint8_t>&
 }
 
 // Data packing utility methods
-std::vector<uint8_t> CanPacketEncoder::pack_mit_control_data(MotorType motor_type,
-                                                             const MITParam& mit_param) {
-    uint16_t kp_uint = double_to_uint(mit_param.kp, 0, 500, 12);
-    uint16_t kd_uint = double_to_uint(mit_param.kd, 0, 5, 12);
-
-    // Get motor limits based on type
-    LimitParam limits = MOTOR_LIMIT_PARAMS[static_cast<int>(motor_type)];
-    uint16_t q_uint = double_to_uint(mit_param.q, -(double)limits.pMax, (double)limits.pMax, 16);
-    uint16_t dq_uint = double_to_uint(mit_param.dq, -(double)limits.vMax, (double)limits.vMax, 12);
-    uint16_t tau_uint =
-        double_to_uint(mit_param.tau, -(double)limits.tMax, (double)limits.tMax, 12);
-
-    return {static_cast<uint8_t>((q_uint >> 8) & 0xFF),
-            static_cast<uint8_t>(q_uint & 0xFF),
-            static_cast<uint8_t>(dq_uint >> 4),
-            static_cast<uint8_t>(((dq_uint & 0xF) << 4) | ((kp_uint >> 8) & 0xF)),
-            static_cast<uint8_t>(kp_uint & 0xFF),
-            static_cast<uint8_t>(kd_uint >> 4),
-            static_cast<uint8_t>(((kd_uint & 0xF) << 4) | ((tau_uint >> 8) & 0xF)),
-            static_cast<uint8_t>(tau_uint & 0xFF)};
-}
-
-std::vector<uint8_t> CanPacketEncoder::pack_posvel_control_data(MotorType motor_type,
-                                                                const PosVelParam& posvel_param) {
+std::array<uint8_t, 8> CanPacketEncoder::pack_mit_control_data(MotorType motor_type,
+                                                               const MITParam& mit_param) {
+    // Get motor quantization scales based on type
+    return pack_mit_control_data(MIT_QUANTIZATION[static_cast<int>(motor_type)], mit_param);
+}
+
+std::array<uint8_t, 8> CanPacketEncoder::pack_posvel_control_data(
+    MotorType motor_type, const PosVelParam& posvel_param) {
     double pos = posvel_param.q;
     double vel = posvel_param.dq;
 
@@ -142,7 +152,7 @@ std::vector<uint8_t> CanPacketEncoder::pack_posvel_control_data(MotorType motor_
     return {pb[0], pb[1], pb[2], pb[3], vb[0], vb[1], vb[2], vb[3]};
 }
 
-std::vector<uint8_t> CanPacketEncoder::pack_query_param_data(uint32_t send_can_id, int RID) {
+std::array<uint8_t, 8> CanPacketEncoder::pack_query_param_data(uint32_t send_can_id, int RID) {
     return {static_cast<uint8_t>(send_can_id & 0xFF),
             static_cast<uint8_t>((send_can_id >> 8) & 0xFF),
             0x33,
@@ -153,34 +163,37 @@ std::vector<uint8_t> CanPacketEncoder::pack_query_param_data(uint32_t send_can_i
             0x00};
 }
 
-std::vector<uint8_t> CanPacketEncoder::pack_command_data(uint8_t cmd) {
-    return {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, cmd};
-}
-
-// Utility function implementations
-double CanPacketEncoder::limit_min_max(double x, double min, double max) {
-    return std::max(min, std::min(x, max));
+std::array<uint8_t, 8> CanPacketEncoder::pack_param_reply_data(uint32_t send_can_id,
+                                                               uint8_t command, int RID,
+                                                               double value) {
+    std::array<uint8_t, 4> value_bytes;
+    if (CanPacketDecoder::is_in_ranges(RID)) {
+        uint32_t number = static_cast<uint32_t>(value);
+        std::memcpy(value_bytes.data(), &number, sizeof(number));
+    } else {
+        value_bytes = float_to_uint8s(static_cast<float>(value));
+    }
+    return {static_cast<uint8_t>(send_can_id & 0xFF),
+            static_cast<uint8_t>((send_can_id >> 8) & 0xFF),
+            command,
+            static_cast<uint8_t>(RID),
+            value_bytes[0],
+            value_bytes[1],
+            value_bytes[2],
+            value_bytes[3]};
 }
 
-uint16_t CanPacketEncoder::double_to_uint(double x, double x_min, double x_max, int bits) {
-    x = limit_min_max(x, x_min, x_max);
-    double span = x_max - x_min;
-    double data_norm = (x - x_min) / span;
-    return static_cast<uint16_t>(data_norm * ((1 << bits) - 1));
+std::array<uint8_t, 8> CanPacketEncoder::pack_command_data(uint8_t cmd) {
+    return {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, cmd};
 }
 
+// Utility function implementations
 std::array<uint8_t, 4> CanPacketEncoder::float_to_uint8s(float value) {
     std::array<uint8_t, 4> bytes{};
     std::memcpy(bytes.data(), &value, sizeof(float));
     return bytes;
 }
 
-double CanPacketDecoder::uint_to_double(uint16_t x, double min, double max, int bits) {
-    double span = max - min;
-    double data_norm = static_cast<double>(x) / ((1 << bits) - 1);
-    return data_norm * span + min;
-}
-
 float CanPacketDecoder::uint8s_to_float(const std::array<uint8_t, 4>& bytes) {
     float value;
     std::memcpy(&value, bytes.data(), sizeof(float));
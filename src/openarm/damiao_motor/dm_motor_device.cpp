@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <openarm/damiao_motor/dm_motor.hpp>
@@ -27,34 +29,34 @@ DMCANDevice::DMCANDevice(Motor& motor, canid_t recv_can_mask, bool use_fd)
       callback_mode_(CallbackMode::STATE),
       use_fd_(use_fd) {}
 
-std::vector<uint8_t> DMCANDevice::get_data_from_frame(const can_frame& frame) {
-    return std::vector<uint8_t>(frame.data, frame.data + frame.can_dlc);
-}
+void DMCANDevice::callback(const can_frame& frame) { callback(frame, canbus::CANFrameTimestamp()); }
 
-std::vector<uint8_t> DMCANDevice::get_data_from_frame(const canfd_frame& frame) {
-    return std::vector<uint8_t>(frame.data, frame.data + frame.len);
+void DMCANDevice::callback(const canfd_frame& frame) {
+    callback(frame, canbus::CANFrameTimestamp());
 }
-void DMCANDevice::callback(const can_frame& frame) {
+
+void DMCANDevice::callback(const can_frame& frame, const canbus::CANFrameTimestamp& timestamp) {
     if (use_fd_) {
         std::cerr << "WARNING: WRONG CALLBACK FUNCTION" << std::endl;
         return;
     }
-
-    std::vector<uint8_t> data = get_data_from_frame(frame);
+    record_reply(timestamp);
+    if (try_decode_param_reply(frame.data, frame.can_dlc)) return;
 
     switch (callback_mode_) {
         case STATE:
             if (frame.can_dlc >= 8) {
-                // Convert frame data to vector and let Motor handle parsing
-                StateResult result = CanPacketDecoder::parse_motor_state_data(motor_, data);
+                // Parse straight from the frame payload
+                StateResult result =
+                    CanPacketDecoder::parse_motor_state_data(motor_, frame.data, frame.can_dlc);
                 if (frame.can_id == motor_.get_recv_can_id() && result.valid) {
-                    motor_.update_state(result.position, result.velocity, result.torque,
-                                        result.t_mos, result.t_rotor);
+                    update_state(result, timestamp);
                 }
             }
             break;
         case PARAM: {
-            ParamResult result = CanPacketDecoder::parse_motor_param_data(data);
+            ParamResult result =
+                CanPacketDecoder::parse_motor_param_data(frame.data, frame.can_dlc);
             if (result.valid) {
                 motor_.set_temp_param(result.rid, result.value);
             }
@@ -67,7 +69,8 @@ void DMCANDevice::callback(const can_frame& frame) {
     }
 }
 
-void DMCANDevice::callback(const canfd_frame& frame) {
+void DMCANDevice::callback(const canfd_frame& frame,
+                           const canbus::CANFrameTimestamp& timestamp) {
     if (not use_fd_) {
         std::cerr << "WARNING: CANFD MODE NOT ENABLED" << std::endl;
         return;
@@ -77,16 +80,17 @@ void DMCANDevice::callback(const canfd_frame& frame) {
         std::cerr << "WARNING: CANFD FRAME ID DOES NOT MATCH MOTOR ID" << std::endl;
         return;
     }
+    record_reply(timestamp);
+    if (try_decode_param_reply(frame.data, frame.len)) return;
 
-    std::vector<uint8_t> data = get_data_from_frame(frame);
     if (callback_mode_ == STATE) {
-        StateResult result = CanPacketDecoder::parse_motor_state_data(motor_, data);
+        StateResult result =
+            CanPacketDecoder::parse_motor_state_data(motor_, frame.data, frame.len);
         if (result.valid) {
-            motor_.update_state(result.position, result.velocity, result.torque, result.t_mos,
-                                result.t_rotor);
+            update_state(result, timestamp);
         }
     } else if (callback_mode_ == PARAM) {
-        ParamResult result = CanPacketDecoder::parse_motor_param_data(data);
+        ParamResult result = CanPacketDecoder::parse_motor_param_data(frame.data, frame.len);
         if (result.valid) {
             motor_.set_temp_param(result.rid, result.value);
         }
@@ -95,21 +99,159 @@ void DMCANDevice::callback(const canfd_frame& frame) {
     }
 }
 
-can_frame DMCANDevice::create_can_frame(canid_t send_can_id, std::vector<uint8_t> data) {
+void DMCANDevice::mark_param_query_sent(int rid) {
+    if (rid < 0 || rid >= static_cast<int>(RID::COUNT)) return;
+    outstanding_param_queries_[rid / 64].fetch_or(uint64_t{1} << (rid % 64),
+                                                  std::memory_order_release);
+}
+
+bool DMCANDevice::is_param_query_outstanding(int rid) const {
+    if (rid < 0 || rid >= static_cast<int>(RID::COUNT)) return false;
+    return outstanding_param_queries_[rid / 64].load(std::memory_order_acquire) &
+           (uint64_t{1} << (rid % 64));
+}
+
+void DMCANDevice::cancel_param_query(int rid) {
+    if (rid < 0 || rid >= static_cast<int>(RID::COUNT)) return;
+    outstanding_param_queries_[rid / 64].fetch_and(~(uint64_t{1} << (rid % 64)),
+                                                   std::memory_order_release);
+}
+
+bool DMCANDevice::try_decode_param_reply(const uint8_t* data, size_t len) {
+    // State frames can look like parameter replies, so only take RIDs we asked for, in
+    // replies that carry our CAN ID (CANID_L, CANID_H)
+    if (len < 8 || (data[2] != 0x33 && data[2] != 0x55)) return false;
+    if (static_cast<uint32_t>(data[0] | (data[1] << 8)) != motor_.get_send_can_id()) return false;
+    if (!is_param_query_outstanding(data[3])) return false;
+    ParamResult result = CanPacketDecoder::parse_motor_param_data(data, len);
+    if (!result.valid) return false;
+    motor_.set_temp_param(result.rid, result.value);
+    cancel_param_query(result.rid);
+    return true;
+}
+
+void DMCANDevice::callback_state_payload(const uint8_t* data, size_t len,
+                                         const canbus::CANFrameTimestamp& timestamp) {
+    record_reply(timestamp);
+    if (callback_mode_ != STATE) return;
+    StateResult result = CanPacketDecoder::parse_motor_state_data(motor_, data, len);
+    if (result.valid) update_state(result, timestamp);
+}
+
+namespace {
+int64_t steady_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+}  // namespace
+
+void DMCANDevice::mark_command_sent() {
+    command_sent_ns_.store(steady_clock_ns(), std::memory_order_relaxed);
+}
+
+void DMCANDevice::record_reply(const canbus::CANFrameTimestamp& timestamp) {
+    // The kernel timestamp leaves out the time the frame spent queued on the socket
+    int64_t received_ns = timestamp.software_ns ? timestamp.software_ns : steady_clock_ns();
+    // Only the first reply of a command counts, the compare-exchange makes that safe across
+    // threads. A reply received before the command went out answers an earlier one.
+    int64_t sent_ns = command_sent_ns_.load(std::memory_order_relaxed);
+    do {
+        if (sent_ns == 0 || received_ns < sent_ns) return;
+    } while (!command_sent_ns_.compare_exchange_weak(sent_ns, 0, std::memory_order_relaxed));
+    round_trip_histogram_.record(static_cast<uint64_t>(received_ns - sent_ns));
+}
+
+void DMCANDevice::update_state(const StateResult& result,
+                               const canbus::CANFrameTimestamp& timestamp) {
+    int64_t received_ns = timestamp.software_ns ? timestamp.software_ns : steady_clock_ns();
+    motor_.update_state(result.position, result.velocity, result.torque, result.t_mos,
+                        result.t_rotor);
+    motor_.set_state_timestamp(received_ns, timestamp.hardware_ns);
+    if (joint_state_) {
+        // Seqlock write side, there is only ever one writer (the receiving thread)
+        uint32_t seq = joint_state_seq_.load(std::memory_order_relaxed);
+        joint_state_seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        size_t i = joint_state_index_;
+        joint_state_->positions[i] = result.position;
+        joint_state_->velocities[i] = result.velocity;
+        joint_state_->torques[i] = result.torque;
+        joint_state_->t_mos[i] = result.t_mos;
+        joint_state_->t_rotor[i] = result.t_rotor;
+        joint_state_->timestamps_ns[i] = received_ns;
+        joint_state_->hw_timestamps_ns[i] = timestamp.hardware_ns;
+        joint_state_->sequences[i]++;
+
+        joint_state_seq_.store(seq + 2, std::memory_order_release);
+    }
+}
+
+void DMCANDevice::read_joint_state_slot(JointState& out, size_t out_index) const {
+    if (!joint_state_) return;
+
+    const JointState& in = *joint_state_;
+    size_t i = joint_state_index_;
+    uint32_t seq_begin, seq_end;
+    do {
+        seq_begin = joint_state_seq_.load(std::memory_order_acquire);
+        out.positions[out_index] = in.positions[i];
+        out.velocities[out_index] = in.velocities[i];
+        out.torques[out_index] = in.torques[i];
+        out.t_mos[out_index] = in.t_mos[i];
+        out.t_rotor[out_index] = in.t_rotor[i];
+        out.timestamps_ns[out_index] = in.timestamps_ns[i];
+        out.hw_timestamps_ns[out_index] = in.hw_timestamps_ns[i];
+        out.sequences[out_index] = in.sequences[i];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq_end = joint_state_seq_.load(std::memory_order_relaxed);
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+}
+
+void DMCANDevice::read_joint_state_slot(double& position, double& velocity,
+                                        double& torque) const {
+    if (!joint_state_) return;
+
+    const JointState& in = *joint_state_;
+    size_t i = joint_state_index_;
+    uint32_t seq_begin, seq_end;
+    do {
+        seq_begin = joint_state_seq_.load(std::memory_order_acquire);
+        position = in.positions[i];
+        velocity = in.velocities[i];
+        torque = in.torques[i];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq_end = joint_state_seq_.load(std::memory_order_relaxed);
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+}
+
+can_frame DMCANDevice::create_can_frame(canid_t send_can_id, const std::vector<uint8_t>& data) {
+    return create_can_frame(send_can_id, data.data(), data.size());
+}
+
+canfd_frame DMCANDevice::create_canfd_frame(canid_t send_can_id,
+                                            const std::vector<uint8_t>& data) {
+    return create_canfd_frame(send_can_id, data.data(), data.size());
+}
+
+can_frame DMCANDevice::create_can_frame(canid_t send_can_id, const uint8_t* data, size_t len) {
     can_frame frame;
     std::memset(&frame, 0, sizeof(frame));
     frame.can_id = send_can_id;
-    frame.can_dlc = data.size();
-    std::copy(data.begin(), data.end(), frame.data);
+    frame.can_dlc = std::min(len, sizeof(frame.data));
+    std::memcpy(frame.data, data, frame.can_dlc);
     return frame;
 }
 
-canfd_frame DMCANDevice::create_canfd_frame(canid_t send_can_id, std::vector<uint8_t> data) {
+canfd_frame DMCANDevice::create_canfd_frame(canid_t send_can_id, const uint8_t* data,
+                                            size_t len) {
     canfd_frame frame;
+    std::memset(&frame, 0, sizeof(frame));
     frame.can_id = send_can_id;
-    frame.len = data.size();
+    frame.len = std::min(len, sizeof(frame.data));
     frame.flags = CANFD_BRS;
-    std::copy(data.begin(), data.end(), frame.data);
+    std::memcpy(frame.data, data, frame.len);
     return frame;
 }
 
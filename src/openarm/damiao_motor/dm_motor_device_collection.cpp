@@ -15,110 +15,395 @@
 #include <linux/can.h>
 #include <linux/can/raw.h>
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <openarm/damiao_motor/dm_motor_device_collection.hpp>
+#include <stdexcept>
+#include <string>
 
 namespace openarm::damiao_motor {
 
+namespace {
+// Receives the aggregated state replies of one packed frame
+class DMPackedReplyDevice : public canbus::CANDevice {
+public:
+    DMPackedReplyDevice(DMDeviceCollection& collection, size_t frame_index,
+                        canid_t send_can_id, canid_t recv_can_id)
+        : canbus::CANDevice(send_can_id, recv_can_id, CAN_SFF_MASK, true),
+          collection_(collection),
+          frame_index_(frame_index) {}
+
+    void callback(const can_frame&) override {
+        std::cerr << "WARNING: PACKED REPLY IS NOT A CANFD FRAME" << std::endl;
+    }
+    void callback(const canfd_frame& frame) override {
+        callback(frame, canbus::CANFrameTimestamp());
+    }
+    void callback(const canfd_frame& frame, const canbus::CANFrameTimestamp& timestamp) override {
+        collection_.dispatch_packed_state(frame_index_, frame, timestamp);
+    }
+
+private:
+    DMDeviceCollection& collection_;
+    size_t frame_index_;
+};
+
+// Smallest valid CAN-FD payload length that holds len bytes
+uint8_t canfd_padded_len(size_t len) {
+    if (len <= 8) return len;
+    for (uint8_t valid : {12, 16, 20, 24, 32, 48}) {
+        if (len <= valid) return valid;
+    }
+    return CANFD_MAX_DLEN;
+}
+}  // namespace
+
 DMDeviceCollection::DMDeviceCollection(canbus::CANSocket& can_socket)
     : can_socket_(can_socket),
       can_packet_encoder_(std::make_unique<CanPacketEncoder>()),
       can_packet_decoder_(std::make_unique<CanPacketDecoder>()),
-      device_collection_(std::make_unique<canbus::CANDeviceCollection>(can_socket_)) {}
+      device_collection_(std::make_unique<canbus::CANDeviceCollection>(can_socket_)) {
+    // Also catches devices added or removed through get_device_collection()
+    device_collection_->set_devices_changed_callback([this](canbus::CANDevice* departed) {
+        // The departed device may still get frames through another collection, it must not
+        // write into our joint state anymore
+        if (auto dm_device = dynamic_cast<DMCANDevice*>(departed)) {
+            dm_device->set_joint_state_slot(nullptr, 0);
+        }
+        update_dm_devices();
+    });
+}
+
+void DMDeviceCollection::add_device(const std::shared_ptr<DMCANDevice>& dm_device) {
+    device_collection_->add_device(dm_device);
+}
+
+void DMDeviceCollection::remove_device(const std::shared_ptr<DMCANDevice>& dm_device) {
+    device_collection_->remove_device(dm_device);
+}
+
+// Every command below marks its motor pending before the frame is written, so the
+// pending-since time never lies after the reply
 
 void DMDeviceCollection::enable_all() {
-    for (auto dm_device : get_dm_devices()) {
-        auto& motor = dm_device->get_motor();
-        CANPacket enable_packet = CanPacketEncoder::create_enable_command(motor);
+    canbus::CANSocketBatch batch(can_socket_);
+    clear_pending_replies();
+    for (size_t i = 0; i < dm_devices_.size(); i++) {
+        DMCANDevice& dm_device = *dm_devices_[i];
+        auto enable_packet = CanPacketEncoder::encode_enable_command(dm_device.get_motor());
+        set_pending_reply(i);
         send_command_to_device(dm_device, enable_packet);
+        dm_device.get_motor().set_enabled(true);
     }
 }
 
 void DMDeviceCollection::disable_all() {
-    for (auto dm_device : get_dm_devices()) {
-        CANPacket disable_packet = CanPacketEncoder::create_disable_command(dm_device->get_motor());
+    canbus::CANSocketBatch batch(can_socket_);
+    clear_pending_replies();
+    for (size_t i = 0; i < dm_devices_.size(); i++) {
+        DMCANDevice& dm_device = *dm_devices_[i];
+        auto disable_packet = CanPacketEncoder::encode_disable_command(dm_device.get_motor());
+        set_pending_reply(i);
         send_command_to_device(dm_device, disable_packet);
+        dm_device.get_motor().set_enabled(false);
     }
 }
 
 void DMDeviceCollection::set_zero(int i) {
-    auto dm_device = get_dm_devices().at(i);
-    auto zero_packet = CanPacketEncoder::create_set_zero_command(dm_device->get_motor());
+    DMCANDevice& dm_device = *dm_devices_.at(i);
+    auto zero_packet = CanPacketEncoder::encode_set_zero_command(dm_device.get_motor());
+    set_pending_reply(i);
     send_command_to_device(dm_device, zero_packet);
 }
 
 void DMDeviceCollection::set_zero_all() {
-    for (auto dm_device : get_dm_devices()) {
-        CANPacket zero_packet = CanPacketEncoder::create_set_zero_command(dm_device->get_motor());
-        send_command_to_device(dm_device, zero_packet);
-    }
+    canbus::CANSocketBatch batch(can_socket_);
+    clear_pending_replies();
+    for (size_t i = 0; i < dm_devices_.size(); i++) set_zero(i);
 }
 
 void DMDeviceCollection::refresh_one(int i) {
-    auto dm_device = get_dm_devices().at(i);
-    auto& motor = dm_device->get_motor();
-    CANPacket refresh_packet = CanPacketEncoder::create_refresh_command(motor);
+    DMCANDevice& dm_device = *dm_devices_.at(i);
+    auto refresh_packet = CanPacketEncoder::encode_refresh_command(dm_device.get_motor());
+    set_pending_reply(i);
     send_command_to_device(dm_device, refresh_packet);
 }
 
 void DMDeviceCollection::refresh_all() {
-    for (auto dm_device : get_dm_devices()) {
-        auto& motor = dm_device->get_motor();
-        CANPacket refresh_packet = CanPacketEncoder::create_refresh_command(motor);
-        send_command_to_device(dm_device, refresh_packet);
-    }
+    canbus::CANSocketBatch batch(can_socket_);
+    clear_pending_replies();
+    for (size_t i = 0; i < dm_devices_.size(); i++) refresh_one(i);
 }
 
 void DMDeviceCollection::set_callback_mode_all(CallbackMode callback_mode) {
-    for (auto dm_device : get_dm_devices()) {
+    for (DMCANDevice* dm_device : dm_devices_) {
         dm_device->set_callback_mode(callback_mode);
     }
 }
 
 void DMDeviceCollection::query_param_one(int i, int RID) {
-    CANPacket param_query =
-        CanPacketEncoder::create_query_param_command(get_dm_devices()[i]->get_motor(), RID);
-    send_command_to_device(get_dm_devices()[i], param_query);
+    DMCANDevice& dm_device = *dm_devices_.at(i);
+    auto param_query = CanPacketEncoder::encode_query_param_command(dm_device.get_motor(), RID);
+    set_pending_reply(i);
+    send_command_to_device(dm_device, param_query);
 }
 
 void DMDeviceCollection::query_param_all(int RID) {
-    for (auto dm_device : get_dm_devices()) {
-        CANPacket param_query =
-            CanPacketEncoder::create_query_param_command(dm_device->get_motor(), RID);
-        send_command_to_device(dm_device, param_query);
+    canbus::CANSocketBatch batch(can_socket_);
+    clear_pending_replies();
+    for (size_t i = 0; i < dm_devices_.size(); i++) query_param_one(i, RID);
+}
+
+void DMDeviceCollection::queue_param_queries_all(const std::vector<int>& rids) {
+    cancel_param_queries();
+    failed_param_queries_.clear();
+    for (size_t i = 0; i < param_queries_.size(); i++) queue_param_queries(i, rids);
+}
+
+void DMDeviceCollection::queue_param_queries(int i, const std::vector<int>& rids) {
+    ParamQueryState& state = param_queries_.at(i);
+    for (int rid : rids) {
+        if (rid < 0 || rid >= static_cast<int>(RID::COUNT)) {
+            throw std::invalid_argument("Invalid RID: " + std::to_string(rid));
+        }
+    }
+    state.queued.insert(state.queued.end(), rids.begin(), rids.end());
+}
+
+size_t DMDeviceCollection::pump_param_queries(size_t max_in_flight,
+                                              std::chrono::microseconds timeout,
+                                              int max_attempts) {
+    const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now().time_since_epoch())
+                               .count();
+    const int64_t timeout_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+
+    canbus::CANSocketBatch batch(can_socket_);
+    size_t remaining = 0;
+    for (size_t i = 0; i < dm_devices_.size(); i++) {
+        DMCANDevice& dm_device = *dm_devices_[i];
+        ParamQueryState& state = param_queries_[i];
+        auto send_query = [&](int rid) {
+            // Mark first, the reply may be decoded on another thread before write returns
+            dm_device.mark_param_query_sent(rid);
+            state.sent_ns[rid] = now_ns;
+            state.attempts[rid]++;
+            auto param_query =
+                CanPacketEncoder::encode_query_param_command(dm_device.get_motor(), rid);
+            send_command_to_device(dm_device, param_query);
+        };
+
+        // Retire answered queries, retransmit or give up on the silent ones
+        for (size_t j = 0; j < state.in_flight.size();) {
+            int rid = state.in_flight[j];
+            bool done = !dm_device.is_param_query_outstanding(rid);
+            if (!done && now_ns - state.sent_ns[rid] >= timeout_ns) {
+                if (state.attempts[rid] >= max_attempts) {
+                    dm_device.cancel_param_query(rid);
+                    failed_param_queries_.emplace_back(i, rid);
+                    done = true;
+                } else {
+                    send_query(rid);
+                }
+            }
+            if (done) {
+                state.in_flight[j] = state.in_flight.back();
+                state.in_flight.pop_back();
+            } else {
+                j++;
+            }
+        }
+
+        while (state.in_flight.size() < max_in_flight &&
+               state.next_queued < state.queued.size()) {
+            int rid = state.queued[state.next_queued++];
+            if (std::find(state.in_flight.begin(), state.in_flight.end(), rid) !=
+                state.in_flight.end()) {
+                continue;
+            }
+            state.attempts[rid] = 0;
+            send_query(rid);
+            state.in_flight.push_back(rid);
+        }
+        remaining += state.in_flight.size() + (state.queued.size() - state.next_queued);
     }
+    return remaining;
+}
+
+bool DMDeviceCollection::has_param_queries() const {
+    for (const ParamQueryState& state : param_queries_) {
+        if (!state.in_flight.empty() || state.next_queued < state.queued.size()) return true;
+    }
+    return false;
+}
+
+void DMDeviceCollection::cancel_param_queries() {
+    for (size_t i = 0; i < param_queries_.size(); i++) {
+        ParamQueryState& state = param_queries_[i];
+        for (int rid : state.in_flight) dm_devices_[i]->cancel_param_query(rid);
+        state.in_flight.clear();
+        state.queued.clear();
+        state.next_queued = 0;
+    }
+}
+
+void DMDeviceCollection::send_command_to_device(DMCANDevice& dm_device, const CANPacket& packet) {
+    send_command_to_device(dm_device, packet.send_can_id, packet.data.data(), packet.data.size());
 }
 
-void DMDeviceCollection::send_command_to_device(std::shared_ptr<DMCANDevice> dm_device,
-                                                const CANPacket& packet) {
+void DMDeviceCollection::send_command_to_device(DMCANDevice& dm_device,
+                                                const FixedCANPacket& packet) {
+    send_command_to_device(dm_device, packet.send_can_id, packet.data.data(), packet.data.size());
+}
+
+void DMDeviceCollection::send_command_to_device(DMCANDevice& dm_device, canid_t send_can_id,
+                                                const uint8_t* data, size_t len) {
     if (can_socket_.is_canfd_enabled()) {
-        canfd_frame frame = dm_device->create_canfd_frame(packet.send_can_id, packet.data);
+        canfd_frame frame = dm_device.create_canfd_frame(send_can_id, data, len);
         can_socket_.write_canfd_frame(frame);
     } else {
-        can_frame frame = dm_device->create_can_frame(packet.send_can_id, packet.data);
+        can_frame frame = dm_device.create_can_frame(send_can_id, data, len);
         can_socket_.write_can_frame(frame);
     }
+    dm_device.mark_command_sent();
 }
 
 void DMDeviceCollection::mit_control_one(int i, const MITParam& mit_param) {
-    CANPacket mit_cmd =
-        CanPacketEncoder::create_mit_control_command(get_dm_devices()[i]->get_motor(), mit_param);
-    send_command_to_device(get_dm_devices()[i], mit_cmd);
+    DMCANDevice& dm_device = *dm_devices_.at(i);
+    auto mit_cmd = CanPacketEncoder::encode_mit_control_command(dm_device.get_motor(), mit_param);
+    set_pending_reply(i);
+    send_command_to_device(dm_device, mit_cmd);
 }
 
+namespace {
+void check_command_count(size_t count, size_t motors, const char* kind) {
+    if (count > motors) {
+        throw std::invalid_argument("Got " + std::to_string(count) + " " + kind +
+                                    " commands for " + std::to_string(motors) + " motors");
+    }
+}
+}  // namespace
+
 void DMDeviceCollection::mit_control_all(const std::vector<MITParam>& mit_params) {
+    check_command_count(mit_params.size(), dm_devices_.size(), "MIT");
+    canbus::CANSocketBatch batch(can_socket_);
+    clear_pending_replies();
+    if (framing_mode_ == FramingMode::PACKED) {
+        send_packed_mit_control(mit_params.size(), [&](size_t i) { return mit_params[i]; });
+        return;
+    }
     for (size_t i = 0; i < mit_params.size(); i++) {
         mit_control_one(i, mit_params[i]);
     }
 }
 
+void DMDeviceCollection::mit_control_all(const double* kp, const double* kd, const double* q,
+                                         const double* dq, const double* tau, size_t count) {
+    check_command_count(count, dm_devices_.size(), "MIT");
+    auto get_mit_param = [&](size_t i) { return MITParam{kp[i], kd[i], q[i], dq[i], tau[i]}; };
+
+    canbus::CANSocketBatch batch(can_socket_);
+    clear_pending_replies();
+    if (framing_mode_ == FramingMode::PACKED) {
+        send_packed_mit_control(count, get_mit_param);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        mit_control_one(i, get_mit_param(i));
+    }
+}
+
+template <typename GetMITParam>
+void DMDeviceCollection::send_packed_mit_control(size_t count, GetMITParam get_mit_param) {
+    count = std::min(count, dm_devices_.size());
+    for (size_t base = 0; base < count; base += PACKED_SLOTS_PER_FRAME) {
+        size_t slots = std::min(PACKED_SLOTS_PER_FRAME, count - base);
+        canfd_frame frame;
+        std::memset(&frame, 0, sizeof(frame));
+        frame.can_id = packed_framing_->send_can_id + base / PACKED_SLOTS_PER_FRAME;
+        frame.len = canfd_padded_len(slots * 8);
+        frame.flags = CANFD_BRS;
+        for (size_t slot = 0; slot < slots; slot++) {
+            size_t i = base + slot;
+            auto mit_cmd =
+                CanPacketEncoder::encode_mit_control_command(dm_devices_[i]->get_motor(),
+                                                             get_mit_param(i));
+            std::memcpy(&frame.data[slot * 8], mit_cmd.data.data(), 8);
+        }
+        for (size_t slot = 0; slot < slots; slot++) set_pending_reply(base + slot);
+        can_socket_.write_canfd_frame(frame);
+        for (size_t slot = 0; slot < slots; slot++) dm_devices_[base + slot]->mark_command_sent();
+    }
+}
+
+void DMDeviceCollection::set_packed_framing(const PackedFramingConfig& config) {
+    if (!can_socket_.is_canfd_enabled()) {
+        throw std::invalid_argument("Packed framing needs a CAN-FD socket");
+    }
+    for (const auto& device : packed_reply_devices_) device_collection_->remove_device(device);
+    packed_reply_devices_.clear();
+
+    packed_framing_ = config;
+    size_t frames = (dm_devices_.size() + PACKED_SLOTS_PER_FRAME - 1) / PACKED_SLOTS_PER_FRAME;
+    for (size_t k = 0; k < frames; k++) {
+        auto device = std::make_shared<DMPackedReplyDevice>(*this, k, config.send_can_id + k,
+                                                            config.recv_can_id + k);
+        device_collection_->add_device(device);
+        packed_reply_devices_.push_back(device);
+    }
+}
+
+void DMDeviceCollection::set_framing_mode(FramingMode framing_mode) {
+    if (framing_mode == FramingMode::PACKED && !packed_framing_) {
+        throw std::logic_error("Packed framing is not configured, call set_packed_framing()");
+    }
+    framing_mode_ = framing_mode;
+}
+
+bool DMDeviceCollection::supports_packed_framing() const {
+    if (!packed_framing_ || dm_devices_.empty()) return false;
+    for (DMCANDevice* dm_device : dm_devices_) {
+        // get_param() is -1 until the motor answered the query
+        double sw_ver = dm_device->get_motor().get_param(static_cast<int>(RID::sw_ver));
+        double sub_ver = dm_device->get_motor().get_param(static_cast<int>(RID::sub_ver));
+        if (sw_ver < 0 || sub_ver < 0) return false;
+        if (sw_ver != packed_framing_->min_sw_ver) {
+            if (sw_ver < packed_framing_->min_sw_ver) return false;
+        } else if (sub_ver < packed_framing_->min_sub_ver) {
+            return false;
+        }
+    }
+    return true;
+}
+
+FramingMode DMDeviceCollection::select_framing_mode() {
+    framing_mode_ = supports_packed_framing() ? FramingMode::PACKED : FramingMode::PER_MOTOR;
+    return framing_mode_;
+}
+
+void DMDeviceCollection::dispatch_packed_state(size_t frame_index, const canfd_frame& frame,
+                                               const canbus::CANFrameTimestamp& timestamp) {
+    size_t base = frame_index * PACKED_SLOTS_PER_FRAME;
+    size_t slots = std::min<size_t>(frame.len / 8, PACKED_SLOTS_PER_FRAME);
+    for (size_t slot = 0; slot < slots && base + slot < dm_devices_.size(); slot++) {
+        dm_devices_[base + slot]->callback_state_payload(&frame.data[slot * 8], 8, timestamp);
+    }
+}
+
 void DMDeviceCollection::posvel_control_one(int i, const PosVelParam& posvel_param) {
-    CANPacket posvel_cmd = CanPacketEncoder::create_posvel_control_command(
-        get_dm_devices()[i]->get_motor(), posvel_param);
-    send_command_to_device(get_dm_devices()[i], posvel_cmd);
+    DMCANDevice& dm_device = *dm_devices_.at(i);
+    auto posvel_cmd =
+        CanPacketEncoder::encode_posvel_control_command(dm_device.get_motor(), posvel_param);
+    set_pending_reply(i);
+    send_command_to_device(dm_device, posvel_cmd);
 }
 
 void DMDeviceCollection::posvel_control_all(const std::vector<PosVelParam>& posvel_params) {
+    check_command_count(posvel_params.size(), dm_devices_.size(), "posvel");
+    canbus::CANSocketBatch batch(can_socket_);
+    clear_pending_replies();
     for (size_t i = 0; i < posvel_params.size(); i++) {
         posvel_control_one(i, posvel_params[i]);
     }
@@ -126,23 +411,132 @@ void DMDeviceCollection::posvel_control_all(const std::vector<PosVelParam>& posv
 
 std::vector<Motor> DMDeviceCollection::get_motors() const {
     std::vector<Motor> motors;
-    for (auto dm_device : get_dm_devices()) {
+    motors.reserve(dm_devices_.size());
+    for (DMCANDevice* dm_device : dm_devices_) {
         motors.push_back(dm_device->get_motor());
     }
     return motors;
 }
 
-Motor DMDeviceCollection::get_motor(int i) const { return get_dm_devices().at(i)->get_motor(); }
+Motor DMDeviceCollection::get_motor(int i) const { return dm_devices_.at(i)->get_motor(); }
+
+namespace {
+int64_t steady_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+}  // namespace
+
+void DMDeviceCollection::set_pending_reply(int i, int64_t since_ns) {
+    // The reply to the latest command is the one that counts
+    pending_since_ns_[i] = since_ns;
+    if (!pending_replies_[i]) {
+        pending_replies_[i] = true;
+        pending_reply_count_++;
+    }
+}
+
+void DMDeviceCollection::set_pending_reply(int i) { set_pending_reply(i, steady_clock_ns()); }
 
-std::vector<std::shared_ptr<DMCANDevice>> DMDeviceCollection::get_dm_devices() const {
-    std::vector<std::shared_ptr<DMCANDevice>> dm_devices;
+bool DMDeviceCollection::clear_pending_reply(canid_t recv_can_id, int64_t received_ns) {
+    if (pending_reply_count_ == 0) return false;
+    // A frame received before the command it would match answers an older one
+    auto is_stale = [&](size_t i) {
+        return received_ns != 0 && received_ns < pending_since_ns_[i];
+    };
+
+    // An aggregated reply answers every motor of its packed frame
+    if (framing_mode_ == FramingMode::PACKED && recv_can_id >= packed_framing_->recv_can_id &&
+        recv_can_id < packed_framing_->recv_can_id + packed_reply_devices_.size()) {
+        size_t base = (recv_can_id - packed_framing_->recv_can_id) * PACKED_SLOTS_PER_FRAME;
+        bool cleared = false;
+        for (size_t i = base; i < std::min(base + PACKED_SLOTS_PER_FRAME, dm_devices_.size());
+             i++) {
+            if (!pending_replies_[i] || is_stale(i)) continue;
+            pending_replies_[i] = false;
+            pending_reply_count_--;
+            cleared = true;
+        }
+        return cleared;
+    }
+
+    for (size_t i = 0; i < dm_devices_.size(); i++) {
+        if (dm_devices_[i]->get_recv_can_id() != recv_can_id) continue;
+        if (!pending_replies_[i] || is_stale(i)) return false;
+        pending_replies_[i] = false;
+        pending_reply_count_--;
+        return true;
+    }
+    return false;
+}
+
+void DMDeviceCollection::clear_pending_replies() {
+    std::fill(pending_replies_.begin(), pending_replies_.end(), false);
+    pending_reply_count_ = 0;
+}
+
+void DMDeviceCollection::set_pending_replies_all() {
+    // Whatever is queued already counts, there is no command to be older than
+    for (size_t i = 0; i < dm_devices_.size(); i++) set_pending_reply(i, 0);
+}
+
+void DMDeviceCollection::restamp_pending_replies() {
+    if (pending_reply_count_ == 0) return;
+    int64_t now_ns = steady_clock_ns();
+    for (size_t i = 0; i < dm_devices_.size(); i++) {
+        if (!pending_replies_[i]) continue;
+        pending_since_ns_[i] = now_ns;
+        dm_devices_[i]->mark_command_sent();
+    }
+}
+
+std::vector<int> DMDeviceCollection::get_pending_replies() const {
+    std::vector<int> pending;
+    for (size_t i = 0; i < pending_replies_.size(); i++) {
+        if (pending_replies_[i]) pending.push_back(i);
+    }
+    return pending;
+}
+
+void DMDeviceCollection::update_dm_devices() {
+    // Keep the recv_can_id order of the underlying collection so indices stay stable
+    dm_devices_.clear();
     for (const auto& [id, device] : device_collection_->get_devices()) {
-        auto dm_device = std::dynamic_pointer_cast<DMCANDevice>(device);
+        auto dm_device = dynamic_cast<DMCANDevice*>(device.get());
         if (dm_device) {
-            dm_devices.push_back(dm_device);
+            dm_devices_.push_back(dm_device);
         }
     }
-    return dm_devices;
+    clear_pending_replies();
+    pending_replies_.resize(dm_devices_.size(), false);
+    pending_since_ns_.resize(dm_devices_.size(), 0);
+    param_queries_.clear();
+    param_queries_.resize(dm_devices_.size());
+
+    joint_state_.resize(dm_devices_.size());
+    for (size_t i = 0; i < dm_devices_.size(); i++) {
+        dm_devices_[i]->set_joint_state_slot(&joint_state_, i);
+    }
+}
+
+void DMDeviceCollection::read_state(JointState& out) const {
+    out.resize(dm_devices_.size());
+    for (size_t i = 0; i < dm_devices_.size(); i++) {
+        dm_devices_[i]->read_joint_state_slot(out, i);
+    }
+}
+
+void DMDeviceCollection::read_state(double* positions, double* velocities, double* torques,
+                                    size_t count) const {
+    if (count > dm_devices_.size()) {
+        throw std::invalid_argument("Got buffers for " + std::to_string(count) +
+                                    " joints but only " + std::to_string(dm_devices_.size()) +
+                                    " motors");
+    }
+    for (size_t i = 0; i < count; i++) {
+        dm_devices_[i]->read_joint_state_slot(positions[i], velocities[i], torques[i]);
+    }
 }
 
 }  // namespace openarm::damiao_motor
@@ -0,0 +1,384 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <openarm/canbus/can_socket.hpp>
+#include <openarm/damiao_motor/dm_motor_simulator.hpp>
+#include <stdexcept>
+
+namespace openarm::damiao_motor {
+
+namespace {
+int64_t steady_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+bool is_special_command(const uint8_t* data) {
+    return std::all_of(data, data + 7, [](uint8_t byte) { return byte == 0xFF; });
+}
+}  // namespace
+
+DMMotorSimulator::DMMotorSimulator(const std::vector<DMSimulatedMotorConfig>& motors,
+                                   const DMMotorSimulatorConfig& config)
+    : config_(config), rng_(config.seed) {
+    if (config.reply_loss < 0.0 || config.reply_loss > 1.0) {
+        throw std::invalid_argument("reply_loss must be within [0, 1]");
+    }
+    if (config.joint_inertia < 0.0 || config.dynamics_step.count() <= 0) {
+        throw std::invalid_argument("Invalid simulated joint dynamics");
+    }
+    for (const DMSimulatedMotorConfig& motor_config : motors) {
+        if (!motor_index_.emplace(motor_config.send_can_id, motors_.size()).second) {
+            throw std::invalid_argument("Duplicate simulated motor send_can_id " +
+                                        std::to_string(motor_config.send_can_id));
+        }
+        SimulatedMotor motor;
+        motor.config = motor_config;
+        motor.params.fill(0.0);
+        const LimitParam& limits =
+            MOTOR_LIMIT_PARAMS[static_cast<size_t>(motor_config.motor_type)];
+        motor.params[static_cast<size_t>(RID::PMAX)] = limits.pMax;
+        motor.params[static_cast<size_t>(RID::VMAX)] = limits.vMax;
+        motor.params[static_cast<size_t>(RID::TMAX)] = limits.tMax;
+        motor.params[static_cast<size_t>(RID::MST_ID)] = motor_config.recv_can_id;
+        motor.params[static_cast<size_t>(RID::ESC_ID)] = motor_config.send_can_id;
+        motor.params[static_cast<size_t>(RID::CTRL_MODE)] = static_cast<int>(ControlMode::MIT);
+        motor.params[static_cast<size_t>(RID::SN)] = 1000 + motors_.size();
+        motors_.push_back(motor);
+    }
+    pending_.reserve(1024);
+
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ < 0) {
+        throw canbus::CANSocketException(std::string("Failed to create timerfd: ") +
+                                         strerror(errno));
+    }
+}
+
+DMMotorSimulator::~DMMotorSimulator() {
+    if (timer_fd_ >= 0) close(timer_fd_);
+}
+
+bool DMMotorSimulator::later(const PendingReply& a, const PendingReply& b) {
+    if (a.ready_ns != b.ready_ns) return a.ready_ns > b.ready_ns;
+    return a.sequence > b.sequence;
+}
+
+size_t DMMotorSimulator::send(const can_frame* frames, size_t count) {
+    return send_frames(frames, count);
+}
+
+size_t DMMotorSimulator::send(const canfd_frame* frames, size_t count) {
+    return send_frames(frames, count);
+}
+
+int DMMotorSimulator::try_send(const canbus::TxFrame* frames, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (frames[i].size == CANFD_MTU) {
+            send_frames(&frames[i].frame, 1);
+        } else {
+            send_frames(reinterpret_cast<const can_frame*>(&frames[i].frame), 1);
+        }
+    }
+    return static_cast<int>(count);
+}
+
+template <typename Frame>
+size_t DMMotorSimulator::send_frames(const Frame* frames, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t now_ns = steady_clock_ns();
+    // The host frames of one batch are queued together and win arbitration against the
+    // motor replies (lower IDs), so put all of them on the bus before any reply
+    batch_end_ns_.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        int64_t duration_ns;
+        if constexpr (sizeof(Frame) == CANFD_MTU) {
+            duration_ns =
+                canbus::frame_duration_ns(frames[i], config_.bitrate, config_.data_bitrate);
+        } else {
+            duration_ns = canbus::frame_duration_ns(frames[i], config_.bitrate);
+        }
+        bus_free_ns_ = std::max(bus_free_ns_, now_ns) + duration_ns;
+        batch_end_ns_[i] = bus_free_ns_;
+    }
+    const int64_t latency_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(config_.reply_latency).count();
+    for (size_t i = 0; i < count; i++) {
+        const Frame& frame = frames[i];
+        size_t len;
+        if constexpr (sizeof(Frame) == CANFD_MTU) {
+            len = frame.len;
+        } else {
+            len = frame.can_dlc;
+        }
+        handle_frame(frame.can_id, frame.data, len, batch_end_ns_[i] + latency_ns);
+    }
+    arm_timer();
+    return count;
+}
+
+DMMotorSimulator::SimulatedMotor* DMMotorSimulator::find_motor(uint32_t send_can_id) {
+    auto it = motor_index_.find(send_can_id);
+    return it == motor_index_.end() ? nullptr : &motors_[it->second];
+}
+
+void DMMotorSimulator::handle_frame(uint32_t can_id, const uint8_t* data, size_t len,
+                                    int64_t ready_ns) {
+    if (len < 8) return;
+
+    if (can_id == 0x7FF) {
+        // Broadcast ID: refresh and parameter access, addressed by send_can_id in bytes 0-1
+        SimulatedMotor* motor = find_motor(data[0] | (static_cast<uint32_t>(data[1]) << 8));
+        if (!motor) return;
+        motor->state.commands++;
+        stats_.commands++;
+        uint8_t command = data[2];
+        int rid = data[3];
+        if (command == 0xCC) {
+            advance(*motor, ready_ns);
+            queue_state_reply(*motor, ready_ns);
+        } else if ((command == 0x33 || command == 0x55) && rid < static_cast<int>(RID::COUNT)) {
+            if (command == 0x55) {
+                if (CanPacketDecoder::is_in_ranges(rid)) {
+                    uint32_t value;
+                    memcpy(&value, data + 4, sizeof(value));
+                    motor->params[rid] = value;
+                } else {
+                    float value;
+                    memcpy(&value, data + 4, sizeof(value));
+                    motor->params[rid] = value;
+                }
+            }
+            queue_reply(motor->config.recv_can_id,
+                        CanPacketEncoder::pack_param_reply_data(motor->config.send_can_id,
+                                                                command, rid, motor->params[rid]),
+                        ready_ns);
+        }
+        return;
+    }
+
+    if (SimulatedMotor* motor = find_motor(can_id)) {
+        motor->state.commands++;
+        stats_.commands++;
+        advance(*motor, ready_ns);
+        if (is_special_command(data)) {
+            if (data[7] == 0xFC) {
+                motor->state.enabled = true;
+            } else if (data[7] == 0xFD) {
+                motor->state.enabled = false;
+                motor->state.velocity = 0.0;
+                motor->state.torque = 0.0;
+                motor->command = MITParam{0, 0, 0, 0, 0};
+            } else if (data[7] == 0xFE) {
+                motor->state.position = 0.0;
+            }
+        } else if (motor->state.enabled) {
+            MITParam command = CanPacketDecoder::parse_mit_control_data(
+                MIT_QUANTIZATION[static_cast<size_t>(motor->config.motor_type)], data);
+            motor->command = command;
+            if (config_.joint_inertia == 0.0) {
+                if (command.kp > 0) motor->state.position = command.q;
+                motor->state.velocity = command.dq;
+                motor->state.torque = command.tau;
+            }
+        }
+        queue_state_reply(*motor, ready_ns);
+        return;
+    }
+
+    // Position-velocity mode uses send_can_id + 0x100
+    if (SimulatedMotor* motor = find_motor(can_id - 0x100)) {
+        motor->state.commands++;
+        stats_.commands++;
+        advance(*motor, ready_ns);
+        if (motor->state.enabled) {
+            PosVelParam command = CanPacketDecoder::parse_posvel_control_data(data);
+            motor->state.position = command.q;
+            motor->state.velocity = 0.0;
+            motor->command = MITParam{0, 0, command.q, 0, 0};
+        }
+        queue_state_reply(*motor, ready_ns);
+    }
+}
+
+void DMMotorSimulator::advance(SimulatedMotor& motor, int64_t now_ns) {
+    if (now_ns <= motor.updated_ns) return;
+    if (motor.updated_ns != 0 && motor.state.enabled) {
+        // Joints settle long before a second passes without commands
+        double dt = std::min((now_ns - motor.updated_ns) * 1e-9, 1.0);
+        if (config_.joint_inertia > 0.0) {
+            double step = config_.dynamics_step.count() * 1e-6;
+            for (; dt > step; dt -= step) integrate(motor, step);
+            integrate(motor, dt);
+        } else {
+            double p_max = MOTOR_LIMIT_PARAMS[static_cast<size_t>(motor.config.motor_type)].pMax;
+            motor.state.position =
+                std::clamp(motor.state.position + motor.state.velocity * dt, -p_max, p_max);
+        }
+    }
+    motor.updated_ns = now_ns;
+}
+
+void DMMotorSimulator::integrate(SimulatedMotor& motor, double dt) {
+    const LimitParam& limits = MOTOR_LIMIT_PARAMS[static_cast<size_t>(motor.config.motor_type)];
+    const MITParam& command = motor.command;
+    DMSimulatedMotorState& state = motor.state;
+    double torque = command.tau + command.kp * (command.q - state.position) +
+                    command.kd * (command.dq - state.velocity);
+    state.torque = std::clamp(torque, -limits.tMax, limits.tMax);
+    double acceleration =
+        (state.torque - config_.joint_damping * state.velocity) / config_.joint_inertia;
+    // Semi-implicit Euler stays stable for the stiff gains MIT control allows
+    state.velocity = std::clamp(state.velocity + acceleration * dt, -limits.vMax, limits.vMax);
+    state.position = std::clamp(state.position + state.velocity * dt, -limits.pMax, limits.pMax);
+}
+
+bool DMMotorSimulator::reply_ready_ns(int64_t& ready_ns) {
+    if (config_.reply_loss > 0.0 &&
+        std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < config_.reply_loss) {
+        stats_.lost_replies++;
+        return false;
+    }
+    if (config_.reply_jitter.count() > 0) {
+        int64_t jitter_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(config_.reply_jitter).count();
+        ready_ns += std::uniform_int_distribution<int64_t>(0, jitter_ns)(rng_);
+    }
+    stats_.replies++;
+    return true;
+}
+
+void DMMotorSimulator::queue_state_reply(const SimulatedMotor& motor, int64_t ready_ns) {
+    const DMSimulatedMotorState& state = motor.state;
+    StateResult result{state.position, state.velocity, state.torque,
+                       state.t_mos,    state.t_rotor,  true};
+    queue_reply(motor.config.recv_can_id,
+                CanPacketEncoder::pack_state_data(
+                    MIT_QUANTIZATION[static_cast<size_t>(motor.config.motor_type)],
+                    state.enabled ? 1 : 0, motor.config.send_can_id, result),
+                ready_ns);
+}
+
+void DMMotorSimulator::queue_reply(uint32_t can_id, const std::array<uint8_t, 8>& data,
+                                   int64_t ready_ns) {
+    if (!reply_ready_ns(ready_ns)) return;
+    PendingReply reply;
+    memset(&reply.frame, 0, sizeof(reply.frame));
+    reply.frame.can_id = can_id;
+    reply.frame.len = data.size();
+    memcpy(reply.frame.data, data.data(), data.size());
+    int64_t duration_ns;
+    if (config_.enable_fd) {
+        reply.size = CANFD_MTU;
+        duration_ns = canbus::frame_duration_ns(reply.frame, config_.bitrate, config_.data_bitrate);
+    } else {
+        // can_frame is a prefix of canfd_frame, len and can_dlc share a byte
+        reply.size = CAN_MTU;
+        duration_ns = canbus::frame_duration_ns(reinterpret_cast<const can_frame&>(reply.frame),
+                                                config_.bitrate);
+    }
+    // The reply waits for the bus like any other frame
+    bus_free_ns_ = std::max(bus_free_ns_, ready_ns) + duration_ns;
+    reply.ready_ns = bus_free_ns_;
+    reply.sequence = next_sequence_++;
+    pending_.push_back(reply);
+    std::push_heap(pending_.begin(), pending_.end(), later);
+}
+
+size_t DMMotorSimulator::receive(can_frame* frames, canbus::CANFrameTimestamp* timestamps,
+                                 size_t max_count, canbus::CANReceiveInfo& info) {
+    return receive_frames(frames, timestamps, max_count, info);
+}
+
+size_t DMMotorSimulator::receive(canfd_frame* frames, canbus::CANFrameTimestamp* timestamps,
+                                 size_t max_count, canbus::CANReceiveInfo& info) {
+    return receive_frames(frames, timestamps, max_count, info);
+}
+
+template <typename Frame>
+size_t DMMotorSimulator::receive_frames(Frame* frames, canbus::CANFrameTimestamp* timestamps,
+                                        size_t max_count, canbus::CANReceiveInfo& info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t now_ns = steady_clock_ns();
+    size_t received = 0;
+    while (received < max_count && !pending_.empty() && pending_.front().ready_ns <= now_ns) {
+        std::pop_heap(pending_.begin(), pending_.end(), later);
+        const PendingReply& reply = pending_.back();
+        if (reply.size == sizeof(Frame)) {
+            memcpy(&frames[received], &reply.frame, sizeof(Frame));
+            if (timestamps) {
+                timestamps[received] = canbus::CANFrameTimestamp();
+                if (timestamping_) timestamps[received].software_ns = reply.ready_ns;
+            }
+            received++;
+        } else {
+            info.malformed_frames++;
+        }
+        pending_.pop_back();
+    }
+    arm_timer();
+    return received;
+}
+
+void DMMotorSimulator::arm_timer() {
+    // Re-arming also resets the expiration count, so the fd is only readable while a reply
+    // is due
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (!pending_.empty()) {
+        int64_t ready_ns = std::max<int64_t>(pending_.front().ready_ns, 1);
+        spec.it_value.tv_sec = ready_ns / 1000000000;
+        spec.it_value.tv_nsec = ready_ns % 1000000000;
+    }
+    timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+bool DMMotorSimulator::enable_timestamping(canbus::TimestampMode mode) {
+    if (mode == canbus::TimestampMode::HARDWARE) return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    timestamping_ = mode == canbus::TimestampMode::SOFTWARE;
+    return true;
+}
+
+DMSimulatedMotorState DMMotorSimulator::get_motor_state(size_t i) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return motors_.at(i).state;
+}
+
+void DMMotorSimulator::set_param(size_t i, int rid, double value) {
+    if (rid < 0 || rid >= static_cast<int>(RID::COUNT)) {
+        throw std::invalid_argument("Invalid RID " + std::to_string(rid));
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    motors_.at(i).params[rid] = value;
+}
+
+size_t DMMotorSimulator::pending_replies() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+DMMotorSimulatorStats DMMotorSimulator::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+}  // namespace openarm::damiao_motor
@@ -0,0 +1,106 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The steady-state control path must not touch the heap: encoding commands, sending them,
+// and receiving and dispatching the replies.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <openarm/can/socket/openarm.hpp>
+#include <openarm/damiao_motor/dm_motor_control.hpp>
+#include <openarm/damiao_motor/dm_motor_simulator.hpp>
+#include <vector>
+
+#include "allocation_counter.hpp"
+
+namespace {
+
+using namespace openarm::damiao_motor;
+using openarm::can::socket::OpenArm;
+using openarm::test::allocation_count;
+
+constexpr size_t kMotorCount = 7;
+
+class AllocationTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::vector<DMSimulatedMotorConfig> motors;
+        std::vector<MotorType> motor_types;
+        std::vector<uint32_t> send_can_ids, recv_can_ids;
+        for (uint32_t i = 0; i < kMotorCount; i++) {
+            MotorType motor_type = i < 2 ? MotorType::DM8009 : MotorType::DM4310;
+            motors.push_back({motor_type, 0x01 + i, 0x11 + i});
+            motor_types.push_back(motor_type);
+            send_can_ids.push_back(0x01 + i);
+            recv_can_ids.push_back(0x11 + i);
+        }
+        openarm_ = std::make_unique<OpenArm>(std::make_unique<DMMotorSimulator>(motors));
+        openarm_->init_arm_motors(motor_types, send_can_ids, recv_can_ids);
+        openarm_->enable_all();
+        openarm_->recv_all(5000);
+    }
+
+    // One control cycle through the structure-of-arrays API
+    void cycle() {
+        openarm_->get_arm().mit_control_all(kp_.data(), kd_.data(), q_.data(), dq_.data(),
+                                            tau_.data(), kMotorCount);
+        openarm_->recv_all(5000);
+    }
+
+    std::unique_ptr<OpenArm> openarm_;
+    std::vector<double> kp_ = std::vector<double>(kMotorCount, 20.0);
+    std::vector<double> kd_ = std::vector<double>(kMotorCount, 1.0);
+    std::vector<double> q_ = std::vector<double>(kMotorCount, 0.1);
+    std::vector<double> dq_ = std::vector<double>(kMotorCount, 0.0);
+    std::vector<double> tau_ = std::vector<double>(kMotorCount, 0.0);
+};
+
+TEST_F(AllocationTest, MITControlCycleDoesNotAllocate) {
+    for (int i = 0; i < 20; i++) cycle();
+
+    uint64_t start = allocation_count();
+    for (int i = 0; i < 200; i++) cycle();
+    EXPECT_EQ(allocation_count() - start, 0u);
+    EXPECT_FALSE(openarm_->has_pending_replies());
+}
+
+TEST_F(AllocationTest, DispatchDoesNotAllocate) {
+    // State replies as the motors would send them, dispatched straight to the devices
+    std::vector<can_frame> frames(kMotorCount);
+    const auto& motors = openarm_->get_arm().get_motors();
+    for (size_t i = 0; i < kMotorCount; i++) {
+        const Motor& motor = motors[i];
+        auto data = CanPacketEncoder::pack_state_data(
+            MIT_QUANTIZATION[static_cast<size_t>(motor.get_motor_type())], 1,
+            motor.get_send_can_id(), {0.5, 0.0, 0.0, 30, 30, true});
+        frames[i].can_id = motor.get_recv_can_id();
+        frames[i].can_dlc = 8;
+        std::copy(data.begin(), data.end(), frames[i].data);
+    }
+    auto& collection = openarm_->get_master_can_device_collection();
+
+    size_t dispatched = 0;
+    uint64_t start = allocation_count();
+    for (int i = 0; i < 100; i++) {
+        for (can_frame& frame : frames) dispatched += collection.dispatch_frame_callback(frame);
+    }
+    EXPECT_EQ(allocation_count() - start, 0u);
+    EXPECT_EQ(dispatched, 100 * kMotorCount);
+    EXPECT_DOUBLE_EQ(openarm_->get_arm().get_motors()[0].get_position(),
+                     CanPacketDecoder::parse_motor_state_data(motors[0], frames[0].data, 8)
+                         .position);
+}
+
+}  // namespace
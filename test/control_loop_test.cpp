@@ -0,0 +1,158 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// ControlLoop on a simulated bus
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <openarm/can/socket/control_loop.hpp>
+#include <openarm/can/socket/openarm.hpp>
+#include <openarm/damiao_motor/dm_motor_simulator.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace openarm::damiao_motor;
+using openarm::can::socket::ControlLoop;
+using openarm::can::socket::ControlLoopConfig;
+using openarm::can::socket::ControlTick;
+using openarm::can::socket::OpenArm;
+
+constexpr size_t kMotorCount = 2;
+
+class ControlLoopTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        openarm_ = std::make_unique<OpenArm>(std::make_unique<DMMotorSimulator>(
+            std::vector<DMSimulatedMotorConfig>{{MotorType::DM4310, 0x01, 0x11},
+                                                {MotorType::DM4310, 0x02, 0x12}}));
+        openarm_->init_arm_motors({MotorType::DM4310, MotorType::DM4310}, {0x01, 0x02},
+                                  {0x11, 0x12});
+        openarm_->enable_all();
+        openarm_->recv_all(5000);
+        config_.period = std::chrono::milliseconds(2);
+        config_.rx_timeout = std::chrono::microseconds(1500);
+    }
+
+    std::unique_ptr<OpenArm> openarm_;
+    ControlLoopConfig config_;
+};
+
+TEST_F(ControlLoopTest, TicksOnAFixedSchedule) {
+    ControlLoop loop(*openarm_, config_);
+    std::vector<ControlTick> ticks;
+    auto start = std::chrono::steady_clock::now();
+    loop.run([&](const ControlTick& tick) {
+        ticks.push_back(tick);
+        return ticks.size() < 20;
+    });
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_EQ(ticks.size(), 20u);
+    EXPECT_EQ(loop.get_stats().ticks, 20u);
+    EXPECT_GE(elapsed, 19 * config_.period);
+    for (size_t i = 1; i < ticks.size(); i++) {
+        EXPECT_EQ(ticks[i].index, i);
+        // Absolute schedule: ticks are a multiple of the period apart, never drifting
+        int64_t spacing_ns = ticks[i].scheduled_ns - ticks[i - 1].scheduled_ns;
+        EXPECT_EQ(spacing_ns % config_.period.count(), 0);
+        EXPECT_GE(ticks[i].wakeup_ns, ticks[i].scheduled_ns);
+    }
+    EXPECT_FALSE(loop.is_running());
+}
+
+TEST_F(ControlLoopTest, CommandsGoOutOnTheNextTick) {
+    ControlLoop loop(*openarm_, config_);
+    std::vector<MITParam> mit_params(kMotorCount, MITParam{10.0, 1.0, 0.3, 0.0, 0.0});
+    std::vector<double> positions;
+    size_t timed_out = 0;
+    loop.run([&](const ControlTick& tick) {
+        timed_out += tick.timed_out.size();
+        positions.push_back(loop.get_arm_state().positions[0]);
+        openarm_->get_arm().mit_control_all(mit_params);
+        return tick.index < 5;
+    });
+
+    ASSERT_EQ(positions.size(), 6u);
+    // Tick 0 queues the first command, tick 1 receives its reply
+    EXPECT_NEAR(positions[0], 0.0, 1e-3);
+    for (size_t i = 1; i < positions.size(); i++) EXPECT_NEAR(positions[i], 0.3, 1e-3);
+    EXPECT_EQ(timed_out, 0u);
+    EXPECT_EQ(loop.get_stats().rx_timeouts, 0u);
+}
+
+TEST_F(ControlLoopTest, RepliesAreTimedFromTheSend) {
+    // The commands wait a whole period in the batch before they go out
+    config_.period = std::chrono::milliseconds(5);
+    config_.rx_timeout = std::chrono::milliseconds(2);
+    ControlLoop loop(*openarm_, config_);
+    openarm_->reset_stats();
+    std::vector<MITParam> mit_params(kMotorCount, MITParam{10.0, 1.0, 0.0, 0.0, 0.0});
+    loop.run([&](const ControlTick& tick) {
+        openarm_->get_arm().mit_control_all(mit_params);
+        return tick.index < 10;
+    });
+
+    EXPECT_EQ(loop.get_stats().rx_timeouts, 0u);
+    for (const auto& motor : openarm_->get_stats().motors) {
+        EXPECT_GE(motor.round_trip.count, 10u);
+        EXPECT_LT(motor.round_trip.max_ns, 2000000u);
+    }
+}
+
+TEST_F(ControlLoopTest, IdleTicksExpectNoReplies) {
+    ControlLoop loop(*openarm_, config_);
+    openarm_->reset_stats();
+    size_t timed_out = 0;
+    loop.run([&](const ControlTick& tick) {
+        timed_out += tick.timed_out.size();
+        return tick.index < 10;
+    });
+    EXPECT_EQ(timed_out, 0u);
+    EXPECT_EQ(loop.get_stats().rx_timeouts, 0u);
+    // Draining the socket never waits for, or expires, a reply
+    EXPECT_EQ(openarm_->get_stats().recv_all.count, 0u);
+    EXPECT_FALSE(openarm_->has_pending_replies());
+}
+
+TEST_F(ControlLoopTest, StopsFromAnotherThread) {
+    ControlLoop loop(*openarm_, config_);
+    std::thread stopper([&] {
+        while (!loop.is_running()) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        loop.stop();
+    });
+    loop.run([](const ControlTick&) { return true; });
+    stopper.join();
+    EXPECT_GT(loop.get_stats().ticks, 0u);
+    EXPECT_FALSE(loop.is_running());
+}
+
+TEST_F(ControlLoopTest, RejectsInvalidUse) {
+    config_.period = std::chrono::nanoseconds(0);
+    EXPECT_THROW(ControlLoop(*openarm_, config_), std::invalid_argument);
+
+    config_.period = std::chrono::milliseconds(1);
+    ControlLoop loop(*openarm_, config_);
+    EXPECT_THROW(loop.run([&](const ControlTick&) {
+        loop.run([](const ControlTick&) { return false; });
+        return false;
+    }),
+                 std::logic_error);
+    EXPECT_FALSE(loop.is_running());
+}
+
+}  // namespace
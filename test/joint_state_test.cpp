@@ -0,0 +1,164 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Structure-of-arrays joint state decoded from state frames, and the seqlocks between the
+// thread decoding frames and the threads reading or commanding joints
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <openarm/can/socket/command_slots.hpp>
+#include <openarm/can/socket/openarm.hpp>
+#include <openarm/damiao_motor/dm_motor_control.hpp>
+#include <openarm/damiao_motor/dm_motor_simulator.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace openarm::damiao_motor;
+using openarm::can::socket::CommandSlots;
+using openarm::can::socket::OpenArm;
+
+constexpr size_t kMotorCount = 4;
+
+std::unique_ptr<OpenArm> make_openarm() {
+    std::vector<DMSimulatedMotorConfig> motors;
+    std::vector<MotorType> motor_types;
+    std::vector<uint32_t> send_can_ids, recv_can_ids;
+    for (uint32_t i = 0; i < kMotorCount; i++) {
+        motors.push_back({MotorType::DM4310, 0x01 + i, 0x11 + i});
+        motor_types.push_back(MotorType::DM4310);
+        send_can_ids.push_back(0x01 + i);
+        recv_can_ids.push_back(0x11 + i);
+    }
+    auto openarm = std::make_unique<OpenArm>(std::make_unique<DMMotorSimulator>(motors));
+    openarm->init_arm_motors(motor_types, send_can_ids, recv_can_ids);
+    return openarm;
+}
+
+// State reply of every motor with position, velocity and torque at fraction of full scale
+std::vector<can_frame> make_state_frames(double fraction) {
+    const LimitParam& limits = MOTOR_LIMIT_PARAMS[static_cast<size_t>(MotorType::DM4310)];
+    std::vector<can_frame> frames(kMotorCount);
+    for (uint32_t i = 0; i < kMotorCount; i++) {
+        auto data = CanPacketEncoder::pack_state_data(
+            MIT_QUANTIZATION[static_cast<size_t>(MotorType::DM4310)], 1, 0x01 + i,
+            {fraction * limits.pMax, fraction * limits.vMax, fraction * limits.tMax, 30, 30,
+             true});
+        frames[i].can_id = 0x11 + i;
+        frames[i].can_dlc = 8;
+        std::copy(data.begin(), data.end(), frames[i].data);
+    }
+    return frames;
+}
+
+TEST(JointStateTest, ReadStateReturnsTheDecodedState) {
+    auto openarm = make_openarm();
+    auto frames = make_state_frames(0.5);
+    for (can_frame& frame : frames) {
+        openarm->get_master_can_device_collection().dispatch_frame_callback(frame);
+    }
+
+    JointState state;
+    openarm->get_arm().read_state(state);
+    ASSERT_EQ(state.positions.size(), kMotorCount);
+    for (size_t i = 0; i < kMotorCount; i++) {
+        EXPECT_NEAR(state.positions[i], 6.25, 1e-3);
+        EXPECT_NEAR(state.velocities[i], 15.0, 1e-2);
+        EXPECT_NEAR(state.torques[i], 5.0, 1e-2);
+        EXPECT_EQ(state.sequences[i], 1u);
+        EXPECT_NE(state.timestamps_ns[i], 0);
+    }
+}
+
+TEST(JointStateTest, ReaderNeverSeesATornJoint) {
+    auto openarm = make_openarm();
+    auto positive = make_state_frames(0.5);
+    auto negative = make_state_frames(-0.5);
+
+    // Decoding thread alternates between two states; a torn read would mix their signs
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        auto& collection = openarm->get_master_can_device_collection();
+        for (bool flip = false; !stop.load(std::memory_order_relaxed); flip = !flip) {
+            for (can_frame& frame : flip ? negative : positive) {
+                collection.dispatch_frame_callback(frame);
+            }
+        }
+    });
+
+    double positions[kMotorCount], velocities[kMotorCount], torques[kMotorCount];
+    size_t torn = 0;
+    for (int i = 0; i < 100000; i++) {
+        openarm->get_arm().read_state(positions, velocities, torques, kMotorCount);
+        for (size_t j = 0; j < kMotorCount; j++) {
+            torn += (positions[j] > 0) != (velocities[j] > 0) ||
+                    (positions[j] > 0) != (torques[j] > 0);
+        }
+    }
+    stop.store(true);
+    writer.join();
+    EXPECT_EQ(torn, 0u);
+}
+
+TEST(CommandSlotsTest, RejectsJointsOutOfRange) {
+    auto openarm = make_openarm();
+    CommandSlots slots(*openarm);
+    EXPECT_EQ(slots.size(), kMotorCount);
+    EXPECT_THROW(slots.set_mit(kMotorCount, {}), std::invalid_argument);
+    EXPECT_THROW(slots.set_mit_all(std::vector<MITParam>(2), kMotorCount - 1),
+                 std::invalid_argument);
+    slots.set_posvel_all(std::vector<PosVelParam>(2), kMotorCount - 2);
+    EXPECT_EQ(slots.get_updates(kMotorCount - 1), 1u);
+    EXPECT_EQ(slots.get_updates(0), 0u);
+}
+
+TEST(CommandSlotsTest, GroupWritesReachTheBusTogether) {
+    auto openarm = make_openarm();
+    openarm->enable_all();
+    openarm->recv_all(5000);
+    CommandSlots slots(*openarm);
+
+    // One producer moves every joint to the same position; the simulated joints follow the
+    // MIT command, so their states match as long as each tick carries one group write
+    std::atomic<bool> stop{false};
+    std::thread producer([&] {
+        std::vector<MITParam> mit_params(kMotorCount, MITParam{10.0, 1.0, 0.0, 0.0, 0.0});
+        for (int k = 0; !stop.load(std::memory_order_relaxed); k = (k + 1) % 1000) {
+            for (MITParam& mit_param : mit_params) mit_param.q = 0.001 * k;
+            slots.set_mit_all(mit_params);
+            // A fast teleop rate rather than a busy loop, which would starve the reader
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    });
+
+    openarm::can::socket::CycleConfig config;
+    config.reply_timeout = std::chrono::milliseconds(5);
+    size_t mismatches = 0;
+    for (int i = 0; i < 100; i++) {
+        auto result = slots.cycle(config);
+        EXPECT_TRUE(result.timed_out.empty());
+        double positions[kMotorCount], velocities[kMotorCount], torques[kMotorCount];
+        openarm->get_arm().read_state(positions, velocities, torques, kMotorCount);
+        for (size_t j = 1; j < kMotorCount; j++) mismatches += positions[j] != positions[0];
+    }
+    stop.store(true);
+    producer.join();
+    EXPECT_EQ(mismatches, 0u);
+}
+
+}  // namespace
@@ -0,0 +1,158 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Pipelined parameter queries against simulated motors, and the parameter cache
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <linux/can.h>
+#include <memory>
+#include <openarm/can/socket/openarm.hpp>
+#include <openarm/damiao_motor/dm_motor_control.hpp>
+#include <openarm/damiao_motor/dm_motor_simulator.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace openarm::damiao_motor;
+using openarm::can::socket::OpenArm;
+using openarm::can::socket::ParamLoadResult;
+
+constexpr size_t kMotorCount = 2;
+
+const std::vector<int> kRids = {static_cast<int>(RID::PMAX), static_cast<int>(RID::VMAX),
+                                static_cast<int>(RID::TMAX), static_cast<int>(RID::MST_ID)};
+
+std::unique_ptr<OpenArm> make_openarm(const DMMotorSimulatorConfig& config = {},
+                                      DMMotorSimulator** simulator = nullptr) {
+    auto transport = std::make_unique<DMMotorSimulator>(
+        std::vector<DMSimulatedMotorConfig>{{MotorType::DM4310, 0x01, 0x11},
+                                            {MotorType::DM4310, 0x02, 0x12}},
+        config);
+    if (simulator) *simulator = transport.get();
+    auto openarm = std::make_unique<OpenArm>(std::move(transport));
+    openarm->init_arm_motors({MotorType::DM4310, MotorType::DM4310}, {0x01, 0x02},
+                             {0x11, 0x12});
+    return openarm;
+}
+
+class ParamCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = ::testing::TempDir() + "openarm-can-param-cache-test.cache";
+        std::remove(path_.c_str());
+    }
+    void TearDown() override { std::remove(path_.c_str()); }
+
+    std::string path_;
+};
+
+TEST(ParamQueryTest, LoadParamsAllReadsEveryMotor) {
+    auto openarm = make_openarm();
+    EXPECT_EQ(openarm->load_params_all(kRids), 0u);
+
+    std::vector<Motor> motors = openarm->get_arm().get_motors();
+    ASSERT_EQ(motors.size(), kMotorCount);
+    for (size_t i = 0; i < kMotorCount; i++) {
+        EXPECT_DOUBLE_EQ(motors[i].get_param(static_cast<int>(RID::PMAX)), 12.5);
+        EXPECT_DOUBLE_EQ(motors[i].get_param(static_cast<int>(RID::MST_ID)), 0x11 + i);
+    }
+}
+
+TEST(ParamQueryTest, LostRepliesAreCounted) {
+    DMMotorSimulatorConfig config;
+    config.reply_loss = 1.0;
+    auto openarm = make_openarm(config);
+    EXPECT_EQ(openarm->load_params_all(kRids), kRids.size() * kMotorCount);
+    EXPECT_EQ(openarm->get_arm().get_failed_param_queries().size(), kRids.size() * kMotorCount);
+}
+
+TEST(ParamQueryTest, ReplyCarryingAnotherMotorsIdIsIgnored) {
+    auto openarm = make_openarm();
+    DMCANDevice& device = *openarm->get_arm().get_dm_devices()[0];
+    int pmax = static_cast<int>(RID::PMAX);
+    device.mark_param_query_sent(pmax);
+
+    // Arrives on motor 1's master ID but answers a query of motor 2
+    can_frame frame{};
+    frame.can_id = 0x11;
+    frame.can_dlc = 8;
+    auto data = CanPacketEncoder::pack_param_reply_data(0x02, 0x33, pmax, 7.5);
+    std::copy(data.begin(), data.end(), frame.data);
+    openarm->get_master_can_device_collection().dispatch_frame_callback(frame);
+    EXPECT_TRUE(device.is_param_query_outstanding(pmax));
+    EXPECT_NE(openarm->get_arm().get_motors()[0].get_param(pmax), 7.5);
+
+    data = CanPacketEncoder::pack_param_reply_data(0x01, 0x33, pmax, 7.5);
+    std::copy(data.begin(), data.end(), frame.data);
+    openarm->get_master_can_device_collection().dispatch_frame_callback(frame);
+    EXPECT_FALSE(device.is_param_query_outstanding(pmax));
+    EXPECT_DOUBLE_EQ(openarm->get_arm().get_motors()[0].get_param(pmax), 7.5);
+}
+
+TEST_F(ParamCacheTest, SecondLoadComesFromTheCache) {
+    ParamLoadResult first = make_openarm()->load_params_cached(kRids, path_);
+    EXPECT_EQ(first.queried, kMotorCount);
+    EXPECT_EQ(first.cached, 0u);
+    EXPECT_EQ(first.failed, 0u);
+
+    auto openarm = make_openarm();
+    ParamLoadResult second = openarm->load_params_cached(kRids, path_);
+    EXPECT_EQ(second.queried, 0u);
+    EXPECT_EQ(second.cached, kMotorCount);
+    EXPECT_EQ(second.failed, 0u);
+    EXPECT_DOUBLE_EQ(openarm->get_arm().get_motors()[1].get_param(static_cast<int>(RID::PMAX)),
+                     12.5);
+}
+
+TEST_F(ParamCacheTest, ReplacedMotorIsReadAgain) {
+    make_openarm()->load_params_cached(kRids, path_);
+
+    DMMotorSimulator* simulator = nullptr;
+    auto openarm = make_openarm({}, &simulator);
+    // A different serial number: the cache entry belongs to another motor
+    simulator->set_param(1, static_cast<int>(RID::SN), 4242);
+    ParamLoadResult result = openarm->load_params_cached(kRids, path_);
+    EXPECT_EQ(result.cached, 1u);
+    EXPECT_EQ(result.queried, 1u);
+    EXPECT_EQ(result.failed, 0u);
+}
+
+TEST_F(ParamCacheTest, FailuresAreCountedOnce) {
+    DMMotorSimulatorConfig config;
+    config.reply_loss = 1.0;
+    auto openarm = make_openarm(config);
+    ParamLoadResult result = openarm->load_params_cached(kRids, path_);
+    // Fingerprint (SN, sw_ver) and the full read both fail for every motor
+    EXPECT_EQ(result.failed, (2 + kRids.size()) * kMotorCount);
+    EXPECT_EQ(result.cached, 0u);
+    // Only the full read's failures are left for the caller to inspect
+    EXPECT_EQ(openarm->get_arm().get_failed_param_queries().size(), kRids.size() * kMotorCount);
+}
+
+TEST_F(ParamCacheTest, ApplyingLimitsNeedsTheReceiverStopped) {
+    auto openarm = make_openarm();
+    openarm->start_receiver();
+    EXPECT_THROW(openarm->load_params_cached(kRids, path_), std::logic_error);
+    // Without touching the decode scales the receiver may keep running
+    ParamLoadResult result = openarm->load_params_cached(kRids, path_, false);
+    openarm->stop_receiver();
+    EXPECT_EQ(result.queried, kMotorCount);
+    EXPECT_EQ(result.failed, 0u);
+}
+
+}  // namespace
@@ -0,0 +1,133 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// MIT command and state quantization of every motor type
+
+#include <gtest/gtest.h>
+
+#include <openarm/damiao_motor/dm_motor.hpp>
+#include <openarm/damiao_motor/dm_motor_control.hpp>
+#include <string>
+
+namespace {
+
+using namespace openarm::damiao_motor;
+
+struct MITCodes {
+    uint16_t kp, kd, q, dq, tau;
+};
+
+MITCodes mit_codes(const FixedCANPacket& packet) {
+    const uint8_t* d = packet.data.data();
+    return {static_cast<uint16_t>(((d[3] & 0xF) << 8) | d[4]),
+            static_cast<uint16_t>((d[5] << 4) | (d[6] >> 4)),
+            static_cast<uint16_t>((d[0] << 8) | d[1]),
+            static_cast<uint16_t>((d[2] << 4) | (d[3] >> 4)),
+            static_cast<uint16_t>(((d[6] & 0xF) << 8) | d[7])};
+}
+
+// Codes round to nearest; Damiao's reference float_to_uint() truncates, which differs by one
+// code for every value that is not an exact step
+TEST(MITEncodingTest, EncodesKnownCodes) {
+    Motor motor(MotorType::DM4310, 0x01, 0x11);
+    MITCodes codes =
+        mit_codes(CanPacketEncoder::encode_mit_control_command(motor, {30.0, 1.2, 1.0, 1.0, 0.5}));
+    EXPECT_EQ(codes.kp, 246);    // 245.7, truncated 245
+    EXPECT_EQ(codes.kd, 983);    // 982.8, truncated 982
+    EXPECT_EQ(codes.q, 35389);   // 35388.9, truncated 35388
+    EXPECT_EQ(codes.dq, 2116);   // 2115.75, truncated 2115
+    EXPECT_EQ(codes.tau, 2150);  // 2149.875, truncated 2149
+}
+
+class QuantizationTest : public ::testing::TestWithParam<MotorType> {};
+
+TEST_P(QuantizationTest, FullScaleEncodesToTheTopCode) {
+    Motor motor(GetParam(), 0x01, 0x11);
+    const LimitParam& limits = MOTOR_LIMIT_PARAMS[static_cast<size_t>(GetParam())];
+    MITCodes codes = mit_codes(CanPacketEncoder::encode_mit_control_command(
+        motor, {500.0, 5.0, limits.pMax, limits.vMax, limits.tMax}));
+    EXPECT_EQ(codes.kp, 4095);
+    EXPECT_EQ(codes.kd, 4095);
+    EXPECT_EQ(codes.q, 65535);
+    EXPECT_EQ(codes.dq, 4095);
+    EXPECT_EQ(codes.tau, 4095);
+}
+
+TEST_P(QuantizationTest, MinimumEncodesToZeroAndOutOfRangeClamps) {
+    Motor motor(GetParam(), 0x01, 0x11);
+    const LimitParam& limits = MOTOR_LIMIT_PARAMS[static_cast<size_t>(GetParam())];
+    MITCodes minimum = mit_codes(CanPacketEncoder::encode_mit_control_command(
+        motor, {0.0, 0.0, -limits.pMax, -limits.vMax, -limits.tMax}));
+    EXPECT_EQ(minimum.kp, 0);
+    EXPECT_EQ(minimum.q, 0);
+    EXPECT_EQ(minimum.tau, 0);
+    MITCodes beyond = mit_codes(CanPacketEncoder::encode_mit_control_command(
+        motor, {1e6, -1.0, 2 * limits.pMax, -2 * limits.vMax, 2 * limits.tMax}));
+    EXPECT_EQ(beyond.kp, 4095);
+    EXPECT_EQ(beyond.kd, 0);
+    EXPECT_EQ(beyond.q, 65535);
+    EXPECT_EQ(beyond.dq, 0);
+    EXPECT_EQ(beyond.tau, 4095);
+}
+
+TEST_P(QuantizationTest, RoundTripIsWithinHalfAStep) {
+    Motor motor(GetParam(), 0x01, 0x11);
+    const MITQuantization& quantization = MIT_QUANTIZATION[static_cast<size_t>(GetParam())];
+    for (double fraction : {-0.9, -0.33, 0.0, 0.001, 0.5, 0.77}) {
+        MITParam sent{250.0 * (1 + fraction), 2.5 * (1 + fraction), fraction * quantization.q.max,
+                      fraction * quantization.dq.max, fraction * quantization.tau.max};
+        MITParam received = CanPacketDecoder::parse_mit_control_data(
+            quantization, CanPacketEncoder::encode_mit_control_command(motor, sent).data.data());
+        EXPECT_NEAR(received.kp, sent.kp, quantization.kp.to_double / 2 + 1e-9);
+        EXPECT_NEAR(received.kd, sent.kd, quantization.kd.to_double / 2 + 1e-9);
+        EXPECT_NEAR(received.q, sent.q, quantization.q.to_double / 2 + 1e-9);
+        EXPECT_NEAR(received.dq, sent.dq, quantization.dq.to_double / 2 + 1e-9);
+        EXPECT_NEAR(received.tau, sent.tau, quantization.tau.to_double / 2 + 1e-9);
+    }
+}
+
+TEST_P(QuantizationTest, StateRoundTripIsWithinHalfAStep) {
+    Motor motor(GetParam(), 0x01, 0x11);
+    const MITQuantization& quantization = MIT_QUANTIZATION[static_cast<size_t>(GetParam())];
+    StateResult sent{0.4 * quantization.q.max, -0.7 * quantization.dq.max,
+                     quantization.tau.max, 40, 45, true};
+    auto data = CanPacketEncoder::pack_state_data(quantization, 1, 0x01, sent);
+    StateResult received = CanPacketDecoder::parse_motor_state_data(motor, data.data(), 8);
+    ASSERT_TRUE(received.valid);
+    EXPECT_NEAR(received.position, sent.position, quantization.q.to_double / 2 + 1e-9);
+    EXPECT_NEAR(received.velocity, sent.velocity, quantization.dq.to_double / 2 + 1e-9);
+    EXPECT_NEAR(received.torque, sent.torque, 1e-9);
+    EXPECT_EQ(received.t_mos, 40);
+    EXPECT_EQ(received.t_rotor, 45);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllMotorTypes, QuantizationTest,
+                         ::testing::Values(MotorType::DM3507, MotorType::DM4310,
+                                           MotorType::DM4340, MotorType::DM8009,
+                                           MotorType::DM10010L),
+                         [](const ::testing::TestParamInfo<MotorType>& info) {
+                             return "type" + std::to_string(static_cast<int>(info.param));
+                         });
+
+TEST(MotorLimitsTest, ReadLimitsReplaceTheMapping) {
+    Motor motor(MotorType::DM4310, 0x01, 0x11);
+    motor.set_limits({3.0, 10.0, 4.0});
+    MITCodes codes = mit_codes(
+        CanPacketEncoder::encode_mit_control_command(motor, {0.0, 0.0, 3.0, -10.0, 4.0}));
+    EXPECT_EQ(codes.q, 65535);
+    EXPECT_EQ(codes.dq, 0);
+    EXPECT_EQ(codes.tau, 4095);
+}
+
+}  // namespace
@@ -0,0 +1,91 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The lock-free rings between the control thread and the CAN I/O threads
+
+#include <gtest/gtest.h>
+
+#include <openarm/canbus/spsc_ring.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using openarm::canbus::SPSCRing;
+
+TEST(SPSCRingTest, RoundsCapacityUpToAPowerOfTwo) {
+    EXPECT_EQ(SPSCRing<int>(5).capacity(), 8u);
+    EXPECT_EQ(SPSCRing<int>(8).capacity(), 8u);
+    EXPECT_THROW(SPSCRing<int>(0), std::invalid_argument);
+}
+
+TEST(SPSCRingTest, PopsInPushOrderAndStopsWhenFull) {
+    SPSCRing<int> ring(4);
+    int items[] = {1, 2, 3, 4, 5, 6};
+    EXPECT_EQ(ring.push(items, 6), 4u);
+    EXPECT_FALSE(ring.push(7));
+    EXPECT_EQ(ring.size(), 4u);
+
+    int out[6];
+    ASSERT_EQ(ring.pop(out, 6), 4u);
+    for (int i = 0; i < 4; i++) EXPECT_EQ(out[i], i + 1);
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.pop(out[0]));
+}
+
+TEST(SPSCRingTest, CountsPushedAndPoppedItems) {
+    SPSCRing<int> ring(4);
+    int items[] = {1, 2, 3};
+    int out[3];
+    for (int round = 0; round < 3; round++) {
+        ring.push(items, 3);
+        ring.pop(out, 3);
+    }
+    ring.push(items, 2);
+    // Running totals keep counting across the wrap-around
+    EXPECT_EQ(ring.pushed(), 11u);
+    EXPECT_EQ(ring.popped(), 9u);
+    EXPECT_EQ(ring.size(), 2u);
+}
+
+TEST(SPSCRingTest, TransfersEverythingAcrossThreads) {
+    constexpr uint64_t kCount = 200000;
+    SPSCRing<uint64_t> ring(64);
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < kCount;) {
+            // Yield so the test is quick on a single CPU too
+            if (ring.push(i)) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint64_t expected = 0;
+    bool ordered = true;
+    while (expected < kCount) {
+        uint64_t value;
+        if (!ring.pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered = ordered && value == expected;
+        expected++;
+    }
+    producer.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(ring.empty());
+}
+
+}  // namespace
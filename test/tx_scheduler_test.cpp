@@ -0,0 +1,221 @@
+// Copyright 2025 Enactic, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Priority queue, merging and pacing of the TX scheduler
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <openarm/can/socket/openarm.hpp>
+#include <openarm/canbus/tx_scheduler.hpp>
+#include <openarm/damiao_motor/dm_motor_simulator.hpp>
+#include <vector>
+
+namespace {
+
+using namespace openarm::canbus;
+using namespace openarm::damiao_motor;
+using openarm::can::socket::OpenArm;
+
+TxFrame make_frame(canid_t can_id, uint8_t value) {
+    TxFrame frame{};
+    frame.frame.can_id = can_id;
+    frame.frame.len = 8;
+    frame.frame.data[0] = value;
+    frame.size = CAN_MTU;
+    return frame;
+}
+
+// Damiao enable (0xFC), disable (0xFD), set zero (0xFE) or clear error (0xFB)
+TxFrame make_command_frame(canid_t can_id, uint8_t command) {
+    TxFrame frame = make_frame(can_id, 0xFF);
+    std::fill(frame.frame.data, frame.frame.data + 7, 0xFF);
+    frame.frame.data[7] = command;
+    return frame;
+}
+
+std::vector<TxFrame> pop_all(TxScheduler& scheduler) {
+    std::vector<TxFrame> frames(scheduler.size());
+    frames.resize(scheduler.pop_ready(frames.data(), frames.size(), 0));
+    return frames;
+}
+
+TEST(FrameDurationTest, ClassicFrameAtOneMegabit) {
+    can_frame frame{};
+    frame.can_id = 0x01;
+    frame.can_dlc = 8;
+    // 111 bits before stuffing, worst case 135 with stuff bits
+    int64_t duration_ns = frame_duration_ns(frame, 1000000);
+    EXPECT_GE(duration_ns, 111000);
+    EXPECT_LE(duration_ns, 135000);
+}
+
+TEST(FrameDurationTest, BitRateSwitchShortensTheDataPhase) {
+    TxFrame frame = make_frame(0x01, 0);
+    frame.size = CANFD_MTU;
+    frame.frame.len = 64;
+    int64_t nominal_ns = frame_duration_ns(frame, 1000000, 5000000);
+    frame.frame.flags = CANFD_BRS;
+    EXPECT_LT(frame_duration_ns(frame, 1000000, 5000000), nominal_ns / 3);
+}
+
+TEST(TxSchedulerTest, PopsInArbitrationOrder) {
+    TxScheduler scheduler({});
+    for (canid_t can_id : {0x05, 0x02, 0x07, 0x01}) {
+        ASSERT_TRUE(scheduler.push(make_frame(can_id, 0)));
+    }
+    std::vector<canid_t> order;
+    for (const TxFrame& frame : pop_all(scheduler)) order.push_back(frame.frame.can_id);
+    EXPECT_EQ(order, (std::vector<canid_t>{0x01, 0x02, 0x05, 0x07}));
+}
+
+TEST(TxSchedulerTest, LatestFrameForAnIdWins) {
+    TxScheduler scheduler({});
+    scheduler.push(make_frame(0x01, 1));
+    scheduler.push(make_frame(0x01, 2));
+    ASSERT_EQ(scheduler.size(), 1u);
+    std::vector<TxFrame> frames = pop_all(scheduler);
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].frame.data[0], 2);
+    EXPECT_EQ(scheduler.get_stats().merged, 1u);
+}
+
+TEST(TxSchedulerTest, SharedIdIsNotMerged) {
+    TxScheduler scheduler({});
+    scheduler.push(make_frame(0x7FF, 1));
+    scheduler.push(make_frame(0x7FF, 2));
+    std::vector<TxFrame> frames = pop_all(scheduler);
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0].frame.data[0], 1);
+    EXPECT_EQ(frames[1].frame.data[0], 2);
+}
+
+TEST(TxSchedulerTest, CommandFramesAreNeverMerged) {
+    TxScheduler scheduler({});
+    scheduler.push(make_command_frame(0x01, 0xFD));
+    scheduler.push(make_frame(0x01, 1));
+    scheduler.push(make_frame(0x01, 2));
+    scheduler.push(make_command_frame(0x01, 0xFC));
+    // Merging into the setpoint before the enable would send it ahead of the enable
+    scheduler.push(make_frame(0x01, 3));
+    std::vector<TxFrame> frames = pop_all(scheduler);
+    ASSERT_EQ(frames.size(), 4u);
+    EXPECT_EQ(frames[0].frame.data[7], 0xFD);
+    EXPECT_EQ(frames[1].frame.data[0], 2);
+    EXPECT_EQ(frames[2].frame.data[7], 0xFC);
+    EXPECT_EQ(frames[3].frame.data[0], 3);
+    EXPECT_EQ(scheduler.get_stats().merged, 1u);
+}
+
+TEST(TxSchedulerTest, KeepsWriteOrderWithoutMerging) {
+    TxSchedulerConfig config;
+    config.merge_by_id = false;
+    TxScheduler scheduler(config);
+    for (uint8_t value = 0; value < 4; value++) scheduler.push(make_frame(0x01, value));
+    std::vector<TxFrame> frames = pop_all(scheduler);
+    ASSERT_EQ(frames.size(), 4u);
+    for (uint8_t value = 0; value < 4; value++) EXPECT_EQ(frames[value].frame.data[0], value);
+}
+
+TEST(TxSchedulerTest, RequeuedFramesGoFirstUnlessReplaced) {
+    TxScheduler scheduler({});
+    scheduler.push(make_frame(0x01, 1));
+    scheduler.push(make_frame(0x02, 1));
+    TxFrame popped[2];
+    ASSERT_EQ(scheduler.pop_ready(popped, 2, 0), 2u);
+
+    // A fresh setpoint for 0x01 arrived while the popped frames could not be sent
+    scheduler.push(make_frame(0x01, 2));
+    scheduler.requeue(popped, 2);
+    std::vector<TxFrame> frames = pop_all(scheduler);
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0].frame.can_id, 0x01u);
+    EXPECT_EQ(frames[0].frame.data[0], 2);
+    EXPECT_EQ(frames[1].frame.can_id, 0x02u);
+}
+
+TEST(TxSchedulerTest, RequeuedCommandFramesAreKept) {
+    TxScheduler scheduler({});
+    scheduler.push(make_command_frame(0x01, 0xFC));
+    TxFrame popped;
+    ASSERT_EQ(scheduler.pop_ready(&popped, 1, 0), 1u);
+
+    scheduler.push(make_frame(0x01, 1));
+    scheduler.requeue(&popped, 1);
+    std::vector<TxFrame> frames = pop_all(scheduler);
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0].frame.data[7], 0xFC);
+    EXPECT_EQ(frames[1].frame.data[0], 1);
+}
+
+TEST(TxSchedulerTest, DropsWhenFull) {
+    TxSchedulerConfig config;
+    config.max_queue_size = 2;
+    TxScheduler scheduler(config);
+    EXPECT_TRUE(scheduler.push(make_frame(0x01, 0)));
+    EXPECT_TRUE(scheduler.push(make_frame(0x02, 0)));
+    EXPECT_FALSE(scheduler.push(make_frame(0x03, 0)));
+    // Merging needs no room
+    EXPECT_TRUE(scheduler.push(make_frame(0x02, 1)));
+    EXPECT_EQ(scheduler.get_stats().dropped, 1u);
+    EXPECT_EQ(scheduler.get_stats().max_queue_depth, 2u);
+}
+
+TEST(TxSchedulerTest, PacesToTheBacklog) {
+    TxSchedulerConfig config;
+    config.max_backlog = std::chrono::microseconds(300);
+    TxScheduler scheduler(config);
+    for (canid_t can_id = 1; can_id <= 8; can_id++) scheduler.push(make_frame(can_id, 0));
+
+    TxFrame frames[8];
+    size_t count = scheduler.pop_ready(frames, 8, 0);
+    // Frames of about 130 us, the last one may overshoot the budget
+    EXPECT_GE(count, 2u);
+    EXPECT_LE(count, 4u);
+    scheduler.on_sent(frames, count, 0);
+    EXPECT_GT(scheduler.time_until_ready(0), 0);
+    EXPECT_EQ(scheduler.time_until_ready(1000000), 0);
+}
+
+TEST(TxSchedulerTest, RejectsInvalidConfig) {
+    TxSchedulerConfig config;
+    config.bitrate = 0;
+    EXPECT_THROW(TxScheduler{config}, std::invalid_argument);
+}
+
+TEST(TxSchedulerTest, DisableThenMITSendsBoth) {
+    auto simulator = std::make_unique<DMMotorSimulator>(
+        std::vector<DMSimulatedMotorConfig>{{MotorType::DM4310, 0x01, 0x11}});
+    DMMotorSimulator& motor = *simulator;
+    OpenArm openarm(std::move(simulator));
+    openarm.init_arm_motors({MotorType::DM4310}, {0x01}, {0x11});
+    openarm.enable_tx_scheduler();
+    openarm.enable_all();
+    openarm.recv_all(5000);
+    ASSERT_TRUE(motor.get_motor_state(0).enabled);
+    uint64_t commands = motor.get_motor_state(0).commands;
+
+    // Both frames go to send_can_id 0x01 in one batch
+    openarm.get_can_socket().begin_batch();
+    openarm.disable_all();
+    openarm.get_arm().mit_control_all({MITParam{10.0, 1.0, 0.5, 0.0, 0.0}});
+    openarm.get_can_socket().end_batch();
+    openarm.recv_all(5000);
+
+    EXPECT_EQ(motor.get_motor_state(0).commands, commands + 2);
+    EXPECT_FALSE(motor.get_motor_state(0).enabled);
+}
+
+}  // namespace